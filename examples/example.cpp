@@ -32,6 +32,36 @@ Emulator slaveEmu(
     0x01,0x02,0x03,0x04,0x05,0x06,0x07
 );
 
+// Text log. With -D OW_TRACE=1 Serial carries the binary trace for owx_trace_decode and the
+// text is dropped, so the capture holds nothing but trace records
+#if OW_TRACE
+class NullLog : public Print {
+public:
+    size_t write(uint8_t) override { return 1; }
+};
+NullLog nullLog;
+Print &Log = nullLog;
+#else
+Print &Log = Serial;
+#endif
+
+// Last handler command, printed from loop(): the handler itself runs inside the bus
+// transaction (duty() traces it as OWX_TRACE_HANDLER), where no Serial output fits
+volatile int16_t lastHandlerCommand = -1;
+
+// Live values the master reads by ID with OW_LOW_CMD_READ_VARIABLES (no handler + scratchpad round trip)
+float liveTemperature = 0;
+uint16_t loopCounter = 0;
+
+// Values sent by the master, one callback per type; the type is fixed at compile time
+void onInt8(int8_t value)     { Log.print(F("[DATA RECEIVED] INT8: "));    Log.println(value); }
+void onUInt8(uint8_t value)   { Log.print(F("[DATA RECEIVED] UINT8: "));   Log.println(value); }
+void onInt16(int16_t value)   { Log.print(F("[DATA RECEIVED] INT16: "));   Log.println(value); }
+void onUInt16(uint16_t value) { Log.print(F("[DATA RECEIVED] UINT16: "));  Log.println(value); }
+void onInt32(int32_t value)   { Log.print(F("[DATA RECEIVED] INT32: "));   Log.println(value); }
+void onUInt32(uint32_t value) { Log.print(F("[DATA RECEIVED] UINT32: "));  Log.println(value); }
+void onFloat(float value)     { Log.print(F("[DATA RECEIVED] FLOAT32: ")); Log.println(value, 4); }
+
 
 
 
@@ -40,73 +70,51 @@ void setup() {
     Serial.begin(115200);
     delay(500);
 
-    Serial.println(F("\n=== OWX Slave Emulator FULL DEMO ==="));
+    Log.println(F("\n=== OWX Slave Emulator FULL DEMO ==="));
 
     // Attach emulator to the hub
     hub.attach(slaveEmu);
 
-    Serial.println(F("Slave attached. Waiting for master commands...\n"));
+    Log.println(F("Slave attached. Waiting for master commands...\n"));
     slaveEmu.setCustomHandler(myCustomHandler);
 
+    slaveEmu.bindVariable(0x01, &liveTemperature);
+    slaveEmu.bindVariable(0x02, &loopCounter);
+
+    // Delivered from dispatchPending() in loop(); OW_RECEIVE_INLINE would call them from the
+    // bus transaction itself, which leaves no time for Serial output
+    slaveEmu.onReceive(onInt8);
+    slaveEmu.onReceive(onUInt8);
+    slaveEmu.onReceive(onInt16);
+    slaveEmu.onReceive(onUInt16);
+    slaveEmu.onReceive(onInt32);
+    slaveEmu.onReceive(onUInt32);
+    slaveEmu.onReceive(onFloat);
+
  
 }
 
 void loop() {
     hub.poll();  // MUST be called often!
 
-    // Check if master sent new payload
-    if (slaveEmu.available()) {
-        Emulator::DataType type = slaveEmu.availableType();
-
-        Serial.println(F("[DATA RECEIVED]"));
-
-        switch(type) {
-
-            case Emulator::DATA_INT8:
-                Serial.print(F(" INT8: "));
-                Serial.println(slaveEmu.getInt8());
-                break;
-
-            case Emulator::DATA_UINT8:
-                Serial.print(F(" UINT8: "));
-                Serial.println(slaveEmu.getUInt8());
-                break;
-
-            case Emulator::DATA_INT16:
-                Serial.print(F(" INT16: "));
-                Serial.println(slaveEmu.getInt16());
-                break;
-
-            case Emulator::DATA_UINT16:
-                Serial.print(F(" UINT16: "));
-                Serial.println(slaveEmu.getUInt16());
-                break;
-
-            case Emulator::DATA_INT32:
-                Serial.print(F(" INT32: "));
-                Serial.println(slaveEmu.getInt32());
-                break;
-
-            case Emulator::DATA_UINT32:
-                Serial.print(F(" UINT32: "));
-                Serial.println(slaveEmu.getUInt32());
-                break;
+    // Run split-phase handler commands (OW_HANDLER_COMMAND_ASYNC) outside bus time
+    slaveEmu.processPending();
 
-            case Emulator::DATA_FLOAT32:
-                Serial.print(F(" FLOAT32: "));
-                Serial.println(slaveEmu.getFloat(), 4);
-                break;
+    // Binary trace of the bus path (build with -D OW_TRACE=1), decode on the PC with
+    //   cat /dev/ttyUSB0 > trace.bin && ./build/owx_trace_decode --mhz 80 trace.bin
+    slaveEmu.drainTrace(Serial);
 
-            case Emulator::DATA_STRUCT:
-                Serial.println(F(" STRUCT received"));
-                break;
+    // Bound variables are read by the master as they are, keep them current
+    liveTemperature = 20.0f + random(0, 100) / 100.0f;
+    loopCounter++;
 
-            default:
-                Serial.println(F(" Unknown type"));
-                break;
-        }
+    // Received values go to the onReceive() callbacks registered in setup(), no type switch
+    slaveEmu.dispatchPending();
 
-        slaveEmu.clearAvailable();
+    if (lastHandlerCommand >= 0) {
+        Log.print(F("[CUSTOM HANDLER] Command received: 0x"));
+        Log.println((uint8_t)lastHandlerCommand, HEX);
+        lastHandlerCommand = -1;
     }
 
   
@@ -123,9 +131,9 @@ void loop() {
 
 ****************************************************************/
 
-// Custom handler function for a single condition
+// Custom handler function for a single condition; runs from duty(), so no prints here
 bool myCustomHandler(uint8_t cmd) {
-    Serial.print(F("[CUSTOM HANDLER] Command received: 0x"));
+    lastHandlerCommand = cmd;
     if (cmd == OW_REQUEST_UPDATE) {  
         uint8_t random_uint8 = random(0,255);// Example custom command
         uint16_t random_uint16 = random(0,65535);
@@ -133,7 +141,6 @@ bool myCustomHandler(uint8_t cmd) {
         slaveEmu.writeScratchpad_uint8(random_uint8, 0); // Write value 42 at scratchpad[0]
         slaveEmu.writeScratchpad_uint16(random_uint16, 1); // Write value 12345 at scratchpad[1-2]
         slaveEmu.writeScratchpad_float(random_float, 3); // Write float at scratchpad[3-6]
-        // Serial.printf("Updated data uint8 %d, uint16 %d, float %.2f\n", random_uint8, random_uint16, random_float);
                       
         return true;  // Indicate the command was handled
     }
@@ -0,0 +1,105 @@
+/*
+    OWX data ready host benchmark
+
+    One master cycle over BENCH_SLAVES emulators on the simulated bus, of which only some
+    have something new, done two ways:
+
+        poll-all      MATCH ROM + OW_LOW_CMD_ALARM on every slave
+        search+visit  conditional search 0xEC, then MATCH ROM + OW_LOW_CMD_ALARM on the
+                      slaves it found
+
+    Reported as bus time at standard speed (reset + presence and time slots), which is what
+    limits a real 1-Wire master, not CPU time. Every cycle also checks that the search found
+    exactly the busy slaves and that visiting them cleared their flag.
+
+    Build & run on the host:
+        cmake -S . -B build && cmake --build build && ./build/owx_alarm_bench
+*/
+#include <OWX_Slave_Emulator.h>
+#include <stdio.h>
+#include "bench_util.h"
+
+#define BENCH_SLAVES 24
+#define T_RESET_US   960   // reset low + presence wait, standard speed
+#define T_SLOT_US    65    // one time slot incl. recovery, standard speed
+
+static OneWireHub hub(2);
+static Emulator *slaves[BENCH_SLAVES];
+
+// Bus time of one MATCH ROM transaction that moved tx_len + rx_len bytes after the ROM
+static uint32_t transaction_us(size_t tx_len, size_t rx_len) {
+    return T_RESET_US + (uint32_t)(1 + 8 + tx_len + rx_len) * 8 * T_SLOT_US;
+}
+
+// Reads and clears the flags of one slave; false on a bad reply
+static bool visit(Emulator &emu, uint32_t &bus_us) {
+    const uint8_t tx[2] = { OW_LOW_CMD_ALARM, OW_ALARM_ALL };
+    hub.simTransaction(emu, tx, 2);
+    bus_us += transaction_us(2, hub.simSlaveOutputLen());
+    return hub.simSlaveOutputLen() == 2 && OWXCrc8::compute(hub.simSlaveOutput(), 1) == hub.simSlaveOutput()[1];
+}
+
+static Emulator *find_slave(const uint8_t *rom) {
+    for (uint8_t i = 0; i < BENCH_SLAVES; i++) {
+        if (memcmp(slaves[i]->ID, rom, 8) == 0) return slaves[i];
+    }
+    return nullptr;
+}
+
+// Raises the user alarm on busy slaves spread over the bus
+static void make_busy(uint8_t busy) {
+    for (uint8_t n = 0; n < busy; n++)
+        slaves[(uint32_t)n * BENCH_SLAVES / busy]->raiseAlarm();
+}
+
+static bool nobody_alarmed() {
+    for (uint8_t i = 0; i < BENCH_SLAVES; i++) {
+        if (slaves[i]->alarmed()) return false;
+    }
+    return true;
+}
+
+static bool bench_cycle(uint8_t busy) {
+    bool ok = true;
+
+    make_busy(busy);
+    uint32_t poll_us = 0;
+    for (uint8_t i = 0; i < BENCH_SLAVES; i++)
+        ok &= visit(*slaves[i], poll_us);
+    ok &= nobody_alarmed();
+
+    make_busy(busy);
+    uint8_t roms[BENCH_SLAVES][8];
+    uint8_t found = hub.simSearch(ONEWIRE_CMD_ALARM_SEARCH, roms, BENCH_SLAVES);
+    uint32_t search_us = hub.simSearchResets() * T_RESET_US + hub.simSearchSlots() * T_SLOT_US;
+    uint32_t alarm_us = search_us;
+    for (uint8_t i = 0; i < found; i++) {
+        Emulator *emu = find_slave(roms[i]);
+        ok &= emu != nullptr && emu->alarmed() && visit(*emu, alarm_us);
+    }
+    ok &= found == busy && nobody_alarmed();
+
+    printf("  %2u / %2u busy   %8.2f ms poll-all   %8.2f ms search+visit (search %6.2f ms)  %5.1fx  %s\n",
+           busy, BENCH_SLAVES, poll_us / 1000.0, alarm_us / 1000.0, search_us / 1000.0,
+           (double)poll_us / alarm_us, ok ? "" : "(UNEXPECTED RESULT)");
+    return ok;
+}
+
+int main() {
+    for (uint8_t i = 0; i < BENCH_SLAVES; i++) {
+        slaves[i] = new Emulator(0x3A, i, (uint8_t)(i * 37), 0x5E, 0x00, 0x00, 0x01);
+        hub.attach(*slaves[i]);
+    }
+
+    // Plain search first: every slave must be found once
+    uint8_t roms[BENCH_SLAVES][8];
+    bool ok = hub.simSearch(ONEWIRE_CMD_SEARCH_ROM, roms, BENCH_SLAVES) == BENCH_SLAVES;
+    for (uint8_t i = 0; i < BENCH_SLAVES; i++) ok &= find_slave(roms[i]) != nullptr;
+    printf("Full ROM search, %d slaves: %u resets, %u time slots%s\n", BENCH_SLAVES,
+           (unsigned)hub.simSearchResets(), (unsigned)hub.simSearchSlots(), ok ? "" : " (UNEXPECTED RESULT)");
+
+    printf("One master cycle, bus time at standard speed:\n");
+    const uint8_t busy[] = { 0, 1, 2, 4, 8, 24 };
+    for (uint8_t b : busy) ok &= bench_cycle(b);
+    return ok ? 0 : 1;
+}
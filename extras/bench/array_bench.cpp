@@ -0,0 +1,147 @@
+/*
+    OWX array transfer host benchmark
+
+    Encodes sensor-like sample blocks with OW_ARRAY_RAW and OW_ARRAY_DELTA_VARINT (OWX_Array.h),
+    splits them into OW_CMD_ARRAY_* frames of OW_MAX_PAYLOAD bytes and reports wire bytes,
+    compression ratio and encode / decode cost per element. Every block is also sent through
+    Emulator::duty() on the simulated bus and compared with the original after decoding.
+
+    The traces are generated deterministically and shaped like real sensor output: a room
+    temperature with sensor noise, a 12-bit ADC with mains hum, barometric pressure, relative
+    humidity as float, and a vibrating accelerometer axis as the incompressible case.
+
+    Build & run on the host:
+        cmake -S . -B build && cmake --build build && ./build/owx_array_bench
+*/
+#include <OWX_Slave_Emulator.h>
+#include <stdio.h>
+#include <math.h>
+#include "bench_util.h"
+
+#define BENCH_SAMPLES  256   // one registered buffer (START is one byte)
+#define BENCH_ROUNDS   2000
+#define BENCH_ARRAY_ID 0x01
+#define FRAME_OVERHEAD 8     // SEND_VARIABLE, CMD, LEN, ID, ENC, START, COUNT, CRC8
+#define FRAME_DATA_MAX (OW_MAX_PAYLOAD - 4)
+
+static OneWireHub hub(2);
+static Emulator emu(0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07);
+
+// Small deterministic noise source, the same traces on every run
+static uint32_t noise_state = 12345;
+static int32_t noise(int32_t amplitude) {
+    noise_state = noise_state * 1664525u + 1013904223u;
+    return (int32_t)((noise_state >> 8) % (uint32_t)(2 * amplitude + 1)) - amplitude;
+}
+
+static int16_t trace_temperature[BENCH_SAMPLES];   // centi-degrees C, 1 sample/s
+static int16_t trace_adc[BENCH_SAMPLES];           // 12-bit ADC at 1 kHz, 50 Hz hum
+static int32_t trace_pressure[BENCH_SAMPLES];      // Pa, 1 sample/s
+static float   trace_humidity[BENCH_SAMPLES];      // % RH, 1 sample/s
+static int16_t trace_accel[BENCH_SAMPLES];         // raw accelerometer axis under vibration
+
+static void build_traces() {
+    for (int i = 0; i < BENCH_SAMPLES; i++) {
+        trace_temperature[i] = (int16_t)(2150 + i / 8 + noise(2));
+        trace_adc[i] = (int16_t)(2048 + 30 * sin(2 * M_PI * 50 * i / 1000.0) + noise(3));
+        trace_pressure[i] = 101325 + i / 4 + noise(4);
+        trace_humidity[i] = 45.0f + 0.01f * i + 0.02f * noise(1);
+        trace_accel[i] = (int16_t)(1200 * sin(2 * M_PI * 0.37 * i) + noise(400));
+    }
+}
+
+// Builds one OW_CMD_ARRAY_* frame for elements start.. of src; returns elements it carries
+template <typename T>
+static uint8_t build_frame(const T *src, uint16_t start, uint16_t total, uint8_t encoding, uint8_t *frame, uint8_t &frame_len) {
+    uint8_t data_len;
+    uint16_t left = total - start;
+    uint8_t count = owx_array_encode(src + start, left > 255 ? 255 : (uint8_t)left, encoding,
+                                     &frame[7], FRAME_DATA_MAX, data_len);
+    frame[0] = OW_LOW_CMD_SEND_VARIABLE_;
+    frame[1] = OWXArrayCommand<T>::value;
+    frame[2] = 4 + data_len;
+    frame[3] = BENCH_ARRAY_ID;
+    frame[4] = encoding;
+    frame[5] = (uint8_t)start;
+    frame[6] = count;
+    frame[7 + data_len] = OWXCrc8::compute(&frame[1], 2 + 4 + data_len);
+    frame_len = 8 + data_len;
+    return count;
+}
+
+// Wire bytes of the whole block, split into frames
+template <typename T>
+static uint32_t wire_bytes(const T *src, uint8_t encoding) {
+    uint8_t frame[3 + OW_MAX_PAYLOAD + 1];
+    uint8_t frame_len;
+    uint32_t bytes = 0;
+    for (uint16_t start = 0; start < BENCH_SAMPLES; ) {
+        start += build_frame(src, start, BENCH_SAMPLES, encoding, frame, frame_len);
+        bytes += frame_len;
+    }
+    return bytes;
+}
+
+// Sends the block through duty() and checks the registered buffer afterwards
+template <typename T>
+static bool round_trip(const T *src, uint8_t encoding) {
+    static T dest[BENCH_SAMPLES];
+    uint8_t frame[3 + OW_MAX_PAYLOAD + 1];
+    uint8_t frame_len;
+
+    memset(dest, 0, sizeof(dest));
+    emu.registerArray(BENCH_ARRAY_ID, dest, BENCH_SAMPLES);
+    for (uint16_t start = 0; start < BENCH_SAMPLES; ) {
+        start += build_frame(src, start, BENCH_SAMPLES, encoding, frame, frame_len);
+        hub.simTransaction(emu, frame, frame_len);
+        if (hub.simSlaveOutputLen() != 1 || hub.simSlaveOutput()[0] != OW_CMD_ACK) return false;
+        emu.clearAvailable();
+    }
+    return memcmp(dest, src, sizeof(dest)) == 0;
+}
+
+template <typename T>
+static bool bench_trace(const char *name, const T *src) {
+    static uint8_t encoded[BENCH_SAMPLES * 5];
+    static T decoded[BENCH_SAMPLES];
+    static const T *bench_src;
+    static uint8_t encoded_len;
+    bench_src = src;
+
+    // Codec cost on one frame worth of elements, as the master and the slave see it
+    uint8_t count = owx_array_encode(src, 255, OW_ARRAY_DELTA_VARINT, encoded, FRAME_DATA_MAX, encoded_len);
+    static uint8_t bench_count;
+    bench_count = count;
+
+    double enc = bench_best_of([](uint32_t) {
+        uint8_t len;
+        owx_array_encode(bench_src, bench_count, OW_ARRAY_DELTA_VARINT, encoded, FRAME_DATA_MAX, len);
+    }, BENCH_ROUNDS);
+    double dec = bench_best_of([](uint32_t) {
+        owx_array_decode(encoded, encoded_len, OW_ARRAY_DELTA_VARINT, decoded, bench_count);
+    }, BENCH_ROUNDS);
+
+    uint32_t raw = wire_bytes(src, OW_ARRAY_RAW);
+    uint32_t delta = wire_bytes(src, OW_ARRAY_DELTA_VARINT);
+    bool ok = round_trip(src, OW_ARRAY_RAW) && round_trip(src, OW_ARRAY_DELTA_VARINT);
+
+    printf("  %-22s %6u B raw  %6u B delta  %5.2fx   enc %6.1f  dec %6.1f %s/elem  %s\n",
+           name, (unsigned)raw, (unsigned)delta, (double)raw / delta,
+           enc / count, dec / count, BENCH_UNIT, ok ? "" : "(ROUND TRIP FAILED)");
+    return ok;
+}
+
+int main() {
+    hub.attach(emu);
+    build_traces();
+
+    printf("Array transfers, %d samples per block, %d byte payloads, bytes on the wire incl. framing:\n",
+           BENCH_SAMPLES, OW_MAX_PAYLOAD);
+    bool ok = true;
+    ok &= bench_trace("temperature int16", trace_temperature);
+    ok &= bench_trace("ADC 50 Hz hum int16", trace_adc);
+    ok &= bench_trace("pressure int32", trace_pressure);
+    ok &= bench_trace("humidity float", trace_humidity);
+    ok &= bench_trace("accelerometer int16", trace_accel);
+    return ok ? 0 : 1;
+}
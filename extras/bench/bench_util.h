@@ -0,0 +1,33 @@
+/*
+    Shared helpers for the OWX host benchmarks: a cycle counter (TSC on x86,
+    nanoseconds elsewhere) and a best-of-N timing loop.
+*/
+#pragma once
+#include <stdint.h>
+#include <chrono>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+static inline uint64_t bench_cycles() { return __rdtsc(); }
+#define BENCH_UNIT "cycles"
+#else
+static inline uint64_t bench_cycles() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+#define BENCH_UNIT "ns"
+#endif
+
+// Runs fn() rounds times per pass and returns the best per-call cost over passes
+template <typename Fn>
+static double bench_best_of(Fn fn, uint32_t rounds, uint8_t passes = 5) {
+    uint64_t best = ~0ULL;
+    for (uint8_t pass = 0; pass < passes; pass++) {
+        uint64_t start = bench_cycles();
+        for (uint32_t r = 0; r < rounds; r++)
+            fn(r);
+        uint64_t elapsed = bench_cycles() - start;
+        if (elapsed < best) best = elapsed;
+    }
+    return (double)best / rounds;
+}
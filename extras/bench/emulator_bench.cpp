@@ -0,0 +1,444 @@
+/*
+    OWX Emulator host benchmark
+
+    Drives Emulator::duty() through the simulated OneWireHub (extras/host) and reports the
+    cost of one complete transaction (MATCH ROM + OWX command + reply) for every OW_CMD_*
+    data type, the scratchpad read and the handler command. Each transaction is also
+    checked for the expected reply so the numbers are never taken from a failing path.
+
+    Receive delivery compares how an int16 reaches the application: polled with available() /
+    availableType() / getInt16() / clearAvailable(), with an onReceive() callback run from
+    dispatchPending(), and with an inline callback run from duty().
+
+    Build & run on the host:
+        cmake -S . -B build && cmake --build build && ./build/owx_emulator_bench
+*/
+#include <OWX_Slave_Emulator.h>
+#include <stdio.h>
+#include <vector>
+#include "bench_util.h"
+
+#define BENCH_ROUNDS 20000
+
+static OneWireHub hub(2);
+static Emulator emu(0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07);
+static uint8_t frame[3 + OW_MAX_PAYLOAD + 1];
+static uint8_t frame_len;
+
+// Builds an OW_LOW_CMD_SEND_VARIABLE_ frame the way a master does
+static void build_variable_frame(uint8_t cmd, const void *payload, uint8_t len) {
+    frame[0] = OW_LOW_CMD_SEND_VARIABLE_;
+    frame[1] = cmd;
+    frame[2] = len;
+    memcpy(&frame[3], payload, len);
+    frame[3 + len] = OWXCrc8::compute(&frame[1], 2 + len);
+    frame_len = 4 + len;
+}
+
+struct BenchSetpoints {
+    float low;
+    float high;
+    int16_t offset;
+    uint16_t period;
+};
+static BenchSetpoints bench_setpoints;
+
+static bool bench_handler(uint8_t cmd) {
+    emu.writeScratchpad_uint8(cmd, 0);
+    return true;
+}
+
+// Times the currently built frame and verifies the slave reply
+static bool bench_frame(const char *name, const uint8_t *expect, uint8_t expect_len) {
+    hub.simTransaction(emu, frame, frame_len);
+    bool ok = hub.simSlaveOutputLen() == expect_len &&
+              memcmp(hub.simSlaveOutput(), expect, expect_len) == 0;
+    emu.clearAvailable();
+
+    double cost = bench_best_of([](uint32_t) {
+        hub.simTransaction(emu, frame, frame_len);
+        emu.clearAvailable();
+    }, BENCH_ROUNDS);
+
+    printf("  %-26s %10.1f %s/transaction  %s\n", name, cost, BENCH_UNIT, ok ? "" : "(UNEXPECTED REPLY)");
+    return ok;
+}
+
+static int32_t received_sum;
+static uint32_t received_count;
+static void on_int16(int16_t value) { received_sum += value; received_count++; }
+static void on_float(float value) { received_sum += (int32_t)value; received_count++; }
+
+// The int16 frame of the current round: the value changes so every delivery is checked
+static void build_int16_frame(uint32_t round) {
+    int16_t value = (int16_t)(round & 0x3FFF);
+    build_variable_frame(OW_CMD_INT16, &value, 2);
+}
+
+// What the callbacks must have added up over the 5 passes of bench_best_of()
+static bool delivered_all(uint32_t rounds) {
+    int32_t sum = 0;
+    for (uint32_t r = 0; r < rounds; r++) sum += (int32_t)(r & 0x3FFF);
+    return received_count == 5 * rounds && received_sum == 5 * sum;
+}
+
+// One INT16 transaction plus getting the value to the application, three ways
+static bool bench_receive_delivery() {
+    bool ok = true;
+    printf("Receive delivery (INT16 transaction + value reaches the application):\n");
+
+    received_sum = 0;
+    received_count = 0;
+    double polled = bench_best_of([](uint32_t r) {
+        build_int16_frame(r);
+        hub.simTransaction(emu, frame, frame_len);
+        // The loop() every application had to write before onReceive()
+        while (emu.available()) {
+            switch (emu.availableType()) {
+                case Emulator::DATA_INT16: on_int16(emu.getInt16()); break;
+                case Emulator::DATA_FLOAT32: on_float(emu.getFloat()); break;
+                default: break;
+            }
+            emu.clearAvailable();
+        }
+    }, BENCH_ROUNDS);
+    ok &= delivered_all(BENCH_ROUNDS);
+
+    const uint8_t modes[2] = { OW_RECEIVE_DEFERRED, OW_RECEIVE_INLINE };
+    double cost[2];
+    for (uint8_t m = 0; m < 2; m++) {
+        emu.onReceive(on_int16, modes[m]);
+        emu.onReceive(on_float, modes[m]);
+        received_sum = 0;
+        received_count = 0;
+        cost[m] = bench_best_of([](uint32_t r) {
+            build_int16_frame(r);
+            hub.simTransaction(emu, frame, frame_len);
+            emu.dispatchPending();
+        }, BENCH_ROUNDS);
+        ok &= delivered_all(BENCH_ROUNDS) && emu.pending() == 0;
+    }
+
+    // Inline entries of a batch take no queue slot: accepted with the queue full
+    const uint8_t fill = 0x7F;
+    build_variable_frame(OW_CMD_UINT8, &fill, 1);
+    for (uint8_t i = 0; i < OW_RX_QUEUE_SIZE; i++) hub.simTransaction(emu, frame, frame_len);
+    uint8_t batch[2 * 4];
+    for (uint8_t i = 0; i < 2; i++) {
+        int16_t value = 1000 + i;
+        batch[i * 4] = OW_CMD_INT16;
+        batch[i * 4 + 1] = 2;
+        memcpy(&batch[i * 4 + 2], &value, 2);
+    }
+    build_variable_frame(OW_CMD_BATCH, batch, sizeof(batch));
+    received_sum = 0;
+    hub.simTransaction(emu, frame, frame_len);
+    ok &= hub.simSlaveOutputLen() == 1 && hub.simSlaveOutput()[0] == OW_CMD_ACK && received_sum == 2001;
+    while (emu.available()) emu.clearAvailable();
+
+    emu.onReceive<int16_t>(nullptr);
+    emu.onReceive<float>(nullptr);
+
+    printf("  %-26s %10.1f %s/value\n", "polled (type switch)", polled, BENCH_UNIT);
+    printf("  %-26s %10.1f %s/value\n", "deferred (dispatchPending)", cost[0], BENCH_UNIT);
+    printf("  %-26s %10.1f %s/value  %s\n", "inline (from duty())", cost[1], BENCH_UNIT, ok ? "" : "(VALUES LOST)");
+    return ok;
+}
+
+// Statistics read: the counters move on every run, so only the frame shape and CRC are checked
+static bool bench_stats() {
+    frame[0] = OW_LOW_CMD_READ_STATS;
+    frame[1] = 0;
+    frame_len = 2;
+    hub.simTransaction(emu, frame, frame_len);
+    const uint8_t *reply = hub.simSlaveOutput();
+    bool ok = hub.simSlaveOutputLen() == sizeof(OWXStatsBlock) + 2 &&
+              reply[0] == sizeof(OWXStatsBlock) &&
+              OWXCrc8::compute(reply, sizeof(OWXStatsBlock) + 1) == reply[sizeof(OWXStatsBlock) + 1] &&
+              emu.getStats().events[OWX_STAT_CRC_ERRORS] != 0;
+
+    double cost = bench_best_of([](uint32_t) {
+        hub.simTransaction(emu, frame, frame_len);
+    }, BENCH_ROUNDS);
+
+    printf("  %-26s %10.1f %s/transaction  %s\n", "OW_LOW_CMD_READ_STATS", cost, BENCH_UNIT, ok ? "" : "(UNEXPECTED REPLY)");
+    return ok;
+}
+
+#define BENCH_BULK_LEN    4096
+#define BENCH_BULK_WINDOW 8     // chunks per transaction before a STATUS round trip
+
+static uint8_t bulk_src[BENCH_BULK_LEN];
+static uint8_t bulk_dst[BENCH_BULK_LEN];
+static std::vector<uint8_t> bulk_script[BENCH_BULK_LEN / OW_BULK_CHUNK_SIZE / BENCH_BULK_WINDOW + 2];
+
+// Builds the bulk transfer as a list of transactions: BEGIN, windows of CHUNKs + STATUS, END
+static size_t build_bulk_script() {
+    size_t n = 0;
+    uint16_t crc16 = OWXCrc16::compute(bulk_src, BENCH_BULK_LEN);
+    uint8_t begin[6] = { OW_LOW_CMD_BULK_BEGIN, BENCH_BULK_LEN & 0xFF, BENCH_BULK_LEN >> 8,
+                         (uint8_t)(crc16 & 0xFF), (uint8_t)(crc16 >> 8), 0 };
+    begin[5] = OWXCrc8::compute(&begin[1], 4);
+    bulk_script[n++].assign(begin, begin + 6);
+
+    uint16_t chunks = BENCH_BULK_LEN / OW_BULK_CHUNK_SIZE;
+    for (uint16_t first = 0; first < chunks; first += BENCH_BULK_WINDOW) {
+        std::vector<uint8_t> &t = bulk_script[n++];
+        t.clear();
+        for (uint16_t seq = first; seq < first + BENCH_BULK_WINDOW; seq++) {
+            const uint8_t *data = &bulk_src[seq * OW_BULK_CHUNK_SIZE];
+            t.push_back(OW_LOW_CMD_BULK_CHUNK);
+            t.push_back((uint8_t)seq);
+            t.push_back(OW_BULK_CHUNK_SIZE);
+            t.insert(t.end(), data, data + OW_BULK_CHUNK_SIZE);
+            t.push_back(OWXCrc8::compute(&t[t.size() - OW_BULK_CHUNK_SIZE - 2], OW_BULK_CHUNK_SIZE + 2));
+        }
+        t.push_back(OW_LOW_CMD_BULK_STATUS);
+        t.push_back((uint8_t)first);
+        t.push_back(BENCH_BULK_WINDOW);
+    }
+
+    bulk_script[n++].assign(1, OW_LOW_CMD_BULK_END);
+    return n;
+}
+
+// Reassembles a 4 KB transfer and reports CPU cost per KB plus wire overhead
+static bool bench_bulk() {
+    if (OWXCrc16::compute(bulk_src, 255) != OneWireItem::crc16(bulk_src, 255)) {
+        printf("CRC16 mismatch against OneWireItem::crc16\n");
+        return false;
+    }
+
+    size_t transactions = build_bulk_script();
+    size_t wire_bytes = 0;
+    for (size_t i = 0; i < transactions; i++)
+        wire_bytes += 9 + bulk_script[i].size();   // MATCH ROM + ROM + commands
+
+    emu.setBulkBuffer(bulk_dst, sizeof(bulk_dst));
+    bool ok = true;
+    double cost = bench_best_of([&](uint32_t) {
+        emu.clearBulk();
+        for (size_t i = 0; i < transactions; i++)
+            hub.simTransaction(emu, bulk_script[i].data(), bulk_script[i].size());
+        ok &= emu.bulkAvailable() && memcmp(bulk_src, bulk_dst, BENCH_BULK_LEN) == 0;
+    }, 200);
+
+    printf("Bulk transfer %d bytes, %d chunk windows, %u transactions:\n",
+           BENCH_BULK_LEN, BENCH_BULK_WINDOW, (unsigned)transactions);
+    printf("  %-26s %10.1f %s/KB  wire overhead %.1f%%  %s\n", "OW_LOW_CMD_BULK_*",
+           cost * 1024 / BENCH_BULK_LEN, BENCH_UNIT,
+           100.0 * (wire_bytes - BENCH_BULK_LEN) / BENCH_BULK_LEN, ok ? "" : "(TRANSFER FAILED)");
+    return ok;
+}
+
+int main() {
+    for (uint16_t i = 0; i < BENCH_BULK_LEN; i++)
+        bulk_src[i] = (uint8_t)random(256);
+
+    Serial.simMute(true);
+    hub.attach(emu);
+    emu.setCustomHandler(bench_handler);
+
+    const uint8_t ack = OW_CMD_ACK;
+    bool ok = true;
+
+    int8_t v_i8 = -5;            uint8_t v_u8 = 200;
+    int16_t v_i16 = -1234;       uint16_t v_u16 = 54321;
+    int32_t v_i32 = -123456;     uint32_t v_u32 = 3000000000u;
+    float v_f = 21.5f;
+
+    printf("Emulator transactions (MATCH ROM + command + reply), best of 5 x %d:\n", BENCH_ROUNDS);
+
+    build_variable_frame(OW_CMD_INT8, &v_i8, 1);     ok &= bench_frame("OW_CMD_INT8", &ack, 1);
+    build_variable_frame(OW_CMD_UINT8, &v_u8, 1);    ok &= bench_frame("OW_CMD_UINT8", &ack, 1);
+    build_variable_frame(OW_CMD_INT16, &v_i16, 2);   ok &= bench_frame("OW_CMD_INT16", &ack, 1);
+    build_variable_frame(OW_CMD_UINT16, &v_u16, 2);  ok &= bench_frame("OW_CMD_UINT16", &ack, 1);
+    build_variable_frame(OW_CMD_INT32, &v_i32, 4);   ok &= bench_frame("OW_CMD_INT32", &ack, 1);
+    build_variable_frame(OW_CMD_UINT32, &v_u32, 4);  ok &= bench_frame("OW_CMD_UINT32", &ack, 1);
+    build_variable_frame(OW_CMD_FLOAT32, &v_f, 4);   ok &= bench_frame("OW_CMD_FLOAT32", &ack, 1);
+
+    // Struct: ID byte + 12 byte record in one frame
+    uint8_t record[1 + sizeof(BenchSetpoints)] = { 0x01 };
+    BenchSetpoints sp = { 18.0f, 24.5f, -3, 600 };
+    memcpy(&record[1], &sp, sizeof(sp));
+    emu.registerStruct(0x01, &bench_setpoints);
+    build_variable_frame(OW_CMD_STRUCT, record, sizeof(record));
+    ok &= bench_frame("OW_CMD_STRUCT (12 B)", &ack, 1);
+    ok &= memcmp(&bench_setpoints, &sp, sizeof(sp)) == 0;
+
+    // Batch: five float setpoints in one frame instead of five transactions
+    uint8_t batch[5 * 6];
+    for (uint8_t i = 0; i < 5; i++) {
+        float value = 20.0f + i;
+        batch[i * 6] = OW_CMD_FLOAT32;
+        batch[i * 6 + 1] = 4;
+        memcpy(&batch[i * 6 + 2], &value, 4);
+    }
+    build_variable_frame(OW_CMD_BATCH, batch, sizeof(batch));
+    hub.simTransaction(emu, frame, frame_len);
+    ok &= emu.pending() == 5 && emu.getFloat() == 20.0f;
+    while (emu.available()) emu.clearAvailable();
+    {
+        double cost = bench_best_of([](uint32_t) {
+            hub.simTransaction(emu, frame, frame_len);
+            while (emu.available()) emu.clearAvailable();
+        }, BENCH_ROUNDS);
+        printf("  %-26s %10.1f %s/transaction\n", "OW_CMD_BATCH (5 x float)", cost, BENCH_UNIT);
+    }
+
+    // Scratchpad read: the reply is the full scratchpad
+    emu.writeScratchpad_float(v_f, 0);
+    frame[0] = OW_READ_SCRATCHPAD;
+    frame_len = 1;
+    hub.simTransaction(emu, frame, frame_len);
+    ok &= bench_frame("OW_READ_SCRATCHPAD", hub.simSlaveOutput(), OW_SCRATCHPAD_SIZE);
+
+    // Ranged read of the float only
+    uint8_t range_reply[5];
+    memcpy(range_reply, &v_f, 4);
+    frame[0] = OW_READ_SCRATCHPAD_RANGE;
+    frame[1] = 0;
+    frame[2] = 4;
+    frame_len = 3;
+    range_reply[4] = OWXCrc8::compute(range_reply, 4, OWXCrc8::compute(&frame[1], 2));
+    ok &= bench_frame("READ_SCRATCHPAD_RANGE (4)", range_reply, 5);
+
+    // Changed-only read: once the master is in sync, a poll costs one reply byte
+    frame[0] = OW_READ_SCRATCHPAD_CHANGED;
+    frame[1] = 0;
+    frame_len = 2;
+    hub.simTransaction(emu, frame, frame_len);
+    frame[1] = emu.scratchpadGeneration();
+    const uint8_t unchanged = OW_SCRATCHPAD_UNCHANGED;
+    ok &= bench_frame("READ_CHANGED (unchanged)", &unchanged, 1);
+
+    {
+        // All 4 bytes of the float field rewritten and published before every poll
+        static uint8_t sample;
+        double cost = bench_best_of([](uint32_t) {
+            sample++;
+            const uint8_t field[4] = { sample, sample, sample, sample };
+            emu.stageScratchpad(field, 4, 0);
+            emu.publishScratchpad();
+            hub.simTransaction(emu, frame, frame_len);
+            frame[1] = emu.scratchpadGeneration();
+        }, BENCH_ROUNDS);
+        bool changed_ok = hub.simSlaveOutputLen() == 10 && hub.simSlaveOutput()[0] == OW_SCRATCHPAD_CHANGED;
+        ok &= changed_ok;
+        printf("  %-26s %10.1f %s/transaction  %s\n", "READ_CHANGED (1 float)", cost, BENCH_UNIT,
+               changed_ok ? "" : "(UNEXPECTED REPLY)");
+        printf("  reply bytes: full %u, range 5, changed 10, unchanged 1\n", (unsigned)OW_SCRATCHPAD_SIZE);
+    }
+
+    // Read-by-ID: float + struct answered in the same transaction, no handler round trip
+    {
+        static float live_temp = 21.5f;
+        emu.bindVariable(0x10, &live_temp);
+        emu.bindVariable(0x11, &bench_setpoints);
+        uint8_t reply[4 + 4 + 4 + 1 + sizeof(BenchSetpoints)];
+        uint8_t n = 0;
+        reply[n++] = OW_LOW_CMD_SEND_VARIABLE_; reply[n++] = OW_CMD_FLOAT32; reply[n++] = 4;
+        memcpy(&reply[n], &live_temp, 4); n += 4;
+        reply[n] = OWXCrc8::compute(&reply[1], n - 1); n++;
+        uint8_t second = n;
+        reply[n++] = OW_LOW_CMD_SEND_VARIABLE_; reply[n++] = OW_CMD_STRUCT; reply[n++] = 1 + sizeof(BenchSetpoints);
+        reply[n++] = 0x11;
+        memcpy(&reply[n], &bench_setpoints, sizeof(BenchSetpoints)); n += sizeof(BenchSetpoints);
+        reply[n] = OWXCrc8::compute(&reply[second + 1], n - second - 1); n++;
+
+        frame[0] = OW_LOW_CMD_READ_VARIABLES;
+        frame[1] = 2;
+        frame[2] = 0x10;
+        frame[3] = 0x11;
+        frame[4] = OWXCrc8::compute(&frame[1], 3);
+        frame_len = 5;
+        ok &= bench_frame("READ_VARIABLES (float+12B)", reply, n);
+    }
+
+    // Sample FIFO: 16 records per drain; nothing acknowledged, so every poll returns the same block
+    {
+        static OWXSampleFifo<32> fifo;
+        emu.useSampleFifo(fifo);
+        for (uint8_t i = 0; i < 16; i++) emu.pushSample(1, (int16_t)(2000 + i), 1000u * i);
+        frame[0] = OW_LOW_CMD_DRAIN_SAMPLES;
+        frame[1] = 16;
+        frame[2] = 0;
+        frame[3] = 0;
+        frame[4] = OWXCrc8::compute(&frame[1], 3);
+        frame_len = 5;
+        double cost = bench_best_of([](uint32_t) {
+            hub.simTransaction(emu, frame, frame_len);
+        }, BENCH_ROUNDS);
+        const size_t reply_len = 12 + 16 * OWX_SAMPLE_RECORD_SIZE + 1;
+        bool drain_ok = hub.simSlaveOutputLen() == reply_len && hub.simSlaveOutput()[0] == 16 &&
+                        OWXCrc8::compute(hub.simSlaveOutput(), reply_len - 1) == hub.simSlaveOutput()[reply_len - 1];
+        ok &= drain_ok;
+        printf("  %-26s %10.1f %s/transaction  %s\n", "DRAIN_SAMPLES (16)", cost, BENCH_UNIT,
+               drain_ok ? "" : "(UNEXPECTED REPLY)");
+    }
+
+    // Handler command
+    frame[0] = OW_HANDLER_COMMAND;
+    frame[1] = 0x42;
+    frame_len = 2;
+    ok &= bench_frame("OW_HANDLER_COMMAND", &ack, 1);
+
+    // Handler command with 8 registered per-command handlers
+    for (uint8_t cmd = 0x10; cmd < 0x10 + OW_MAX_HANDLERS; cmd++)
+        emu.addHandler(cmd, bench_handler);
+    frame[1] = 0x10 + OW_MAX_HANDLERS - 1;
+    ok &= bench_frame("OW_HANDLER_COMMAND (table)", &ack, 1);
+
+    // Split-phase handler command: accept, run from "loop()", then poll the status
+    const uint8_t accepted = OW_CMD_ACCEPTED;
+    frame[0] = OW_HANDLER_COMMAND_ASYNC;
+    frame[1] = 0x42;
+    frame_len = 2;
+    hub.simTransaction(emu, frame, frame_len);
+    ok &= hub.simSlaveOutputLen() == 1 && hub.simSlaveOutput()[0] == accepted;
+    emu.processPending();
+    {
+        double cost = bench_best_of([](uint32_t) {
+            hub.simTransaction(emu, frame, frame_len);
+            emu.processPending();
+        }, BENCH_ROUNDS);
+        printf("  %-26s %10.1f %s/transaction\n", "OW_HANDLER_COMMAND_ASYNC", cost, BENCH_UNIT);
+    }
+    frame[0] = OW_HANDLER_STATUS;
+    frame_len = 1;
+    uint8_t status[4] = { OW_ASYNC_DONE, 0x42, 0, 0 };
+    status[3] = OWXCrc8::compute(status, 3);
+    ok &= bench_frame("OW_HANDLER_STATUS", status, 4);
+
+    // Rejected frame: bad CRC costs the full receive and is answered with NACK + reason
+    build_variable_frame(OW_CMD_INT32, &v_i32, 4);
+    frame[frame_len - 1] ^= 0xFF;
+    const uint8_t nack_crc[2] = { OW_CMD_NACK, OW_NACK_CRC };
+    ok &= bench_frame("bad CRC (NACK CRC)", nack_crc, 2);
+
+    // Sequenced retry: the first transaction stores the value, every repeat is answered from the cache
+    build_variable_frame(OW_CMD_INT32, &v_i32, 4);
+    memmove(&frame[2], frame, frame_len);
+    frame[0] = OW_LOW_CMD_SEQUENCED;
+    frame[1] = 0x07;
+    frame_len += 2;
+    hub.simTransaction(emu, frame, frame_len);
+    hub.simTransaction(emu, frame, frame_len);
+    ok &= emu.pending() == 1 && hub.simSlaveOutputLen() == 1 && hub.simSlaveOutput()[0] == ack;
+    emu.clearAvailable();
+    ok &= bench_frame("SEQUENCED INT32 (repeat)", &ack, 1);
+
+    // Lost reply recovered with a 2 byte REPLAY instead of the frame
+    frame[0] = OW_LOW_CMD_REPLAY;
+    frame[1] = 0x07;
+    frame_len = 2;
+    ok &= bench_frame("REPLAY (cached ACK)", &ack, 1);
+
+    ok &= bench_stats();
+
+    ok &= bench_receive_delivery();
+
+    ok &= bench_bulk();
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,334 @@
+/*
+    OWX master scheduler host benchmark
+
+    16 emulated slaves with three bound variables each, in three classes:
+
+        A   2 slaves   priority 3   poll every 200 ms   setpoint writes every 500 ms
+        B   6 slaves   priority 2   poll every 1 s      setpoint writes every 2 s
+        C   8 slaves   priority 1   poll every 5 s
+
+    served for BENCH_SECONDS of bus time at standard speed:
+
+        naive      round-robin over the slaves: one READ_VARIABLES per variable, one
+                   SEND_VARIABLE per queued write, back to back
+        scheduler  OWXMaster (extras/master): one READ_VARIABLES per slave when its period is
+                   up, queued writes coalesced into sequenced batch frames, priority + deadline
+        saturated  the scheduler with every period set to 1 µs and one priority for all: the
+                   most polls the bus carries
+        faults     the scheduler with two more slaves at the top priority, both written every
+                   100 ms: one missing from the bus, one that NACKs every value UNKNOWN_TYPE.
+                   Neither may hold the bus: the other slaves must keep at least 90% of the
+                   scheduler's polls, and the refused values must be dropped, not resent.
+
+    Reported: polls per second (a poll = every variable of a slave refreshed), bus busy time,
+    write transactions per value and worst staleness (longest time a slave's values went
+    without a refresh) per class and per slave. Every write must reach its slave exactly once.
+
+    Build & run on the host:
+        cmake -S . -B build && cmake --build build && ./build/owx_master_bench
+*/
+#include <OWX_Slave_Emulator.h>
+#include <OWX_SimMasterBus.h>
+#include <stdio.h>
+
+#define BENCH_SLAVES   16
+#define BENCH_VARS     3
+#define BENCH_SECONDS  30
+
+struct SlaveClass {
+    const char *name;
+    uint8_t first, count;
+    uint8_t priority;
+    uint32_t period_us;
+    uint32_t write_every_us;   // 0: no writes
+};
+
+static const SlaveClass classes[] = {
+    { "A", 0, 2, 3, 200000, 500000 },
+    { "B", 2, 6, 2, 1000000, 2000000 },
+    { "C", 8, 8, 1, 5000000, 0 },
+};
+
+struct SlaveData {
+    float temperature;
+    int16_t setpoint;
+    uint32_t counter;
+};
+
+static OneWireHub hub(2);
+static Emulator *slaves[BENCH_SLAVES];
+static FeatureEmulator<OW_FEATURES_ALL, OW_SCRATCHPAD_SIZE, OW_MAX_PAYLOAD, OW_CMD_FLOAT32, OW_CMD_BATCH> picky(0x3B, 0x40, 0x00, 0x11, 0x00, 0x00, 0x01);
+static const uint8_t missing_rom[8] = { 0x3B, 0x41, 0x00, 0x11, 0x00, 0x00, 0x01, 0x00 };
+static SlaveData data[BENCH_SLAVES];
+static uint32_t received[BENCH_SLAVES];   // values the slave application took from its queue
+
+static const SlaveClass &class_of(uint8_t slave) {
+    for (const SlaveClass &c : classes) {
+        if (slave >= c.first && slave < c.first + c.count) return c;
+    }
+    return classes[0];
+}
+
+// The slaves' loop(): take received values, keep the polled variables moving
+static void slave_loop() {
+    for (uint8_t i = 0; i < BENCH_SLAVES; i++) {
+        while (slaves[i]->available()) {
+            slaves[i]->clearAvailable();
+            received[i]++;
+        }
+        data[i].counter++;
+    }
+}
+
+struct RunResult {
+    uint32_t polls;
+    uint32_t busy_us;
+    uint32_t writes;
+    uint32_t write_frames;
+    uint32_t worst[BENCH_SLAVES];
+    OWXSlaveReport reports[BENCH_SLAVES];   // scheduler only
+};
+
+// Application writes due at time t; calls queue(slave, value) for each
+template <typename Queue>
+static uint32_t app_writes(uint32_t from, uint32_t to, Queue queue) {
+    uint32_t n = 0;
+    for (const SlaveClass &c : classes) {
+        if (c.write_every_us == 0) continue;
+        // Every class member gets three setpoints per interval, members staggered
+        for (uint8_t k = 0; k < c.count; k++) {
+            const uint32_t offset = c.write_every_us / c.count * k;
+            uint32_t first = from <= offset ? 0 : (from - offset + c.write_every_us - 1) / c.write_every_us;
+            for (uint32_t m = first; offset + m * c.write_every_us < to; m++) {
+                for (int16_t v = 0; v < 3; v++) queue(c.first + k, (int16_t)(m * 3 + v));
+                n += 3;
+            }
+        }
+    }
+    return n;
+}
+
+static RunResult run_naive() {
+    OWXSimMasterBus bus(hub);
+    for (uint8_t i = 0; i < BENCH_SLAVES; i++) bus.addItem(*slaves[i]);
+
+    RunResult r = {};
+    std::vector<int16_t> pending[BENCH_SLAVES];
+    uint32_t last_update[BENCH_SLAVES] = {};
+    uint32_t app_time = 0;
+    const uint32_t end = BENCH_SECONDS * 1000000u;
+
+    while (bus.micros() < end) {
+        for (uint8_t s = 0; s < BENCH_SLAVES && bus.micros() < end; s++) {
+            r.writes += app_writes(app_time, bus.micros(), [&](uint8_t slave, int16_t v) { pending[slave].push_back(v); });
+            app_time = bus.micros();
+
+            bool ok = true;
+            for (uint8_t v = 0; v < BENCH_VARS; v++) {
+                uint8_t request[4] = { OW_LOW_CMD_READ_VARIABLES, 1, (uint8_t)(0x10 + v), 0 };
+                request[3] = OWXCrc8::compute(&request[1], 2);
+                uint8_t reply[3 + OW_MAX_PAYLOAD + 1];
+                bus.select(slaves[s]->ID);
+                bus.write(request, 4);
+                bus.read(reply, 3);
+                bus.read(&reply[3], reply[2] + 1);
+                ok &= reply[0] == OW_LOW_CMD_SEND_VARIABLE_ && OWXCrc8::compute(&reply[1], 2 + reply[2]) == reply[3 + reply[2]];
+                slave_loop();
+            }
+            if (ok) {
+                r.polls++;
+                const uint32_t now = bus.micros();
+                if (now - last_update[s] > r.worst[s]) r.worst[s] = now - last_update[s];
+                last_update[s] = now;
+            }
+
+            for (int16_t value : pending[s]) {
+                uint8_t frame[6] = { OW_LOW_CMD_SEND_VARIABLE_, OW_CMD_INT16, 2, (uint8_t)value, (uint8_t)(value >> 8), 0 };
+                frame[5] = OWXCrc8::compute(&frame[1], 4);
+                uint8_t ack;
+                bus.select(slaves[s]->ID);
+                bus.write(frame, 6);
+                bus.read(&ack, 1);
+                r.write_frames++;
+                slave_loop();
+            }
+            pending[s].clear();
+        }
+    }
+    r.busy_us = bus.micros();
+    for (uint8_t s = 0; s < BENCH_SLAVES; s++) {
+        if (bus.micros() - last_update[s] > r.worst[s]) r.worst[s] = bus.micros() - last_update[s];
+        r.writes -= pending[s].size();
+    }
+    return r;
+}
+
+// period_us = 0: the class periods and priorities; otherwise every slave polls that often,
+// all at the same priority (saturation)
+static RunResult run_scheduler(uint32_t period_us) {
+    OWXSimMasterBus bus(hub);
+    OWXMaster m(bus);
+    SlaveData copy[BENCH_SLAVES];
+
+    for (uint8_t i = 0; i < BENCH_SLAVES; i++) {
+        bus.addItem(*slaves[i]);
+        const SlaveClass &c = class_of(i);
+        int8_t idx = period_us ? m.addSlave(slaves[i]->ID, 1, period_us) : m.addSlave(slaves[i]->ID, c.priority, c.period_us);
+        m.pollVariable(idx, 0x10, &copy[i].temperature, sizeof(float));
+        m.pollVariable(idx, 0x11, &copy[i].setpoint, sizeof(int16_t));
+        m.pollVariable(idx, 0x12, &copy[i].counter, sizeof(uint32_t));
+    }
+
+    RunResult r = {};
+    uint32_t app_time = 0;
+    const uint32_t end = BENCH_SECONDS * 1000000u;
+    while (bus.micros() < end) {
+        app_writes(app_time, bus.micros(), [&](uint8_t slave, int16_t v) { r.writes += m.write(slave, v); });
+        app_time = bus.micros();
+
+        const uint32_t before = bus.micros();
+        if (m.service()) {
+            r.busy_us += bus.micros() - before;
+            slave_loop();
+        } else {
+            // Nothing released: the bus idles until the next poll or application write
+            uint32_t wait = m.idleFor();
+            if (wait > 10000) wait = 10000;
+            bus.idle(wait ? wait : 1);
+        }
+    }
+
+    for (uint8_t i = 0; i < BENCH_SLAVES; i++) {
+        OWXSlaveReport rep = m.report(i);
+        r.reports[i] = rep;
+        r.polls += rep.polls;
+        r.write_frames += rep.writeFrames;
+        r.worst[i] = rep.worstStaleness;
+        r.writes -= m.writesPending(i);
+    }
+    return r;
+}
+
+static bool print_run(const char *name, const RunResult &r, uint32_t delivered) {
+    printf("  %-10s %6.1f polls/s  bus busy %5.1f%%  %4u writes in %4u transactions",
+           name, r.polls / (double)BENCH_SECONDS, 100.0 * r.busy_us / (BENCH_SECONDS * 1e6),
+           (unsigned)r.writes, (unsigned)r.write_frames);
+    printf("  worst staleness");
+    for (const SlaveClass &c : classes) {
+        uint32_t worst = 0;
+        for (uint8_t i = c.first; i < c.first + c.count; i++) worst = r.worst[i] > worst ? r.worst[i] : worst;
+        printf(" %s %7.1f ms", c.name, worst / 1000.0);
+    }
+    const bool ok = delivered == r.writes;
+    printf("%s\n", ok ? "" : "  (WRITES LOST OR DUPLICATED)");
+    return ok;
+}
+
+static uint32_t take_received() {
+    uint32_t n = 0;
+    for (uint8_t i = 0; i < BENCH_SLAVES; i++) {
+        n += received[i];
+        received[i] = 0;
+    }
+    return n;
+}
+
+// The class schedule plus a missing slave and one that takes no int16, both at priority 4
+static bool run_faults(const RunResult &sched) {
+    OWXSimMasterBus bus(hub);
+    OWXMaster m(bus);
+    SlaveData copy[BENCH_SLAVES];
+
+    for (uint8_t i = 0; i < BENCH_SLAVES; i++) {
+        bus.addItem(*slaves[i]);
+        const SlaveClass &c = class_of(i);
+        int8_t idx = m.addSlave(slaves[i]->ID, c.priority, c.period_us);
+        m.pollVariable(idx, 0x10, &copy[i].temperature, sizeof(float));
+        m.pollVariable(idx, 0x11, &copy[i].setpoint, sizeof(int16_t));
+        m.pollVariable(idx, 0x12, &copy[i].counter, sizeof(uint32_t));
+    }
+    bus.addItem(picky);
+    const int8_t missing = m.addSlave(missing_rom, 4, 100000);
+    const int8_t refusing = m.addSlave(picky.ID, 4, 100000);
+
+    uint32_t writes = 0, refused_queued = 0, accepted_queued = 0, accepted_taken = 0, polls = 0;
+    uint32_t app_time = 0, next_fault_write = 0, fault_writes = 0;
+    const uint32_t end = BENCH_SECONDS * 1000000u;
+    while (bus.micros() < end) {
+        app_writes(app_time, bus.micros(), [&](uint8_t slave, int16_t v) { writes += m.write(slave, v); });
+        app_time = bus.micros();
+        // The refusing slave takes floats; once a second an int16 it refuses goes out ahead of them
+        if (bus.micros() >= next_fault_write) {
+            m.write(missing, (int16_t)1);
+            if (fault_writes++ % 10 == 0) refused_queued += m.write(refusing, (int16_t)2);
+            for (uint8_t k = 0; k < 3; k++) accepted_queued += m.write(refusing, 20.0f + k);
+            next_fault_write += 100000;
+        }
+
+        if (m.service()) {
+            slave_loop();
+            while (picky.available()) {
+                picky.clearAvailable();
+                accepted_taken++;
+            }
+        } else {
+            uint32_t wait = m.idleFor();
+            if (wait > 10000) wait = 10000;
+            bus.idle(wait ? wait : 1);
+        }
+    }
+
+    for (uint8_t i = 0; i < BENCH_SLAVES; i++) {
+        polls += m.report(i).polls;
+        writes -= m.writesPending(i);
+    }
+    const OWXSlaveReport gone = m.report(missing), nack = m.report(refusing);
+    const uint32_t delivered = take_received();
+    const uint32_t open = m.writesPending(refusing);
+    printf("  %-10s %6.1f polls/s  %4u writes delivered  missing slave: %u failed frames  "
+           "refusing slave: %u of %u values dropped, %.1f values/frame\n",
+           "faults", polls / (double)BENCH_SECONDS, (unsigned)delivered, (unsigned)gone.writeErrors,
+           (unsigned)nack.writesDropped, (unsigned)refused_queued, nack.writes / (double)nack.writeFrames);
+
+    bool ok = delivered == writes && polls * 10 >= sched.polls * 9;
+    ok &= nack.writes == accepted_taken && nack.writesDropped + 1 >= refused_queued;
+    ok &= nack.writes + nack.writesDropped + open == accepted_queued + refused_queued;
+    // 3 floats per frame, plus a split each second: one value per frame means batches never recovered
+    ok &= nack.writes >= 2 * nack.writeFrames;
+    if (!ok) printf("  (FAULTY SLAVES HOLD THE BUS, WRITES LOST OR BATCHES NOT RESTORED)\n");
+    return ok;
+}
+
+int main() {
+    Serial.simMute(true);
+    for (uint8_t i = 0; i < BENCH_SLAVES; i++) {
+        slaves[i] = new Emulator(0x3B, i, (uint8_t)(i * 29), 0x11, 0x00, 0x00, 0x01);
+        slaves[i]->bindVariable(0x10, &data[i].temperature);
+        slaves[i]->bindVariable(0x11, &data[i].setpoint);
+        slaves[i]->bindVariable(0x12, &data[i].counter);
+        data[i].temperature = 20.0f + i;
+        hub.attach(*slaves[i]);
+    }
+    hub.attach(picky);
+
+    printf("%d slaves, %d s of bus time at standard speed:\n", BENCH_SLAVES, BENCH_SECONDS);
+    bool ok = true;
+    RunResult naive = run_naive();
+    ok &= print_run("naive", naive, take_received());
+    RunResult sched = run_scheduler(0);
+    ok &= print_run("scheduler", sched, take_received());
+    RunResult saturated = run_scheduler(1);
+    ok &= print_run("saturated", saturated, take_received());
+    ok &= run_faults(sched);
+
+    printf("Scheduler per slave:\n");
+    printf("  slave  class  prio  period    polls  errors  misses  writes/frames  worst staleness\n");
+    for (uint8_t i = 0; i < BENCH_SLAVES; i++) {
+        const SlaveClass &c = class_of(i);
+        const OWXSlaveReport &rep = sched.reports[i];
+        printf("  %5u  %5s  %4u  %5.0f ms  %5u  %6u  %6u  %6u/%-6u  %10.1f ms\n", i, c.name, c.priority,
+               c.period_us / 1000.0, (unsigned)rep.polls, (unsigned)rep.pollErrors, (unsigned)rep.deadlineMisses,
+               (unsigned)rep.writes, (unsigned)rep.writeFrames, rep.worstStaleness / 1000.0);
+    }
+    return ok ? 0 : 1;
+}
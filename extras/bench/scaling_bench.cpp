@@ -0,0 +1,109 @@
+/*
+    OWX multi-device scaling host benchmark
+
+    1..32 Emulator instances on one hub, each a separate logical device with its own ROM.
+    Reported per device count:
+
+        RAM        per instance and in total (instances, the shared OWXEngine and, if used, the
+                   shared handler table)
+        match      CPU cost of one transaction (MATCH ROM + SEND_VARIABLE INT32 + ACK) to the
+                   device attached last, i.e. the longest ROM match
+        handler    CPU cost of one handler command to the same device; the handler finds its
+                   device with EmulatorBase::serving()
+        search     full SEARCH ROM: CPU cost, and bus time at standard speed
+
+    Built twice: owx_scaling_bench with a handler table per instance (default) and
+    owx_scaling_bench_shared with -D BENCH_SHARED_HANDLERS=1, devices built with
+    OW_FEATURE_SHARED_HANDLERS and one table for all of them.
+
+    Build & run on the host:
+        cmake -S . -B build && cmake --build build && ./build/owx_scaling_bench
+*/
+#include <OWX_Slave_Emulator.h>
+#include <stdio.h>
+#include <vector>
+#include "bench_util.h"
+
+#define BENCH_MAX_DEVICES 32
+#define BENCH_ROUNDS      2000
+#define T_RESET_US        960   // reset low + presence wait, standard speed
+#define T_SLOT_US         65    // one time slot incl. recovery, standard speed
+
+#ifndef BENCH_SHARED_HANDLERS
+#define BENCH_SHARED_HANDLERS 0
+#endif
+
+typedef FeatureEmulator<OW_FEATURES_ALL | (BENCH_SHARED_HANDLERS ? OW_FEATURE_SHARED_HANDLERS : 0)> Device;
+
+static uint8_t handled_by[BENCH_MAX_DEVICES];
+
+// One handler for every device: records which device it ran for in its scratchpad
+static bool bench_handler(uint8_t cmd) {
+    EmulatorBase *device = EmulatorBase::serving();
+    if (device == nullptr) return false;
+    device->writeScratchpad_uint8(cmd, 0);
+    handled_by[device->ID[1]]++;
+    return true;
+}
+
+static bool bench_devices(uint8_t count) {
+    OneWireHub hub(2);
+    Device *devices[BENCH_MAX_DEVICES];
+    bool ok = true;
+
+    for (uint8_t i = 0; i < count; i++) {
+        devices[i] = new Device(0x3A, i, (uint8_t)(i * 37), 0x5E, 0x00, 0x00, 0x02);
+        devices[i]->setCustomHandler(bench_handler);
+        ok &= hub.attach(*devices[i]) != 255;
+    }
+    Device &last = *devices[count - 1];
+
+    int32_t value = -123456;
+    std::vector<uint8_t> frame = { OW_LOW_CMD_SEND_VARIABLE_, OW_CMD_INT32, 4 };
+    frame.insert(frame.end(), (uint8_t *)&value, (uint8_t *)&value + 4);
+    frame.push_back(OWXCrc8::compute(&frame[1], 6));
+
+    double match = bench_best_of([&](uint32_t) {
+        hub.simTransaction(last, frame.data(), frame.size());
+        last.clearAvailable();
+    }, BENCH_ROUNDS);
+    ok &= hub.simSlaveOutputLen() == 1 && hub.simSlaveOutput()[0] == OW_CMD_ACK;
+
+    // Every device once, so a shared handler table is seen to reach the right one
+    const uint8_t handler_cmd[2] = { OW_HANDLER_COMMAND, 0x42 };
+    memset(handled_by, 0, sizeof(handled_by));
+    for (uint8_t i = 0; i < count; i++) {
+        hub.simTransaction(*devices[i], handler_cmd, 2);
+        ok &= hub.simSlaveOutputLen() == 1 && hub.simSlaveOutput()[0] == OW_CMD_ACK && handled_by[i] == 1;
+    }
+    double handler = bench_best_of([&](uint32_t) {
+        hub.simTransaction(last, handler_cmd, 2);
+    }, BENCH_ROUNDS);
+
+    uint8_t roms[BENCH_MAX_DEVICES][8];
+    uint8_t found = 0;
+    double search = bench_best_of([&](uint32_t) {
+        found = hub.simSearch(ONEWIRE_CMD_SEARCH_ROM, roms, BENCH_MAX_DEVICES);
+    }, 20);
+    ok &= found == count;
+    const uint32_t search_us = hub.simSearchResets() * T_RESET_US + hub.simSearchSlots() * T_SLOT_US;
+
+    const size_t ram = count * sizeof(Device) + sizeof(OWXEngine) + (BENCH_SHARED_HANDLERS ? sizeof(OWXHandlerTable) : 0);
+    printf("  %2u  %5u B  %6u B  %8.0f  %8.0f  %10.0f  %8.2f ms  %s\n", count, (unsigned)sizeof(Device),
+           (unsigned)ram, match, handler, search, search_us / 1000.0, ok ? "" : "(UNEXPECTED RESULT)");
+
+    for (uint8_t i = 0; i < count; i++) delete devices[i];
+    return ok;
+}
+
+int main() {
+    printf("Devices on one hub, %s (shared OWXEngine %u B), CPU in %s, best of 5:\n",
+           BENCH_SHARED_HANDLERS ? "one shared handler table" : "handler table per device",
+           (unsigned)sizeof(OWXEngine), BENCH_UNIT);
+    printf("   N  RAM/dev  RAM total     match   handler      search  search bus\n");
+
+    bool ok = true;
+    const uint8_t counts[] = { 1, 2, 4, 8, 16, 32 };
+    for (uint8_t n : counts) ok &= bench_devices(n);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,44 @@
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <thread>
+
+HardwareSerial Serial;
+
+static const std::chrono::steady_clock::time_point host_start = std::chrono::steady_clock::now();
+
+uint32_t millis() {
+    return (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - host_start).count();
+}
+
+uint32_t micros() {
+    return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - host_start).count();
+}
+
+void delay(uint32_t ms) { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+void delayMicroseconds(uint32_t us) { std::this_thread::sleep_for(std::chrono::microseconds(us)); }
+
+long random(long max) { return max > 0 ? rand() % max : 0; }
+long random(long min, long max) { return max > min ? min + rand() % (max - min) : min; }
+void randomSeed(unsigned long seed) { srand((unsigned)seed); }
+
+void HardwareSerial::begin(unsigned long) {}
+
+size_t HardwareSerial::print(const __FlashStringHelper *str) { return print(reinterpret_cast<const char *>(str)); }
+size_t HardwareSerial::print(const char *str) { return muted ? 0 : (size_t)printf("%s", str); }
+size_t HardwareSerial::print(char c) { return muted ? 0 : (size_t)printf("%c", c); }
+size_t HardwareSerial::print(long value, int base) {
+    if (muted) return 0;
+    return (size_t)(base == HEX ? printf("%lX", (unsigned long)value) : printf("%ld", value));
+}
+size_t HardwareSerial::print(unsigned long value, int base) {
+    if (muted) return 0;
+    return (size_t)(base == HEX ? printf("%lX", value) : printf("%lu", value));
+}
+size_t HardwareSerial::print(double value, int digits) { return muted ? 0 : (size_t)printf("%.*f", digits, value); }
+size_t HardwareSerial::println() { return muted ? 0 : (size_t)printf("\n"); }
+size_t HardwareSerial::write(uint8_t b) { return muted ? 0 : fwrite(&b, 1, 1, stdout); }
+size_t HardwareSerial::write(const uint8_t *buf, size_t len) { return muted ? 0 : fwrite(buf, 1, len, stdout); }
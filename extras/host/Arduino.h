@@ -0,0 +1,60 @@
+/*
+    Host stand-in for Arduino.h
+
+    Just enough of the Arduino core for the OWX emulator to build and run on Linux:
+    fixed-width types, F(), PROGMEM, millis()/micros()/delay(), random() and a Serial
+    that writes to stdout. Used only by the host build (see CMakeLists.txt), never on target.
+*/
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+
+class __FlashStringHelper;
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper *>(string_literal))
+
+#define DEC 10
+#define HEX 16
+
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+long random(long max);
+long random(long min, long max);
+void randomSeed(unsigned long seed);
+
+class HardwareSerial
+{
+private:
+    bool muted = false;
+
+public:
+    void begin(unsigned long baud);
+
+    // Host only: drop all output (benchmarks, replay runs)
+    void simMute(bool mute) { muted = mute; }
+
+    size_t print(const __FlashStringHelper *str);
+    size_t print(const char *str);
+    size_t print(char c);
+    size_t print(long value, int base = DEC);
+    size_t print(unsigned long value, int base = DEC);
+    size_t print(int value, int base = DEC) { return print((long)value, base); }
+    size_t print(unsigned int value, int base = DEC) { return print((unsigned long)value, base); }
+    size_t print(double value, int digits = 2);
+
+    size_t println();
+
+    size_t write(uint8_t b);
+    size_t write(const uint8_t *buf, size_t len);
+    template <typename T> size_t println(T value) { size_t n = print(value); return n + println(); }
+    template <typename T> size_t println(T value, int fmt) { size_t n = print(value, fmt); return n + println(); }
+};
+
+extern HardwareSerial Serial;
@@ -0,0 +1,451 @@
+#include <OneWireHub.h>
+#include <chrono>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+OneWireItem::OneWireItem(uint8_t ID1, uint8_t ID2, uint8_t ID3, uint8_t ID4, uint8_t ID5, uint8_t ID6, uint8_t ID7)
+{
+    ID[0] = ID1;
+    ID[1] = ID2;
+    ID[2] = ID3;
+    ID[3] = ID4;
+    ID[4] = ID5;
+    ID[5] = ID6;
+    ID[6] = ID7;
+    ID[7] = crc8(ID, 7);
+}
+
+void OneWireItem::sendID(OneWireHub *hub) const
+{
+    hub->send(ID, 8);
+}
+
+uint8_t OneWireItem::crc8(const uint8_t data[], uint8_t data_size, uint8_t crc_init)
+{
+    uint8_t crc = crc_init;
+    while (data_size--) {
+        uint8_t in = *data++;
+        for (uint8_t i = 0; i < 8; ++i) {
+            uint8_t mix = (crc ^ in) & 0x01;
+            crc >>= 1;
+            if (mix) crc ^= 0x8C;
+            in >>= 1;
+        }
+    }
+    return crc;
+}
+
+uint16_t OneWireItem::crc16(const uint8_t address[], uint8_t len, uint16_t init)
+{
+    uint16_t crc = init;
+    while (len--) {
+        crc ^= *address++;
+        for (uint8_t i = 0; i < 8; ++i)
+            crc = (crc & 0x01) ? (uint16_t)((crc >> 1) ^ 0xA001) : (uint16_t)(crc >> 1);
+    }
+    return crc;
+}
+
+OneWireHub::OneWireHub(uint8_t)
+    : slave_count(0), slave_selected(nullptr), sim_master_pos(0),
+      sim_replay(false), sim_replay_mismatches(0), sim_replay_first_mismatch(-1),
+      _error(Error::NO_ERROR), _error_cmd(0), sim_device_errors(0),
+      sim_search_resets(0), sim_search_slots(0),
+      sim_od_enabled(false), od_mode(false), sim_turnaround_us(0), sim_bus_us(0),
+      sim_in_duty(false), sim_last_was_recv(false), sim_last_op_end(0),
+      sim_max_turnaround(0), sim_max_byte_gap(0), sim_link(nullptr)
+{
+    for (uint8_t i = 0; i < HUB_SLAVE_LIMIT; i++)
+        slave_list[i] = nullptr;
+}
+
+uint8_t OneWireHub::attach(OneWireItem &sensor)
+{
+    if (slave_count >= HUB_SLAVE_LIMIT) return 255;
+
+    for (uint8_t i = 0; i < HUB_SLAVE_LIMIT; i++) {
+        if (slave_list[i] == &sensor) return i;
+    }
+    for (uint8_t i = 0; i < HUB_SLAVE_LIMIT; i++) {
+        if (slave_list[i] == nullptr) {
+            slave_list[i] = &sensor;
+            slave_count++;
+            return i;
+        }
+    }
+    return 255;
+}
+
+bool OneWireHub::detach(const OneWireItem &sensor)
+{
+    for (uint8_t i = 0; i < HUB_SLAVE_LIMIT; i++) {
+        if (slave_list[i] == &sensor) return detach(i);
+    }
+    return false;
+}
+
+bool OneWireHub::detach(uint8_t slot)
+{
+    if (slot >= HUB_SLAVE_LIMIT || slave_list[slot] == nullptr) return false;
+    slave_list[slot] = nullptr;
+    slave_count--;
+    return true;
+}
+
+// Reads the ROM command that follows a reset and selects the addressed item
+bool OneWireHub::recv_rom_command()
+{
+    uint8_t rom_cmd;
+    if (recv(&rom_cmd, 1)) return false;
+
+    slave_selected = nullptr;
+
+    switch (rom_cmd) {
+        case ONEWIRE_CMD_OD_MATCH_ROM:
+            if (!sim_od_enabled) {
+                _error = Error::INCORRECT_ONEWIRE_CMD;
+                return false;
+            }
+            od_mode = true;   // the ROM bytes already go at overdrive speed
+            // fall through
+        case ONEWIRE_CMD_MATCH_ROM: {
+            uint8_t address[8];
+            if (recv(address, 8)) return false;
+            for (uint8_t i = 0; i < HUB_SLAVE_LIMIT; i++) {
+                if (slave_list[i] && memcmp(slave_list[i]->ID, address, 8) == 0) {
+                    slave_selected = slave_list[i];
+                    break;
+                }
+            }
+            break;
+        }
+
+        case ONEWIRE_CMD_OD_SKIP_ROM:
+            if (!sim_od_enabled) {
+                _error = Error::INCORRECT_ONEWIRE_CMD;
+                return false;
+            }
+            od_mode = true;
+            // fall through
+        case ONEWIRE_CMD_SKIP_ROM:
+            for (uint8_t i = 0; i < HUB_SLAVE_LIMIT; i++) {
+                if (slave_list[i]) { slave_selected = slave_list[i]; break; }
+            }
+            break;
+
+        case ONEWIRE_CMD_READ_ROM:
+            for (uint8_t i = 0; i < HUB_SLAVE_LIMIT; i++) {
+                if (slave_list[i]) { slave_list[i]->sendID(this); break; }
+            }
+            return false;
+
+        default:
+            _error = Error::INCORRECT_ONEWIRE_CMD;
+            return false;
+    }
+    return slave_selected != nullptr;
+}
+
+bool OneWireHub::poll()
+{
+    if (sim_link) return poll_link();
+    if (simMasterPending() == 0) return false;
+
+    // Reset + presence pulse
+    clearError();
+    sim_bus_ops.clear();
+    sim_bus_us = od_mode ? ONEWIRE_OD_RESET_US : ONEWIRE_STD_RESET_US;
+    if (slave_count == 0) {
+        _error = Error::NO_DEVICE_ATTACHED;
+        return false;
+    }
+
+    if (recv_rom_command()) run_duty();
+
+    return true;
+}
+
+void OneWireHub::run_duty()
+{
+    sim_max_turnaround = 0;
+    sim_max_byte_gap = 0;
+    sim_last_op_end = 0;
+    sim_last_was_recv = true;   // the ROM command came from the master
+    sim_in_duty = true;
+    slave_selected->duty(this);
+    sim_in_duty = false;
+}
+
+// One transaction from the virtual bus: the other side did reset, presence and the ROM command
+bool OneWireHub::poll_link()
+{
+    uint8_t rom[8];
+    bool overdrive = false;
+    if (!sim_link->select(*this, rom, overdrive)) return false;
+
+    simClear();
+    sim_bus_ops.clear();
+    od_mode = overdrive;
+    sim_bus_us = od_mode ? ONEWIRE_OD_RESET_US : ONEWIRE_STD_RESET_US;
+    slave_selected = nullptr;
+    for (uint8_t i = 0; i < HUB_SLAVE_LIMIT; i++) {
+        if (slave_list[i] && memcmp(slave_list[i]->ID, rom, 8) == 0) {
+            slave_selected = slave_list[i];
+            break;
+        }
+    }
+    if (slave_selected) run_duty();
+    sim_link->done();
+    return true;
+}
+
+uint64_t OneWireHub::simClock()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+void OneWireHub::sim_bus_bytes(size_t bytes)
+{
+    sim_bus_us += (uint32_t)bytes * 8 * (od_mode ? ONEWIRE_OD_SLOT_US : ONEWIRE_STD_SLOT_US);
+}
+
+// Gap since the previous bus operation of this duty() call: item CPU time the master has to allow for
+void OneWireHub::sim_op_begin(bool is_recv)
+{
+    if (!sim_in_duty) return;
+    const uint64_t now = simClock();
+    if (sim_last_op_end) {
+        const uint64_t gap = now - sim_last_op_end;
+        const bool turnaround = sim_last_was_recv && !is_recv;
+        uint64_t &worst = turnaround ? sim_max_turnaround : sim_max_byte_gap;
+        if (gap > worst) worst = gap;
+    }
+    if (sim_last_was_recv && !is_recv) sim_bus_us += sim_turnaround_us;
+    sim_last_was_recv = is_recv;
+}
+
+void OneWireHub::sim_op_end()
+{
+    if (sim_in_duty) sim_last_op_end = simClock();
+}
+
+// One entry per send() / recv(), expanded by simBusLog()
+void OneWireHub::sim_log(uint32_t pos, uint8_t len, uint8_t dir)
+{
+    SimBusOp op = { sim_bus_us, pos, len, dir, (uint16_t)(8 * (od_mode ? ONEWIRE_OD_SLOT_US : ONEWIRE_STD_SLOT_US)) };
+    sim_bus_ops.push_back(op);
+}
+
+// Bytes of each operation at its bus time, one byte time apart
+std::vector<SimBusByte> OneWireHub::simBusLog() const
+{
+    std::vector<SimBusByte> log;
+    for (const SimBusOp &op : sim_bus_ops) {
+        const uint8_t *data = op.dir == SIM_DIR_SLAVE ? &sim_slave_bytes[op.pos] : &sim_master_bytes[op.pos];
+        for (uint8_t i = 0; i < op.len; i++) {
+            SimBusByte b = { op.t_us + (uint32_t)i * op.byte_us, data[i], op.dir };
+            log.push_back(b);
+        }
+    }
+    return log;
+}
+
+// Replay: the item's bytes against the captured ones at the script position
+void OneWireHub::sim_replay_check(const uint8_t *data, uint8_t len, bool from_slave)
+{
+    for (uint8_t i = 0; i < len; i++) {
+        const size_t pos = sim_master_pos + i;
+        bool ok = pos < sim_master_bytes.size();
+        if (ok && sim_replay_dirs[pos] != SIM_DIR_ANY)
+            ok = (sim_replay_dirs[pos] == SIM_DIR_SLAVE) == from_slave;
+        if (ok && from_slave) ok = sim_master_bytes[pos] == data[i];
+        if (!ok) {
+            if (sim_replay_first_mismatch < 0) sim_replay_first_mismatch = (int32_t)pos;
+            sim_replay_mismatches++;
+        }
+    }
+}
+
+bool OneWireHub::send(const uint8_t address[], uint8_t data_length)
+{
+    sim_op_begin(false);
+    if (sim_replay) {
+        sim_replay_check(address, data_length, true);
+        sim_master_pos += data_length;
+        if (sim_master_pos > sim_master_bytes.size()) sim_master_pos = sim_master_bytes.size();
+    }
+    sim_log((uint32_t)sim_slave_bytes.size(), data_length, SIM_DIR_SLAVE);
+    sim_slave_bytes.insert(sim_slave_bytes.end(), address, address + data_length);
+    if (sim_link) sim_link->slaveBytes(address, data_length);
+    sim_bus_bytes(data_length);
+    sim_op_end();
+    return false;
+}
+
+bool OneWireHub::send(const uint8_t address[], uint8_t data_length, uint16_t &crc16)
+{
+    crc16 = OneWireItem::crc16(address, data_length, crc16);
+    return send(address, data_length);
+}
+
+bool OneWireHub::send(uint8_t dataByte)
+{
+    return send(&dataByte, 1);
+}
+
+bool OneWireHub::sendBit(bool value)
+{
+    return send((uint8_t)(value ? 1 : 0));
+}
+
+bool OneWireHub::recv(uint8_t address[], uint8_t data_length)
+{
+    sim_op_begin(true);
+    if (sim_link && simMasterPending() < data_length) {
+        uint8_t more[255];
+        const uint8_t got = sim_link->masterBytes(more, (uint8_t)(data_length - simMasterPending()));
+        sim_master_bytes.insert(sim_master_bytes.end(), more, more + got);
+    }
+    if (simMasterPending() < data_length) {
+        // Master stopped talking: the real hub sees a reset or a timeslot timeout here
+        sim_master_pos = sim_master_bytes.size();
+        _error = Error::READ_TIMESLOT_TIMEOUT;
+        return true;
+    }
+    memcpy(address, &sim_master_bytes[sim_master_pos], data_length);
+    if (sim_replay) sim_replay_check(address, data_length, false);
+    sim_log((uint32_t)sim_master_pos, data_length, SIM_DIR_MASTER);
+    sim_master_pos += data_length;
+    sim_bus_bytes(data_length);
+    sim_op_end();
+    return false;
+}
+
+bool OneWireHub::recv(uint8_t address[], uint8_t data_length, uint16_t &crc16)
+{
+    if (recv(address, data_length)) return true;
+    crc16 = OneWireItem::crc16(address, data_length, crc16);
+    return false;
+}
+
+bool OneWireHub::recvBit()
+{
+    uint8_t value = 0;
+    recv(&value, 1);
+    return value & 0x01;
+}
+
+void OneWireHub::raiseDeviceError(uint8_t cmd)
+{
+    _error = Error::INCORRECT_SLAVE_USAGE;
+    _error_cmd = cmd;
+    sim_device_errors++;
+}
+
+void OneWireHub::simClear()
+{
+    sim_master_bytes.clear();
+    sim_master_pos = 0;
+    sim_slave_bytes.clear();
+    sim_replay = false;
+    sim_replay_dirs.clear();
+    sim_replay_mismatches = 0;
+    sim_replay_first_mismatch = -1;
+    clearError();
+}
+
+void OneWireHub::simReplay(const uint8_t *bytes, const uint8_t *dirs, size_t len)
+{
+    simClear();
+    sim_master_bytes.assign(bytes, bytes + len);
+    sim_replay_dirs.assign(dirs, dirs + len);
+    sim_replay = true;
+}
+
+void OneWireHub::simMasterWrite(const uint8_t *data, size_t len)
+{
+    sim_master_bytes.insert(sim_master_bytes.end(), data, data + len);
+}
+
+bool OneWireHub::simTransaction(const OneWireItem &item, const uint8_t *tx, size_t tx_len)
+{
+    simClear();
+    simMasterWrite(ONEWIRE_CMD_MATCH_ROM);
+    simMasterWrite(item.ID, 8);
+    simMasterWrite(tx, tx_len);
+    return poll() && slave_selected == &item;
+}
+
+bool OneWireHub::simTransactionOverdrive(const OneWireItem &item, const uint8_t *tx, size_t tx_len)
+{
+    simClear();
+    simMasterWrite(ONEWIRE_CMD_OD_MATCH_ROM);
+    simMasterWrite(item.ID, 8);
+    simMasterWrite(tx, tx_len);
+    return poll() && slave_selected == &item;
+}
+
+uint8_t OneWireHub::simSearch(uint8_t rom_cmd, uint8_t roms[][8], uint8_t max)
+{
+    uint8_t rom[8] = { 0 };
+    int last_discrepancy = -1;   // bit where the previous pass took the 0 branch, -1: none left
+    uint8_t found = 0;
+
+    sim_search_resets = 0;
+    sim_search_slots = 0;
+
+    do {
+        // Reset, presence, ROM command
+        sim_search_resets++;
+        sim_search_slots += 8;
+
+        bool active[HUB_SLAVE_LIMIT];
+        uint8_t participants = 0;
+        for (uint8_t i = 0; i < HUB_SLAVE_LIMIT; i++) {
+            active[i] = slave_list[i] && (rom_cmd == ONEWIRE_CMD_SEARCH_ROM || slave_list[i]->alarmed());
+            participants += active[i];
+        }
+        if (participants == 0) {
+            sim_search_slots += 2;   // bit and complement both read 1: nobody there
+            break;
+        }
+
+        int last_zero = -1;
+        for (int bit = 0; bit < 64; bit++) {
+            // Wired-AND of the bit and of its complement over everyone still in the search
+            bool any0 = false, any1 = false;
+            for (uint8_t i = 0; i < HUB_SLAVE_LIMIT; i++) {
+                if (!active[i]) continue;
+                if ((slave_list[i]->ID[bit / 8] >> (bit % 8)) & 1) any1 = true;
+                else any0 = true;
+            }
+            sim_search_slots += 3;   // bit, complement, direction
+
+            bool dir;
+            if (any0 && any1) {
+                if (bit < last_discrepancy) dir = (rom[bit / 8] >> (bit % 8)) & 1;
+                else dir = (bit == last_discrepancy);
+                if (!dir) last_zero = bit;
+            } else {
+                dir = any1;
+            }
+
+            if (dir) rom[bit / 8] |= (uint8_t)(1 << (bit % 8));
+            else rom[bit / 8] &= (uint8_t)~(1 << (bit % 8));
+            for (uint8_t i = 0; i < HUB_SLAVE_LIMIT; i++) {
+                if (active[i] && (((slave_list[i]->ID[bit / 8] >> (bit % 8)) & 1) != dir)) active[i] = false;
+            }
+        }
+
+        memcpy(roms[found++], rom, 8);
+        last_discrepancy = last_zero;
+    } while (last_discrepancy >= 0 && found < max);
+
+    return found;
+}
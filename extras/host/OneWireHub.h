@@ -0,0 +1,222 @@
+/*
+    Host stand-in for OneWireHub: a simulated 1-Wire bus
+
+    Mirrors the byte-level API the OWX emulator uses from the real library (attach, poll,
+    send, recv, raiseDeviceError) so unmodified emulator code builds and runs on Linux.
+    Instead of a GPIO the bus is driven by a script of master bytes:
+
+        hub.simMasterWrite(bytes, len);   // what the master puts on the wire after reset
+        hub.poll();                       // reset/presence, ROM command, then item->duty()
+        hub.simSlaveOutput();             // what the addressed item sent back
+
+    recv() past the end of the script behaves like a bus reset / timeout on the real hub
+    (returns true = error), so truncated transactions can be scripted too.
+
+    ROM searches need the master to react bit by bit, so they are not scripted: simSearch()
+    runs the master's side as well and counts the resets and time slots it took.
+
+    Timing model: every poll() adds up the bus time a real master would spend (reset, 8 time
+    slots per byte at the current speed, its wait before reading a reply), see simBusTimeUs().
+    Overdrive skip / match ROM (0x3C / 0x69) switch the bus to overdrive when enabled with
+    simEnableOverdrive(), like OVERDRIVE_ENABLE in OneWireHub's config; a standard reset
+    (simStandardReset()) switches back. Inside duty() the hub also records how much CPU time
+    the item spends between two bus operations (simMaxTurnaround(), simMaxByteGap()).
+
+    Capture and replay (extras/replay): every byte of the last poll() is logged with its
+    direction and bus time (simBusLog()). simReplay() loads a captured transaction instead of a
+    master script: the item reads the master bytes from it and every byte it sends is compared
+    with the byte captured at that point (simReplayMismatches()).
+
+    Virtual bus (extras/vbus): with simLink() set, poll() waits for the link to address one of
+    the hub's items instead of running a script. recv() then blocks for the master's bytes from
+    the link and send() passes the item's bytes on, so the hub is one slave on a bus shared
+    with other processes.
+*/
+#pragma once
+#include <Arduino.h>
+#include <OneWireItem.h>
+#include <vector>
+
+#ifndef HUB_SLAVE_LIMIT
+#define HUB_SLAVE_LIMIT 32
+#endif
+
+#define ONEWIRE_CMD_READ_ROM     0x33
+#define ONEWIRE_CMD_MATCH_ROM    0x55
+#define ONEWIRE_CMD_SKIP_ROM     0xCC
+#define ONEWIRE_CMD_SEARCH_ROM   0xF0
+#define ONEWIRE_CMD_ALARM_SEARCH 0xEC
+#define ONEWIRE_CMD_OD_SKIP_ROM  0x3C
+#define ONEWIRE_CMD_OD_MATCH_ROM 0x69
+
+// Bus timing of the simulation, µs (DS2431 / DS28E07 datasheet values, reset incl. presence)
+#define ONEWIRE_STD_RESET_US 960
+#define ONEWIRE_STD_SLOT_US  65    // tSLOT 60 + tREC 5
+#define ONEWIRE_OD_RESET_US  118   // tRSTL 70 + tRSTH 48
+#define ONEWIRE_OD_SLOT_US   10    // tSLOT 8 + tREC 2
+
+// Who drove a byte of a captured transaction
+#define SIM_DIR_MASTER 0   // written by the master, read by the item
+#define SIM_DIR_SLAVE  1   // read slots driven by the item
+#define SIM_DIR_ANY    2   // not known (logic analyzer byte decode)
+
+struct SimBusByte {
+    uint32_t t_us;     // bus time since the reset
+    uint8_t value;
+    uint8_t dir;       // SIM_DIR_MASTER / SIM_DIR_SLAVE
+};
+
+class OneWireHub;
+
+// Transport of a hub that serves its items on a bus outside this process, see simLink()
+class SimBusLink
+{
+public:
+    virtual ~SimBusLink() {}
+    // Blocks until the master addresses one of the hub's items (ROM layer done by the other
+    // side); false: no transaction (link closed or wait timed out)
+    virtual bool select(OneWireHub &hub, uint8_t rom[8], bool &overdrive) = 0;
+    // Blocks for len master bytes; returns fewer when the master reset the bus
+    virtual uint8_t masterBytes(uint8_t *data, uint8_t len) = 0;
+    virtual void slaveBytes(const uint8_t *data, uint8_t len) = 0;
+    virtual void done() = 0;   // the item's duty() returned
+};
+
+class OneWireHub
+{
+public:
+    enum class Error : uint8_t {
+        NO_ERROR = 0,
+        READ_TIMESLOT_TIMEOUT,
+        WRITE_TIMESLOT_TIMEOUT,
+        RESET_IN_PROGRESS,
+        INCORRECT_ONEWIRE_CMD,
+        INCORRECT_SLAVE_USAGE,
+        TOO_MANY_SLAVES,
+        NO_DEVICE_ATTACHED
+    };
+
+private:
+    OneWireItem *slave_list[HUB_SLAVE_LIMIT];
+    uint8_t slave_count;
+    OneWireItem *slave_selected;
+
+    std::vector<uint8_t> sim_master_bytes;    // scripted master → slave bytes
+    size_t sim_master_pos;
+    std::vector<uint8_t> sim_slave_bytes;     // captured slave → master bytes
+    struct SimBusOp {
+        uint32_t t_us;
+        uint32_t pos;                         // first byte in sim_master_bytes / sim_slave_bytes
+        uint8_t len;
+        uint8_t dir;
+        uint16_t byte_us;
+    };
+    std::vector<SimBusOp> sim_bus_ops;        // send() / recv() calls of the last poll()
+
+    bool sim_replay;                          // script is a captured transaction, see simReplay()
+    std::vector<uint8_t> sim_replay_dirs;     // SIM_DIR_* per script byte
+    uint32_t sim_replay_mismatches;
+    int32_t sim_replay_first_mismatch;        // script index, -1: none
+    void sim_log(uint32_t pos, uint8_t len, uint8_t dir);
+    void sim_replay_check(const uint8_t *data, uint8_t len, bool from_slave);
+
+    Error _error;
+    uint8_t _error_cmd;
+    uint32_t sim_device_errors;
+    uint32_t sim_search_resets;
+    uint32_t sim_search_slots;
+
+    bool sim_od_enabled;          // hub accepts overdrive ROM commands
+    bool od_mode;                 // bus currently at overdrive speed
+    uint32_t sim_turnaround_us;   // master's wait before the first read slot of a reply
+    uint32_t sim_bus_us;          // bus time of the last poll()
+    bool sim_in_duty;
+    bool sim_last_was_recv;
+    uint64_t sim_last_op_end;
+    uint64_t sim_max_turnaround;  // longest recv → send gap inside duty(), simClock() ticks
+    uint64_t sim_max_byte_gap;    // longest gap between any other two bus operations
+    void sim_bus_bytes(size_t bytes);
+    void sim_op_begin(bool is_recv);
+    void sim_op_end();
+
+    SimBusLink *sim_link;         // virtual bus, nullptr: scripted master
+    bool poll_link();
+
+    bool recv_rom_command();
+    void run_duty();
+
+public:
+    explicit OneWireHub(uint8_t pin);
+
+    uint8_t attach(OneWireItem &sensor);
+    bool detach(const OneWireItem &sensor);
+    bool detach(uint8_t slot);
+
+    // Runs one scripted transaction: reset, ROM command, then duty() of the selected item
+    bool poll();
+
+    bool send(const uint8_t address[], uint8_t data_length = 1);
+    bool send(const uint8_t address[], uint8_t data_length, uint16_t &crc16);
+    bool send(uint8_t dataByte);
+    bool sendBit(bool value);
+
+    bool recv(uint8_t address[], uint8_t data_length = 1);
+    bool recv(uint8_t address[], uint8_t data_length, uint16_t &crc16);
+    bool recvBit();
+
+    void raiseDeviceError(uint8_t cmd);
+    Error getError() const { return _error; }
+    bool hasError() const { return _error != Error::NO_ERROR; }
+    void clearError() { _error = Error::NO_ERROR; _error_cmd = 0; }
+
+    // --- simulation control (host only) ---
+    void simClear();
+    void simMasterWrite(const uint8_t *data, size_t len);
+    void simMasterWrite(uint8_t data) { simMasterWrite(&data, 1); }
+    const uint8_t *simSlaveOutput() const { return sim_slave_bytes.data(); }
+    size_t simSlaveOutputLen() const { return sim_slave_bytes.size(); }
+    size_t simMasterPending() const { return sim_master_bytes.size() - sim_master_pos; }
+    uint32_t simDeviceErrors() const { return sim_device_errors; }
+    uint8_t simLastErrorCmd() const { return _error_cmd; }
+
+    // MATCH ROM transaction against one item: script = 0x55 + ROM + tx, then poll()
+    bool simTransaction(const OneWireItem &item, const uint8_t *tx, size_t tx_len);
+
+    // Complete ROM search (Maxim AN187) with ONEWIRE_CMD_SEARCH_ROM, or ONEWIRE_CMD_ALARM_SEARCH
+    // where only items whose alarmed() is true take part. Returns ROMs found, up to max.
+    uint8_t simSearch(uint8_t rom_cmd, uint8_t roms[][8], uint8_t max);
+    uint32_t simSearchResets() const { return sim_search_resets; }
+    uint32_t simSearchSlots() const { return sim_search_slots; }   // incl. the ROM command bits
+
+    // Overdrive and bus timing
+    void simEnableOverdrive(bool enabled) { sim_od_enabled = enabled; }
+    bool simOverdrive() const { return od_mode; }
+    void simStandardReset() { od_mode = false; }
+    void simSetTurnaroundUs(uint32_t us) { sim_turnaround_us = us; }
+    uint32_t simBusTimeUs() const { return sim_bus_us; }
+
+    // 0x69 + ROM + tx: overdrive match when enabled, otherwise the item never sees tx
+    bool simTransactionOverdrive(const OneWireItem &item, const uint8_t *tx, size_t tx_len);
+
+    // Every byte of the last poll(), ROM command included. Recorded as one entry per send() /
+    // recv() and expanded here, so logging stays out of the measured gaps.
+    std::vector<SimBusByte> simBusLog() const;
+
+    // Loads a captured transaction (ROM command onwards) as the next poll()'s script: recv()
+    // consumes bytes in order, send() consumes as many and compares them. Reading a SIM_DIR_SLAVE
+    // byte or sending where the capture has a SIM_DIR_MASTER one counts as a mismatch too.
+    // Cleared by simClear().
+    void simReplay(const uint8_t *bytes, const uint8_t *dirs, size_t len);
+    uint32_t simReplayMismatches() const { return sim_replay_mismatches; }
+    int32_t simReplayFirstMismatch() const { return sim_replay_first_mismatch; }
+
+    // CPU time the item spent between bus operations during the last poll(), in simClock() ticks
+    uint64_t simMaxTurnaround() const { return sim_max_turnaround; }
+    uint64_t simMaxByteGap() const { return sim_max_byte_gap; }
+    static uint64_t simClock();   // TSC on x86, nanoseconds elsewhere
+
+    // Virtual bus: transactions come from link (nullptr: back to scripts)
+    void simLink(SimBusLink *link) { sim_link = link; }
+    OneWireItem *simItem(uint8_t slot) const { return slot < HUB_SLAVE_LIMIT ? slave_list[slot] : nullptr; }
+    bool simOverdriveEnabled() const { return sim_od_enabled; }
+};
@@ -0,0 +1,29 @@
+/*
+    Host stand-in for OneWireHub's OneWireItem
+
+    Same public surface the OWX emulator uses from the real library: the 7 byte ROM
+    constructor (family code first, CRC8 appended), ID[] and the duty() hook.
+
+    alarmed() is not in upstream OneWireItem: it is the condition a hub with conditional
+    search (0xEC) support has to ask, see OneWireHub::simSearch().
+*/
+#pragma once
+#include <Arduino.h>
+
+class OneWireHub;
+
+class OneWireItem
+{
+public:
+    OneWireItem(uint8_t ID1, uint8_t ID2, uint8_t ID3, uint8_t ID4, uint8_t ID5, uint8_t ID6, uint8_t ID7);
+    virtual ~OneWireItem() = default;
+
+    uint8_t ID[8];
+
+    void sendID(OneWireHub *hub) const;
+    virtual void duty(OneWireHub *hub) = 0;
+    virtual bool alarmed() const { return false; }
+
+    static uint8_t crc8(const uint8_t data[], uint8_t data_size, uint8_t crc_init = 0);
+    static uint16_t crc16(const uint8_t address[], uint8_t len, uint16_t init = 0);
+};
@@ -0,0 +1,257 @@
+#include "OWX_Master.h"
+
+// Wrap-safe "a is at or after b" for the µs clock
+static inline bool owx_reached(uint32_t a, uint32_t b) { return (int32_t)(a - b) >= 0; }
+
+OWXMaster::OWXMaster(OWXMasterBus &bus_) : bus(bus_), slaveCount(0) {}
+
+int8_t OWXMaster::addSlave(const uint8_t *rom, uint8_t priority, uint32_t period_us) {
+    if (slaveCount >= OWX_MASTER_MAX_SLAVES) return -1;
+
+    Slave &s = slaves[slaveCount];
+    memset(&s, 0, sizeof(s));
+    memcpy(s.rom, rom, 8);
+    s.priority = priority;
+    s.period = period_us ? period_us : 1;
+    s.release = bus.micros();
+    s.lastUpdate = s.release;
+    s.batchLimit = OWX_MASTER_MAX_WRITES;
+    return (int8_t)slaveCount++;
+}
+
+bool OWXMaster::pollVariable(uint8_t slave, uint8_t id, void *dest, uint8_t size) {
+    if (slave >= slaveCount || size == 0 || size + 1 > OW_MAX_PAYLOAD) return false;
+    Slave &s = slaves[slave];
+    if (s.varCount >= OWX_MASTER_MAX_VARS) return false;
+
+    s.vars[s.varCount].id = id;
+    s.vars[s.varCount].size = size;
+    s.vars[s.varCount].dest = dest;
+    s.varCount++;
+    return true;
+}
+
+bool OWXMaster::queue_write(uint8_t slave, uint8_t cmd, const void *value, uint8_t len) {
+    if (slave >= slaveCount) return false;
+    Slave &s = slaves[slave];
+    if (s.writeCount >= OWX_MASTER_MAX_WRITES) return false;
+
+    if (s.writeCount == 0) s.writeSince = bus.micros();
+    Write &w = s.writes[(s.writeHead + s.writeCount) % OWX_MASTER_MAX_WRITES];
+    w.cmd = cmd;
+    w.len = len;
+    memcpy(w.value, value, len);
+    s.writeCount++;
+    return true;
+}
+
+uint8_t OWXMaster::writesPending(uint8_t slave) const {
+    return slave < slaveCount ? slaves[slave].writeCount : 0;
+}
+
+bool OWXMaster::service() {
+    const uint32_t now = bus.micros();
+    Slave *best = nullptr;
+    bool best_is_write = false;
+    int32_t best_slack = 0;   // deadline - now
+
+    for (uint8_t i = 0; i < slaveCount; i++) {
+        Slave &s = slaves[i];
+        for (uint8_t kind = 0; kind < 2; kind++) {
+            const bool is_write = kind == 1;
+            int32_t slack;
+            if (is_write) {
+                if (s.writeCount == 0 || !owx_reached(now, s.writeRetryAt)) continue;
+                slack = (int32_t)(s.writeSince + s.period - now);
+            } else {
+                if (s.varCount == 0 || !owx_reached(now, s.release)) continue;
+                slack = (int32_t)(s.release + s.period - now);
+            }
+
+            if (best == nullptr || s.priority > best->priority ||
+                (s.priority == best->priority && slack < best_slack)) {
+                best = &s;
+                best_is_write = is_write;
+                best_slack = slack;
+            }
+        }
+    }
+
+    if (best == nullptr) return false;
+    if (best_is_write) flush_writes(*best, now);
+    else poll(*best, now);
+    return true;
+}
+
+uint32_t OWXMaster::idleFor() {
+    const uint32_t now = bus.micros();
+    uint32_t wait = 0xFFFFFFFF;
+
+    for (uint8_t i = 0; i < slaveCount; i++) {
+        const Slave &s = slaves[i];
+        if (s.varCount) {
+            if (owx_reached(now, s.release)) return 0;
+            if (s.release - now < wait) wait = s.release - now;
+        }
+        if (s.writeCount) {
+            if (owx_reached(now, s.writeRetryAt)) return 0;
+            if (s.writeRetryAt - now < wait) wait = s.writeRetryAt - now;
+        }
+    }
+    return wait;
+}
+
+OWXSlaveReport OWXMaster::report(uint8_t slave) {
+    OWXSlaveReport r = {};
+    if (slave >= slaveCount) return r;
+
+    const Slave &s = slaves[slave];
+    r = s.report;
+    const uint32_t age = bus.micros() - s.lastUpdate;
+    if (s.varCount && age > r.worstStaleness) r.worstStaleness = age;
+    return r;
+}
+
+// One typed frame of a READ_VARIABLES reply: [ 0x01 | CMD | LEN | DATA | CRC8 ]
+bool OWXMaster::read_packet(const Variable &var) {
+    uint8_t header[3];
+    uint8_t data[OW_MAX_PAYLOAD + 1];
+
+    bus.read(header, 3);
+    if (header[0] != OW_LOW_CMD_SEND_VARIABLE_ || header[2] > OW_MAX_PAYLOAD) return false;
+    bus.read(data, header[2] + 1);
+
+    OWXCrc8 crc;
+    crc.update(&header[1], 2);
+    crc.update(data, header[2]);
+    if (crc.value() != data[header[2]]) return false;
+
+    // Structs carry their ID in front of the value
+    const uint8_t skip = header[1] == OW_CMD_STRUCT ? 1 : 0;
+    if (header[1] == OW_CMD_NACK || header[2] != var.size + skip || (skip && data[0] != var.id)) return false;
+    memcpy(var.dest, &data[skip], var.size);
+    return true;
+}
+
+// READ_VARIABLES: every polled variable of the slave in one transaction
+bool OWXMaster::poll(Slave &s, uint32_t now) {
+    if (owx_reached(now, s.release + s.period + 1)) s.report.deadlineMisses++;
+
+    uint8_t request[2 + OWX_MASTER_MAX_VARS + 1];
+    request[0] = OW_LOW_CMD_READ_VARIABLES;
+    request[1] = s.varCount;
+    for (uint8_t i = 0; i < s.varCount; i++) request[2 + i] = s.vars[i].id;
+    request[2 + s.varCount] = OWXCrc8::compute(&request[1], 1 + s.varCount);
+
+    bool ok = bus.select(s.rom);
+    if (ok) {
+        bus.write(request, 3 + s.varCount);
+        // Framing is lost after a bad packet: the rest of the reply can't be trusted
+        for (uint8_t i = 0; ok && i < s.varCount; i++) ok = read_packet(s.vars[i]);
+    }
+
+    if (!ok) {
+        // Retry soon, but don't let a dead slave hold the bus at its priority
+        s.report.pollErrors++;
+        s.release = now + s.period / 8 + 1;
+        return false;
+    }
+
+    const uint32_t done = bus.micros();
+    if (done - s.lastUpdate > s.report.worstStaleness) s.report.worstStaleness = done - s.lastUpdate;
+    s.lastUpdate = done;
+    s.report.polls++;
+    // Keep the period from the release, not from when the bus got to it
+    s.release = owx_reached(now, s.release + s.period) ? now + s.period : s.release + s.period;
+    return true;
+}
+
+// Queued writes as one sequenced frame: plain for one value, OW_CMD_BATCH for several
+bool OWXMaster::flush_writes(Slave &s, uint32_t now) {
+    // A frame whose reply was lost goes out again unchanged; otherwise take what fits
+    uint8_t count = s.inFlight;
+    if (count == 0) {
+        uint8_t used = 0;
+        while (count < s.writeCount && count < s.batchLimit) {
+            const Write &w = s.writes[(s.writeHead + count) % OWX_MASTER_MAX_WRITES];
+            if (used + 2 + w.len > OW_MAX_PAYLOAD) break;
+            used += 2 + w.len;
+            count++;
+        }
+        s.inFlight = count;
+    }
+
+    uint8_t frame[2 + 3 + OW_MAX_PAYLOAD + 1];
+    uint8_t len = 0;
+    frame[len++] = OW_LOW_CMD_SEQUENCED;
+    frame[len++] = s.seq;
+    frame[len++] = OW_LOW_CMD_SEND_VARIABLE_;
+    const uint8_t header = len;
+    if (count == 1) {
+        const Write &w = s.writes[s.writeHead];
+        frame[len++] = w.cmd;
+        frame[len++] = w.len;
+        memcpy(&frame[len], w.value, w.len);
+        len += w.len;
+    } else {
+        frame[len++] = OW_CMD_BATCH;
+        frame[len++] = 0;
+        for (uint8_t i = 0; i < count; i++) {
+            const Write &w = s.writes[(s.writeHead + i) % OWX_MASTER_MAX_WRITES];
+            frame[len++] = w.cmd;
+            frame[len++] = w.len;
+            memcpy(&frame[len], w.value, w.len);
+            len += w.len;
+        }
+        frame[header + 1] = len - header - 2;
+    }
+    frame[len] = OWXCrc8::compute(&frame[header], len - header);
+    len++;
+
+    uint8_t reply[2] = { 0xFF, 0xFF };
+    if (bus.select(s.rom)) {
+        bus.write(frame, len);
+        bus.read(reply, 1);
+        if (reply[0] == OW_CMD_NACK) bus.read(&reply[1], 1);
+    }
+    s.report.writeFrames++;
+
+    if (reply[0] == OW_CMD_ACK) {
+        // writeSince stays: what is left was queued no earlier than the oldest write
+        s.writeHead = (s.writeHead + count) % OWX_MASTER_MAX_WRITES;
+        s.writeCount -= count;
+        s.report.writes += count;
+        s.inFlight = 0;
+        s.seq++;
+        return true;
+    }
+
+    s.report.writeErrors++;
+    if (reply[0] != OW_CMD_NACK) {
+        // No readable reply: same frame, same SEQ next time, but don't let a missing slave hold
+        // the bus at its priority
+        s.writeRetryAt = now + s.period / 8 + 1;
+        return false;
+    }
+
+    // Not executed: new SEQ next time
+    s.inFlight = 0;
+    s.seq++;
+    const bool refused = reply[1] == OW_NACK_UNKNOWN_TYPE || reply[1] == OW_NACK_UNKNOWN_ID || reply[1] == OW_NACK_LENGTH;
+    if (refused && count > 1) {
+        // More values than the slave's receive queue holds, or one of them can never be taken:
+        // send fewer, down to one at a time to find it
+        s.batchLimit = reply[1] == OW_NACK_LENGTH ? count / 2 : 1;
+    } else if (refused) {
+        // Resending won't help and would block the writes behind it. With the value found, the
+        // rest go out in full batches again
+        s.writeHead = (s.writeHead + 1) % OWX_MASTER_MAX_WRITES;
+        s.writeCount--;
+        s.report.writesDropped++;
+        s.batchLimit = OWX_MASTER_MAX_WRITES;
+    } else {
+        // Queue full, CRC, ...: after the slave had time to drain
+        s.writeRetryAt = now + s.period / 8 + 1;
+    }
+    return false;
+}
@@ -0,0 +1,137 @@
+/*
+    OWX reference master: transaction scheduler for many OWX slaves
+
+    The master side of the protocol in OWX_Slave_Emulator.h, written against a minimal bus
+    interface (reset + MATCH ROM, write, read, clock) so the same scheduler runs on a master
+    MCU with a OneWire library and on the host against the simulated hub (OWX_SimMasterBus.h).
+
+    Per slave: a priority, a poll period and the bound variables to poll (bindVariable() IDs on
+    the slave). The scheduler runs one transaction per service() call:
+
+        - a slave's poll is released one period after the previous one started; its deadline is
+          one period after release
+        - queued writes are released at once, with a deadline one period after the oldest
+        - among released work the highest priority wins, ties go to the earliest deadline;
+          under overload the lowest priorities wait, never the highest
+
+    All polled variables of a slave are read with one OW_LOW_CMD_READ_VARIABLES; queued writes
+    are packed into one OW_CMD_BATCH frame (or a plain frame for a single value), and into
+    smaller ones once the slave answers a batch with OW_NACK_LENGTH (more values than its
+    receive queue holds). Writes go out as OW_LOW_CMD_SEQUENCED, so a frame whose ACK was lost
+    is resent with the same SEQ and the slave answers from its reply cache instead of queueing
+    the values twice. Like a failed poll, a write without a reply or answered BUSY is retried
+    after an eighth of the period. A value the slave can never take (OW_NACK_UNKNOWN_TYPE,
+    UNKNOWN_ID, or LENGTH when sent on its own) is dropped and counted in writesDropped, after
+    a refused batch was split to find it; the batches after it are full size again.
+
+    Storage is static (OWX_MASTER_MAX_SLAVES slaves), no heap.
+*/
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include <OWX_Slave_Emulator.h>   // protocol constants, OWXCrc8, OWXScalarCommand
+
+#ifndef OWX_MASTER_MAX_SLAVES
+#define OWX_MASTER_MAX_SLAVES 32
+#endif
+
+#ifndef OWX_MASTER_MAX_WRITES
+#define OWX_MASTER_MAX_WRITES 8   // queued writes per slave
+#endif
+
+#define OWX_MASTER_MAX_VARS OW_MAX_READ_IDS   // polled variables per slave, one request
+
+// What the scheduler needs from a 1-Wire master
+class OWXMasterBus
+{
+public:
+    virtual ~OWXMasterBus() {}
+    virtual bool select(const uint8_t *rom) = 0;              // reset + MATCH ROM, false without presence
+    virtual void write(const uint8_t *data, uint8_t len) = 0;
+    virtual void read(uint8_t *data, uint8_t len) = 0;        // 0xFF where no slave drives the bus
+    virtual uint32_t micros() = 0;
+};
+
+struct OWXSlaveReport {
+    uint32_t polls;            // READ_VARIABLES transactions with every value verified
+    uint32_t pollErrors;       // no presence, NACK, bad CRC8 or framing
+    uint32_t deadlineMisses;   // polls that started after their deadline
+    uint32_t writes;           // values the slave acknowledged
+    uint32_t writeFrames;      // transactions those writes took
+    uint32_t writeErrors;      // NACKed or unreadable write replies
+    uint32_t writesDropped;    // values the slave refused for good, not resent
+    uint32_t worstStaleness;   // µs, longest time the slave's values went without a refresh
+};
+
+class OWXMaster
+{
+private:
+    struct Variable {
+        uint8_t id;
+        uint8_t size;
+        void *dest;
+    };
+
+    struct Write {
+        uint8_t cmd;
+        uint8_t len;
+        uint8_t value[4];
+    };
+
+    struct Slave {
+        uint8_t rom[8];
+        uint8_t priority;
+        uint32_t period;
+        Variable vars[OWX_MASTER_MAX_VARS];
+        uint8_t varCount;
+        uint32_t release;         // next poll may start
+        uint32_t lastUpdate;      // last verified poll (or addSlave())
+        Write writes[OWX_MASTER_MAX_WRITES];
+        uint8_t writeHead;
+        uint8_t writeCount;
+        uint32_t writeSince;      // oldest queued write
+        uint32_t writeRetryAt;    // after a NACK, the slave gets time to drain its queue
+        uint8_t seq;
+        uint8_t inFlight;         // writes in the last unconfirmed frame, resent with the same SEQ
+        uint8_t batchLimit;       // values per frame; lowered when the slave refuses a batch, full again after a drop
+        OWXSlaveReport report;
+    };
+
+    OWXMasterBus &bus;
+    Slave slaves[OWX_MASTER_MAX_SLAVES];
+    uint8_t slaveCount;
+
+    bool queue_write(uint8_t slave, uint8_t cmd, const void *value, uint8_t len);
+    bool poll(Slave &s, uint32_t now);
+    bool flush_writes(Slave &s, uint32_t now);
+    bool read_packet(const Variable &var);
+
+public:
+    explicit OWXMaster(OWXMasterBus &bus);
+
+    // Registers a slave; returns its index, -1 when OWX_MASTER_MAX_SLAVES are registered.
+    // Higher priority wins when not everything fits on the bus.
+    int8_t addSlave(const uint8_t *rom, uint8_t priority, uint32_t period_us);
+
+    // Polls variable id (bound with bindVariable() on the slave) into dest[size] every period.
+    // dest is only written from a reply that passed its CRC8.
+    bool pollVariable(uint8_t slave, uint8_t id, void *dest, uint8_t size);
+
+    // Queues a scalar for the slave's receive queue; false if the write queue is full
+    template <typename T>
+    bool write(uint8_t slave, T value) {
+        static_assert(OWXScalarCommand<T>::value != 0 && sizeof(T) <= 4, "write: value must be a scalar OW_CMD_* type");
+        return queue_write(slave, OWXScalarCommand<T>::value, &value, sizeof(T));
+    }
+
+    // Runs the most urgent released transaction; false when nothing is released
+    bool service();
+
+    // µs until the next poll or write retry is released, 0 if one is released now
+    uint32_t idleFor();
+
+    // Report of a slave; worstStaleness includes the age of its values right now
+    OWXSlaveReport report(uint8_t slave);
+    uint8_t slavesRegistered() const { return slaveCount; }
+    uint8_t writesPending(uint8_t slave) const;
+};
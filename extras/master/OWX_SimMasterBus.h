@@ -0,0 +1,78 @@
+/*
+    OWXMasterBus on the host's simulated hub (extras/host)
+
+    The simulated hub runs a transaction from a complete script of master bytes, so writes after
+    select() are collected and the transaction runs on the first read; later reads are served
+    from what the slave sent, 0xFF beyond it like an idle bus. The clock is bus time: every
+    transaction adds its reset, time slots and turnaround waits (OneWireHub::simBusTimeUs()),
+    and idle() lets the caller account for time the master spends waiting.
+*/
+#pragma once
+#include <OneWireHub.h>
+#include <OneWireItem.h>
+#include <string.h>
+#include <vector>
+#include "OWX_Master.h"
+
+class OWXSimMasterBus : public OWXMasterBus
+{
+private:
+    OneWireHub &hub;
+    std::vector<OneWireItem *> items;
+    OneWireItem *selected;
+    std::vector<uint8_t> tx;
+    size_t rxPos;
+    bool ran;
+    uint32_t clock;
+
+    // Runs the collected script once, before the first read or the next reset
+    void run() {
+        if (ran || selected == nullptr) return;
+        ran = true;
+        hub.simTransaction(*selected, tx.data(), tx.size());
+        clock += hub.simBusTimeUs();
+    }
+
+public:
+    explicit OWXSimMasterBus(OneWireHub &hub_) : hub(hub_), selected(nullptr), rxPos(0), ran(true), clock(0) {}
+
+    // Items the master can select; the hub only knows them by attach slot
+    void addItem(OneWireItem &item) { items.push_back(&item); }
+
+    bool select(const uint8_t *rom) override {
+        run();
+        selected = nullptr;
+        for (OneWireItem *item : items) {
+            if (memcmp(item->ID, rom, 8) == 0) selected = item;
+        }
+        tx.clear();
+        rxPos = 0;
+        ran = selected == nullptr;
+        if (selected == nullptr) clock += ONEWIRE_STD_RESET_US + 9 * 8 * ONEWIRE_STD_SLOT_US;   // no presence
+        return selected != nullptr;
+    }
+
+    void write(const uint8_t *data, uint8_t len) override {
+        tx.insert(tx.end(), data, data + len);
+    }
+
+    void read(uint8_t *data, uint8_t len) override {
+        run();
+        const size_t have = hub.simSlaveOutputLen();
+        for (uint8_t i = 0; i < len; i++, rxPos++) {
+            if (selected && rxPos < have) {
+                data[i] = hub.simSlaveOutput()[rxPos];
+            } else {
+                data[i] = 0xFF;
+                clock += 8 * ONEWIRE_STD_SLOT_US;   // read slots nobody answered
+            }
+        }
+    }
+
+    uint32_t micros() override {
+        run();
+        return clock;
+    }
+
+    void idle(uint32_t us) { clock += us; }
+};
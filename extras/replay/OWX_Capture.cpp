@@ -0,0 +1,359 @@
+#include "OWX_Capture.h"
+#include <ctype.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Nominal wire timing of the VCD export and the decoder's thresholds, µs
+#define VCD_STD_RESET_LOW    480
+#define VCD_OD_RESET_LOW     70
+#define VCD_STD_PRESENCE_GAP 30
+#define VCD_OD_PRESENCE_GAP  3
+#define VCD_STD_PRESENCE_LOW 120
+#define VCD_OD_PRESENCE_LOW  10
+#define VCD_STD_LOW_1        6
+#define VCD_OD_LOW_1         1
+#define VCD_STD_LOW_0        60
+#define VCD_OD_LOW_0         8
+
+#define DECODE_STD_RESET_MIN    400.0
+#define DECODE_OD_RESET_MIN     40.0
+#define DECODE_STD_PRESENCE_MIN 60.0
+#define DECODE_OD_PRESENCE_MIN  7.0
+#define DECODE_STD_BIT0_MIN     15.0   // master samples a read slot 15 µs after the falling edge
+#define DECODE_OD_BIT0_MIN      2.0
+
+static uint32_t byte_time_us(bool overdrive) {
+    return 8 * (overdrive ? ONEWIRE_OD_SLOT_US : ONEWIRE_STD_SLOT_US);
+}
+
+// Overdrive skip / match ROM: the rest of the transaction runs at overdrive speed
+static bool switches_to_overdrive(const OWXCaptureTransaction &t, size_t byte_index) {
+    return byte_index == 0 && (t.bytes[0].value == ONEWIRE_CMD_OD_SKIP_ROM || t.bytes[0].value == ONEWIRE_CMD_OD_MATCH_ROM);
+}
+
+static int hex_digit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    c = (char)tolower((unsigned char)c);
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+bool OWXCapture::fail(const char *path, unsigned long line, const char *what) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), line ? ":%lu: " : ": ", line);
+    lastError = std::string(path) + buf + what;
+    return false;
+}
+
+bool OWXCapture::load(const char *path) {
+    FILE *in = fopen(path, "r");
+    if (in == nullptr) return fail(path, 0, strerror(errno));
+
+    transactions.clear();
+    char line[1024];
+    unsigned long n = 0;
+    bool header = false;
+    const char *error = nullptr;
+
+    while (error == nullptr && fgets(line, sizeof(line), in)) {
+        n++;
+        char *p = line;
+        while (isspace((unsigned char)*p)) p++;
+        if (*p == '\0' || *p == '#') continue;
+
+        if (!header) {
+            if (strncmp(p, "OWXCAP 1", 8) != 0) error = "not an OWXCAP 1 file";
+            header = true;
+            continue;
+        }
+
+        const char kind = *p++;
+        char *end;
+        const unsigned long t = strtoul(p, &end, 10);
+        if (end == p) {
+            error = "missing time";
+            break;
+        }
+        p = end;
+
+        if (kind == 'R') {
+            OWXCaptureTransaction t_new;
+            t_new.t_us = (uint32_t)t;
+            t_new.overdrive = strstr(p, "od") != nullptr;
+            transactions.push_back(t_new);
+            continue;
+        }
+        if (kind != 'M' && kind != 'S' && kind != 'B') {
+            error = "unknown record (R, M, S or B)";
+            break;
+        }
+        if (transactions.empty()) {
+            error = "bytes before the first reset";
+            break;
+        }
+
+        OWXCaptureTransaction &tr = transactions.back();
+        const uint8_t dir = kind == 'M' ? OWX_CAPTURE_MASTER : kind == 'S' ? OWX_CAPTURE_SLAVE : OWX_CAPTURE_BUS;
+        bool od = tr.overdrive || (!tr.bytes.empty() && switches_to_overdrive(tr, 0));
+        uint32_t at = (uint32_t)t;
+
+        int hi = -1;
+        for (; *p && *p != '#'; p++) {
+            if (isspace((unsigned char)*p)) continue;
+            const int v = hex_digit(*p);
+            if (v < 0) {
+                error = "bad hex byte";
+                break;
+            }
+            if (hi < 0) {
+                hi = v;
+                continue;
+            }
+            OWXCaptureByte b = { at, (uint8_t)(hi << 4 | v), dir };
+            tr.bytes.push_back(b);
+            hi = -1;
+            at += byte_time_us(od);
+            // A ROM command line may carry the bytes after an overdrive switch too
+            if (tr.bytes.size() == 1 && switches_to_overdrive(tr, 0)) od = true;
+        }
+        if (error == nullptr && hi >= 0) error = "odd number of hex digits";
+    }
+    fclose(in);
+
+    if (error) return fail(path, n, error);
+    if (!header) return fail(path, 0, "empty file");
+    return true;
+}
+
+bool OWXCapture::save(const char *path) const {
+    FILE *out = fopen(path, "w");
+    if (out == nullptr) return false;
+
+    fprintf(out, "OWXCAP 1\n");
+    for (const OWXCaptureTransaction &t : transactions) {
+        fprintf(out, "R %u %s\n", (unsigned)t.t_us, t.overdrive ? "od" : "std");
+
+        // One line per run of bytes of one direction sent back to back
+        bool overdrive = t.overdrive;
+        size_t in_line = 0;
+        for (size_t i = 0; i < t.bytes.size(); i++) {
+            const OWXCaptureByte &b = t.bytes[i];
+            const bool contiguous = i > 0 && b.dir == t.bytes[i - 1].dir &&
+                                    b.t_us == t.bytes[i - 1].t_us + byte_time_us(overdrive);
+            if (i > 0 && switches_to_overdrive(t, i - 1)) overdrive = true;
+            if (!contiguous || in_line == 16) {
+                if (i > 0) fputc('\n', out);
+                const char kind = b.dir == OWX_CAPTURE_MASTER ? 'M' : b.dir == OWX_CAPTURE_SLAVE ? 'S' : 'B';
+                fprintf(out, "%c %u", kind, (unsigned)b.t_us);
+                in_line = 0;
+            }
+            fprintf(out, " %02X", b.value);
+            in_line++;
+        }
+        if (!t.bytes.empty()) fputc('\n', out);
+    }
+    return fclose(out) == 0;
+}
+
+bool OWXCapture::importCsv(const char *path) {
+    FILE *in = fopen(path, "r");
+    if (in == nullptr) return fail(path, 0, strerror(errno));
+
+    transactions.clear();
+    char line[512];
+    while (fgets(line, sizeof(line), in)) {
+        // First field that is a number: the row's time in seconds
+        char *p = line;
+        double t_s = -1;
+        while (*p) {
+            while (*p == ',' || *p == '"' || isspace((unsigned char)*p)) p++;
+            char *end;
+            const double v = strtod(p, &end);
+            if (end != p && (*end == ',' || *end == '"' || isspace((unsigned char)*end) || *end == '\0')) {
+                t_s = v;
+                break;
+            }
+            while (*p && *p != ',') p++;
+        }
+        if (t_s < 0) continue;
+
+        for (char *c = line; *c; c++) *c = (char)tolower((unsigned char)*c);
+        const uint32_t t_us = (uint32_t)(t_s * 1e6 + 0.5);
+
+        if (strstr(line, "reset")) {
+            OWXCaptureTransaction t;
+            t.t_us = t_us;
+            t.overdrive = strstr(line, "overdrive") != nullptr;
+            transactions.push_back(t);
+            continue;
+        }
+
+        // A byte: 0xNN with exactly two digits
+        const char *hex = strstr(line, "0x");
+        if (hex == nullptr || transactions.empty()) continue;
+        const int hi = hex_digit(hex[2]), lo = hex_digit(hex[3]);
+        if (hi < 0 || lo < 0 || hex_digit(hex[4]) >= 0) continue;
+
+        const uint8_t dir = strstr(line, "read") ? OWX_CAPTURE_SLAVE : strstr(line, "write") ? OWX_CAPTURE_MASTER : OWX_CAPTURE_BUS;
+        OWXCaptureByte b = { t_us, (uint8_t)(hi << 4 | lo), dir };
+        transactions.back().bytes.push_back(b);
+    }
+    fclose(in);
+
+    if (transactions.empty()) return fail(path, 0, "no reset rows found");
+    return true;
+}
+
+// Link layer decoder fed with the low pulses of the DQ line
+struct OWXWireDecoder {
+    std::vector<OWXCaptureTransaction> &out;
+    bool od = false;
+    bool expectPresence = false;
+    uint8_t bits = 0;
+    uint8_t value = 0;
+    double byteStart = 0;
+
+    explicit OWXWireDecoder(std::vector<OWXCaptureTransaction> &out_) : out(out_) {}
+
+    void pulse(double fall_us, double low_us) {
+        const bool std_reset = low_us >= DECODE_STD_RESET_MIN;
+        if (std_reset || (od && low_us >= DECODE_OD_RESET_MIN)) {
+            if (std_reset) od = false;
+            OWXCaptureTransaction t;
+            t.t_us = (uint32_t)(fall_us + 0.5);
+            t.overdrive = od;
+            out.push_back(t);
+            expectPresence = true;
+            bits = 0;
+            value = 0;
+            return;
+        }
+        if (expectPresence) {
+            expectPresence = false;
+            if (low_us >= (od ? DECODE_OD_PRESENCE_MIN : DECODE_STD_PRESENCE_MIN)) return;
+        }
+        if (out.empty()) return;
+
+        if (bits == 0) byteStart = fall_us;
+        if (low_us < (od ? DECODE_OD_BIT0_MIN : DECODE_STD_BIT0_MIN)) value |= (uint8_t)(1 << bits);
+        if (++bits < 8) return;
+
+        OWXCaptureTransaction &t = out.back();
+        OWXCaptureByte b = { (uint32_t)(byteStart + 0.5), value, OWX_CAPTURE_BUS };
+        t.bytes.push_back(b);
+        if (switches_to_overdrive(t, t.bytes.size() - 1)) od = true;
+        bits = 0;
+        value = 0;
+    }
+};
+
+bool OWXCapture::importVcd(const char *path, const char *signal) {
+    FILE *in = fopen(path, "r");
+    if (in == nullptr) return fail(path, 0, strerror(errno));
+
+    transactions.clear();
+    OWXWireDecoder decoder(transactions);
+    double ns_per_tick = 1;
+    std::string id;           // VCD identifier of the DQ signal
+    std::vector<std::string> section;
+    bool in_section = false;
+    double now = 0, fall = 0;
+    int level = 1;            // idle bus is pulled up; x / z count as high
+    char tok[256];
+
+    while (fscanf(in, "%255s", tok) == 1) {
+        if (in_section) {
+            if (strcmp(tok, "$end") != 0) {
+                section.push_back(tok);
+                continue;
+            }
+            in_section = false;
+            if (section[0] == "$timescale" && section.size() >= 2) {
+                std::string ts;
+                for (size_t i = 1; i < section.size(); i++) ts += section[i];
+                char *unit;
+                const double mult = strtod(ts.c_str(), &unit);
+                const char *units[] = { "s", "ms", "us", "ns", "ps", "fs" };
+                const double scale[] = { 1e9, 1e6, 1e3, 1, 1e-3, 1e-6 };
+                for (size_t i = 0; i < 6; i++)
+                    if (strcmp(unit, units[i]) == 0) ns_per_tick = mult * scale[i];
+            } else if (section[0] == "$var" && section.size() >= 5 && section[2] == "1" && id.empty() &&
+                       (signal == nullptr || section[4] == signal)) {
+                id = section[3];
+            }
+            section.clear();
+            continue;
+        }
+
+        if (tok[0] == '$') {
+            // $dumpvars / $dumpall / ... hold value changes, everything else is a header section
+            if (strcmp(tok, "$dumpvars") == 0 || strcmp(tok, "$dumpall") == 0 || strcmp(tok, "$dumpon") == 0 ||
+                strcmp(tok, "$dumpoff") == 0 || strcmp(tok, "$end") == 0)
+                continue;
+            section.assign(1, tok);
+            in_section = true;
+        } else if (tok[0] == '#') {
+            now = strtod(tok + 1, nullptr) * ns_per_tick;
+        } else if (strchr("01xXzZ", tok[0]) && !id.empty() && id == tok + 1) {
+            const int next = tok[0] == '0' ? 0 : 1;
+            if (level == 1 && next == 0) fall = now;
+            if (level == 0 && next == 1) decoder.pulse(fall / 1000.0, (now - fall) / 1000.0);
+            level = next;
+        }
+    }
+    fclose(in);
+
+    if (id.empty()) return fail(path, 0, signal ? "signal not found" : "no 1-bit signal found");
+    if (transactions.empty()) return fail(path, 0, "no reset pulse found");
+    return true;
+}
+
+bool OWXCapture::exportVcd(const char *path) const {
+    FILE *out = fopen(path, "w");
+    if (out == nullptr) return false;
+
+    fprintf(out, "$timescale 1ns $end\n$scope module owx $end\n$var wire 1 ! DQ $end\n$upscope $end\n"
+                 "$enddefinitions $end\n#0\n1!\n");
+    uint64_t cursor = 0;   // ns, end of the last thing on the wire
+    auto low = [&](uint64_t at_ns, uint64_t width_ns) {
+        if (at_ns < cursor) at_ns = cursor;
+        fprintf(out, "#%llu\n0!\n#%llu\n1!\n", (unsigned long long)at_ns, (unsigned long long)(at_ns + width_ns));
+        cursor = at_ns + width_ns;
+    };
+
+    for (const OWXCaptureTransaction &t : transactions) {
+        bool od = t.overdrive;
+        low((uint64_t)t.t_us * 1000, (od ? VCD_OD_RESET_LOW : VCD_STD_RESET_LOW) * 1000ull);
+        const uint64_t reset_end = cursor - (od ? VCD_OD_RESET_LOW : VCD_STD_RESET_LOW) * 1000ull +
+                                   (od ? ONEWIRE_OD_RESET_US : ONEWIRE_STD_RESET_US) * 1000ull;
+        low(cursor + (od ? VCD_OD_PRESENCE_GAP : VCD_STD_PRESENCE_GAP) * 1000ull,
+            (od ? VCD_OD_PRESENCE_LOW : VCD_STD_PRESENCE_LOW) * 1000ull);
+        if (cursor < reset_end) cursor = reset_end;   // presence window
+
+        for (size_t i = 0; i < t.bytes.size(); i++) {
+            uint64_t slot = (uint64_t)t.bytes[i].t_us * 1000;
+            if (slot < cursor) slot = cursor;
+            const uint64_t slot_ns = (od ? ONEWIRE_OD_SLOT_US : ONEWIRE_STD_SLOT_US) * 1000ull;
+            for (uint8_t bit = 0; bit < 8; bit++, slot += slot_ns) {
+                const bool one = (t.bytes[i].value >> bit) & 1;
+                low(slot, (one ? (od ? VCD_OD_LOW_1 : VCD_STD_LOW_1) : (od ? VCD_OD_LOW_0 : VCD_STD_LOW_0)) * 1000ull);
+            }
+            cursor = slot;
+            if (switches_to_overdrive(t, i)) od = true;
+        }
+    }
+    return fclose(out) == 0;
+}
+
+void OWXCapture::addFromHub(const OneWireHub &hub, uint32_t t_us, bool overdrive) {
+    OWXCaptureTransaction t;
+    t.t_us = t_us;
+    t.overdrive = overdrive;
+    for (const SimBusByte &b : hub.simBusLog()) {
+        OWXCaptureByte c = { t_us + b.t_us, b.value, b.dir };
+        t.bytes.push_back(c);
+    }
+    transactions.push_back(t);
+}
@@ -0,0 +1,82 @@
+/*
+    OWX bus capture
+
+    Byte-level record of 1-Wire transactions as the slave sees them: every reset, and every
+    byte with who drove it and when. A capture comes from a logic analyzer on the slave's DQ
+    pin (importCsv(), importVcd()) or from the host hub (addFromHub()), and is kept as text so
+    a field trace can be read, diffed and checked in next to the test that replays it
+    (OWX_Replay.h, owx_replay).
+
+    Text format (.owxcap), one record per line, times in µs since the start of the capture:
+
+        OWXCAP 1
+        # comment
+        R 1200 std                              reset + presence (std or od speed)
+        M 2160 55 3A 00 00 1D 5E 00 00 9C       bytes written by the master
+        M 2736 01 0E 02 34 12 C5
+        S 3300 30                               bytes the slave drove in read slots
+        B 9000 55 3A ...                        direction not known (byte decode of the wire)
+
+    The time of an M / S / B line is that of its first byte; the others follow one byte time
+    (8 slots at the speed of the last reset) apart. A transaction runs from an R line to the
+    next one; hex bytes may also be written without spaces.
+
+    CSV import takes one reset or byte per row, as logic analyzer protocol tables list them
+    (Saleae Logic "1-Wire" export and alike): the first number on a row is its time in seconds,
+    a row containing "reset" starts a transaction ("overdrive" in it: at overdrive speed), a
+    0xNN field is a byte, "read" / "write" in the row tells its direction. Header and other rows
+    (presence, ROM command names) are skipped.
+
+    VCD import decodes the raw DQ waveform: low pulses of 400 µs and more are standard resets,
+    at overdrive (after 0x3C / 0x69) pulses of 40 µs and more are overdrive resets, the first
+    long pulse after a reset is the presence pulse, and shorter pulses are time slots read as 1
+    below 15 µs (2 µs at overdrive). Bytes are LSB first; a read and a write slot look the same
+    on the wire, so every byte is B. Bits that don't make a whole byte (ROM search) are dropped.
+*/
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <OneWireHub.h>
+
+#define OWX_CAPTURE_MASTER SIM_DIR_MASTER
+#define OWX_CAPTURE_SLAVE  SIM_DIR_SLAVE
+#define OWX_CAPTURE_BUS    SIM_DIR_ANY
+
+struct OWXCaptureByte {
+    uint32_t t_us;
+    uint8_t value;
+    uint8_t dir;         // OWX_CAPTURE_*
+};
+
+struct OWXCaptureTransaction {
+    uint32_t t_us;       // reset
+    bool overdrive;      // reset at overdrive speed
+    std::vector<OWXCaptureByte> bytes;
+};
+
+class OWXCapture
+{
+public:
+    std::vector<OWXCaptureTransaction> transactions;
+
+    // Text format above; false with error() set on a malformed line
+    bool load(const char *path);
+    bool save(const char *path) const;
+
+    bool importCsv(const char *path);
+    bool importVcd(const char *path, const char *signal = nullptr);   // nullptr: first 1-bit wire
+
+    // Waveform of the capture as a VCD (1 ns timescale) for a waveform viewer; slots and pulses
+    // get the nominal widths of the speed, so importVcd() reads the same bytes back
+    bool exportVcd(const char *path) const;
+
+    // Appends the last poll() of the host hub, t_us = time of its reset
+    void addFromHub(const OneWireHub &hub, uint32_t t_us, bool overdrive);
+
+    const std::string &error() const { return lastError; }
+
+private:
+    std::string lastError;
+    bool fail(const char *path, unsigned long line, const char *what);
+};
@@ -0,0 +1,65 @@
+#include "OWX_Replay.h"
+
+static const char *skip_reason(const OWXCaptureTransaction &t, const EmulatorBase &emu) {
+    if (t.bytes.empty()) return "reset only";
+    const uint8_t rom_cmd = t.bytes[0].value;
+    if (rom_cmd == ONEWIRE_CMD_SEARCH_ROM || rom_cmd == ONEWIRE_CMD_ALARM_SEARCH) return "ROM search";
+    if (rom_cmd == ONEWIRE_CMD_MATCH_ROM || rom_cmd == ONEWIRE_CMD_OD_MATCH_ROM) {
+        for (uint8_t i = 0; i < 8; i++) {
+            if (t.bytes.size() <= 1u + i || t.bytes[1 + i].value != emu.ID[i]) return "other ROM";
+        }
+    }
+    return nullptr;
+}
+
+std::vector<OWXReplayResult> OWXReplay::run(const OWXCapture &capture, OneWireHub &hub, EmulatorBase &emu, LoopFn loop) {
+    std::vector<OWXReplayResult> results;
+    std::vector<uint8_t> bytes, dirs;
+    hub.simEnableOverdrive(true);
+
+    for (const OWXCaptureTransaction &t : capture.transactions) {
+        OWXReplayResult r = {};
+        r.firstMismatch = -1;
+        r.skipped = skip_reason(t, emu);
+        const uint8_t rom_cmd = t.bytes.empty() ? 0 : t.bytes[0].value;
+        const size_t header = rom_cmd == ONEWIRE_CMD_SKIP_ROM || rom_cmd == ONEWIRE_CMD_OD_SKIP_ROM ? 1 : 9;
+        r.command = t.bytes.size() > header ? t.bytes[header].value : 0;
+        if (r.skipped) {
+            results.push_back(r);
+            continue;
+        }
+
+        bytes.clear();
+        dirs.clear();
+        for (const OWXCaptureByte &b : t.bytes) {
+            bytes.push_back(b.value);
+            dirs.push_back(b.dir);
+        }
+        if (!t.overdrive) hub.simStandardReset();
+        hub.simReplay(bytes.data(), dirs.data(), bytes.size());
+
+        const uint64_t start = OneWireHub::simClock();
+        hub.poll();
+        r.cpu = OneWireHub::simClock() - start;
+
+        r.mismatches = hub.simReplayMismatches();
+        r.firstMismatch = hub.simReplayFirstMismatch();
+        r.turnaround = hub.simMaxTurnaround();
+        r.byteGap = hub.simMaxByteGap();
+        r.response.assign(hub.simSlaveOutput(), hub.simSlaveOutput() + hub.simSlaveOutputLen());
+
+        // What the capture still holds: replies the emulator didn't give, master bytes it didn't read
+        for (size_t i = bytes.size() - hub.simMasterPending(); i < bytes.size(); i++) {
+            if (dirs[i] == SIM_DIR_SLAVE) {
+                if (r.firstMismatch < 0) r.firstMismatch = (int32_t)i;
+                r.mismatches++;
+            } else {
+                r.unread++;
+            }
+        }
+        results.push_back(r);
+
+        if (loop) loop(emu);
+    }
+    return results;
+}
@@ -0,0 +1,43 @@
+/*
+    OWX deterministic replay
+
+    Feeds the transactions of a capture (OWX_Capture.h) through an emulator on the host hub,
+    one poll() each, in capture order. The emulator reads the captured master bytes, and every
+    byte it sends is compared with the byte captured at that point, so a field trace checks that
+    the emulator still answers the way it did, CRC errors, timeouts and retries included. A
+    transaction cut short in the field (reset in the middle of a frame) makes recv() fail at the
+    same byte as on the wire.
+
+    Replay is deterministic for a given emulator setup: nothing depends on wall clock time except
+    the statistics histogram and OWXMessage timestamps, which never go back on the bus unless the
+    master reads OW_LOW_CMD_READ_STATS. Transactions for other ROMs, ROM searches and resets
+    without bytes are skipped.
+
+    Between transactions the caller's loop() runs, as the application's would (drain the receive
+    queue, processPending(), ...).
+*/
+#pragma once
+#include <OWX_Slave_Emulator.h>
+#include <vector>
+#include "OWX_Capture.h"
+
+struct OWXReplayResult {
+    const char *skipped;             // nullptr if replayed, otherwise why not
+    uint8_t command;                 // first byte after the ROM command
+    uint32_t mismatches;             // bytes the emulator sent differently, or not at all
+    int32_t firstMismatch;           // index in the transaction's bytes, -1: none
+    uint32_t unread;                 // captured master bytes the emulator never read
+    std::vector<uint8_t> response;   // bytes the emulator sent
+    uint64_t cpu;                    // poll() incl. duty(), OneWireHub::simClock() ticks
+    uint64_t turnaround;             // simMaxTurnaround() / simMaxByteGap() of the transaction
+    uint64_t byteGap;
+};
+
+class OWXReplay
+{
+public:
+    typedef void (*LoopFn)(EmulatorBase &emu);
+
+    // emu must be attached to hub; loop may be nullptr
+    static std::vector<OWXReplayResult> run(const OWXCapture &capture, OneWireHub &hub, EmulatorBase &emu, LoopFn loop);
+};
@@ -0,0 +1,193 @@
+/*
+    OWX capture replay
+
+    Replays a bus capture (OWX_Capture.h: .owxcap text, logic analyzer CSV or VCD) through
+    Emulator::duty() on the host hub and checks every byte the emulator sends against the
+    capture. The capture is replayed --runs times, each time on a fresh emulator: the responses
+    must be the same every run (deterministic), and the CPU time per transaction is the best of
+    the runs, so a field trace is a regression test and a benchmark at once.
+
+        ./build/owx_replay field.owxcap
+        ./build/owx_replay --vcd --signal DQ --rom 3A0102030405069C --ack-handlers dump.vcd
+        ./build/owx_replay --csv export.csv --save field.owxcap     (convert, then replay)
+
+    The emulator is a default Emulator with the ROM of the first MATCH ROM in the capture
+    (--rom overrides). Between transactions the receive queue is drained, processPending() runs
+    and a completed bulk transfer is released, as a plain application loop() would. A capture of
+    a device with registered structs, bound variables or handlers that answer differently needs
+    that setup: use OWXReplay (OWX_Replay.h) from a small harness that builds the same emulator.
+
+    Exit code: 0 all replayed transactions match, 1 a mismatch or a nondeterministic response,
+    2 usage or input error.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include "OWX_Replay.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define REPLAY_UNIT "cycles"
+#else
+#define REPLAY_UNIT "ns"
+#endif
+
+static bool ack_handlers = false;
+static bool keep_queue = false;
+static uint8_t bulk_buffer[OW_BULK_MAX_CHUNKS * OW_BULK_CHUNK_SIZE];
+static uint16_t bulk_size = 0;
+
+static bool ack_handler(uint8_t) { return true; }
+
+// The application's loop() between two transactions
+static void replay_loop(EmulatorBase &emu) {
+    if (!keep_queue) {
+        while (emu.available()) emu.clearAvailable();
+    }
+    emu.processPending();
+    if (emu.bulkAvailable()) emu.clearBulk();
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr,
+            "usage: %s [--csv | --vcd [--signal NAME]] [--rom HEX16] [--runs N] [--ack-handlers]\n"
+            "          [--bulk BYTES] [--keep-queue] [--save FILE.owxcap] [--quiet] capture\n", argv0);
+}
+
+static bool parse_rom(const char *hex, uint8_t rom[8]) {
+    if (strlen(hex) != 16) return false;
+    for (uint8_t i = 0; i < 8; i++) {
+        char byte[3] = { hex[2 * i], hex[2 * i + 1], 0 };
+        char *end;
+        rom[i] = (uint8_t)strtoul(byte, &end, 16);
+        if (*end) return false;
+    }
+    return true;
+}
+
+// ROM of the first MATCH ROM in the capture
+static bool capture_rom(const OWXCapture &capture, uint8_t rom[8]) {
+    for (const OWXCaptureTransaction &t : capture.transactions) {
+        if (t.bytes.size() < 9) continue;
+        if (t.bytes[0].value != ONEWIRE_CMD_MATCH_ROM && t.bytes[0].value != ONEWIRE_CMD_OD_MATCH_ROM) continue;
+        for (uint8_t i = 0; i < 8; i++) rom[i] = t.bytes[1 + i].value;
+        return true;
+    }
+    return false;
+}
+
+static std::vector<OWXReplayResult> replay_once(const OWXCapture &capture, const uint8_t rom[8]) {
+    OneWireHub hub(2);
+    Emulator emu(rom[0], rom[1], rom[2], rom[3], rom[4], rom[5], rom[6]);
+    if (ack_handlers) emu.setCustomHandler(ack_handler);
+    if (bulk_size) emu.setBulkBuffer(bulk_buffer, bulk_size);
+    hub.attach(emu);
+    return OWXReplay::run(capture, hub, emu, replay_loop);
+}
+
+int main(int argc, char **argv) {
+    enum { TEXT, CSV, VCD } format = TEXT;
+    const char *signal = nullptr, *path = nullptr, *save = nullptr;
+    uint8_t rom[8] = { 0x3A, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0 };
+    bool rom_given = false, quiet = false;
+    unsigned runs = 20;
+
+    for (int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (strcmp(a, "--csv") == 0) format = CSV;
+        else if (strcmp(a, "--vcd") == 0) format = VCD;
+        else if (strcmp(a, "--signal") == 0 && has_value) signal = argv[++i];
+        else if (strcmp(a, "--rom") == 0 && has_value) rom_given = parse_rom(argv[++i], rom);
+        else if (strcmp(a, "--runs") == 0 && has_value) runs = (unsigned)atoi(argv[++i]);
+        else if (strcmp(a, "--ack-handlers") == 0) ack_handlers = true;
+        else if (strcmp(a, "--bulk") == 0 && has_value) bulk_size = (uint16_t)std::min(atoi(argv[++i]), (int)sizeof(bulk_buffer));
+        else if (strcmp(a, "--keep-queue") == 0) keep_queue = true;
+        else if (strcmp(a, "--save") == 0 && has_value) save = argv[++i];
+        else if (strcmp(a, "--quiet") == 0) quiet = true;
+        else if (a[0] == '-' || path) {
+            usage(argv[0]);
+            return 2;
+        } else path = a;
+    }
+    if (path == nullptr || runs == 0) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    OWXCapture capture;
+    const bool loaded = format == CSV ? capture.importCsv(path) : format == VCD ? capture.importVcd(path, signal) : capture.load(path);
+    if (!loaded) {
+        fprintf(stderr, "%s\n", capture.error().c_str());
+        return 2;
+    }
+    if (save && !capture.save(save)) {
+        perror(save);
+        return 2;
+    }
+    if (!rom_given && !capture_rom(capture, rom)) rom[7] = OneWireItem::crc8(rom, 7);
+    if (OneWireItem::crc8(rom, 7) != rom[7]) {
+        fprintf(stderr, "ROM CRC8 does not match: the emulator can't answer this MATCH ROM\n");
+        return 2;
+    }
+
+    // First run is the reference, the others must answer the same and only improve the CPU times
+    std::vector<OWXReplayResult> results = replay_once(capture, rom);
+    uint32_t nondeterministic = 0;
+    for (unsigned run = 1; run < runs; run++) {
+        std::vector<OWXReplayResult> again = replay_once(capture, rom);
+        for (size_t i = 0; i < results.size(); i++) {
+            if (again[i].response != results[i].response || again[i].mismatches != results[i].mismatches) nondeterministic++;
+            results[i].cpu = std::min(results[i].cpu, again[i].cpu);
+            results[i].turnaround = std::min(results[i].turnaround, again[i].turnaround);
+            results[i].byteGap = std::min(results[i].byteGap, again[i].byteGap);
+        }
+    }
+
+    printf("%s: %u transactions, ROM %02X%02X%02X%02X%02X%02X%02X%02X, best of %u runs, CPU in %s\n", path,
+           (unsigned)results.size(), rom[0], rom[1], rom[2], rom[3], rom[4], rom[5], rom[6], rom[7], runs, REPLAY_UNIT);
+    if (!quiet) printf("     #     t (ms)   cmd  sent  result          CPU  turnaround  byte gap\n");
+
+    uint32_t replayed = 0, failed = 0;
+    std::vector<uint64_t> cpu;
+    for (size_t i = 0; i < results.size(); i++) {
+        const OWXReplayResult &r = results[i];
+        const OWXCaptureTransaction &t = capture.transactions[i];
+        if (r.skipped) {
+            if (!quiet) printf("  %4u  %9.3f         skipped (%s)\n", (unsigned)i, t.t_us / 1000.0, r.skipped);
+            continue;
+        }
+        replayed++;
+        cpu.push_back(r.cpu);
+        if (r.mismatches) failed++;
+        if (quiet && !r.mismatches) continue;
+
+        char result[32];
+        if (r.mismatches) snprintf(result, sizeof(result), "MISMATCH @%d", (int)r.firstMismatch);
+        else snprintf(result, sizeof(result), "ok");
+        printf("  %4u  %9.3f  0x%02X  %4u  %-12s %8llu  %10llu  %8llu\n", (unsigned)i, t.t_us / 1000.0, r.command,
+               (unsigned)r.response.size(), result, (unsigned long long)r.cpu,
+               (unsigned long long)r.turnaround, (unsigned long long)r.byteGap);
+        if (r.mismatches) {
+            printf("        capture:");
+            for (const OWXCaptureByte &b : t.bytes) printf(" %c%02X", "msb"[b.dir], b.value);
+            printf("\n        emulator sent:");
+            for (uint8_t b : r.response) printf(" %02X", b);
+            printf("\n");
+        }
+    }
+
+    uint64_t total = 0, worst = 0, median = 0;
+    for (uint64_t c : cpu) {
+        total += c;
+        worst = std::max(worst, c);
+    }
+    if (!cpu.empty()) {
+        std::sort(cpu.begin(), cpu.end());
+        median = cpu[cpu.size() / 2];
+    }
+    printf("%u replayed, %u skipped, %u mismatched, %u nondeterministic; CPU total %llu, median %llu, worst %llu %s\n",
+           replayed, (unsigned)(results.size() - replayed), failed, nondeterministic, (unsigned long long)total,
+           (unsigned long long)median, (unsigned long long)worst, REPLAY_UNIT);
+    return failed || nondeterministic ? 1 : 0;
+}
@@ -0,0 +1,20 @@
+# Fails when a reduced configuration does not shrink: its code share (text over the hub-only
+# baseline) must stay below MAX_PERCENT of the full emulator's. Registered as ctest owx_size:
+#   cmake -DSIZE_TOOL=<size> -DBASELINE=<cfg0> -DFULL=<cfg1> -DREDUCED=<cfg> -DMAX_PERCENT=<n> -P size_check.cmake
+function(text_size binary out)
+    execute_process(COMMAND ${SIZE_TOOL} ${binary} OUTPUT_VARIABLE size_out)
+    string(REGEX MATCH "\n[ \t]*([0-9]+)" size_match "${size_out}")
+    set(${out} ${CMAKE_MATCH_1} PARENT_SCOPE)
+endfunction()
+
+text_size(${BASELINE} baseline)
+text_size(${FULL} full)
+text_size(${REDUCED} reduced)
+math(EXPR full_code "${full} - ${baseline}")
+math(EXPR reduced_code "${reduced} - ${baseline}")
+math(EXPR percent "100 * ${reduced_code} / ${full_code}")
+execute_process(COMMAND ${REDUCED} OUTPUT_VARIABLE ram_line OUTPUT_STRIP_TRAILING_WHITESPACE)
+message("${ram_line}   code +${reduced_code} B = ${percent}% of the full emulator's +${full_code} B")
+if(percent GREATER MAX_PERCENT)
+    message(FATAL_ERROR "reduced configuration keeps ${percent}% of the code, limit ${MAX_PERCENT}%")
+endif()
@@ -0,0 +1,15 @@
+# Prints RAM per instance and code size relative to the hub-only baseline
+# for every size configuration. Invoked by the owx_size_report target:
+#   cmake -DSIZE_TOOL=<size> -DBINARIES="<cfg0>;<cfg1>;..." -P size_report.cmake
+set(baseline "")
+foreach(binary ${BINARIES})
+    execute_process(COMMAND ${binary} OUTPUT_VARIABLE ram_line OUTPUT_STRIP_TRAILING_WHITESPACE)
+    execute_process(COMMAND ${SIZE_TOOL} ${binary} OUTPUT_VARIABLE size_out)
+    string(REGEX MATCH "\n[ \t]*([0-9]+)[ \t]+([0-9]+)[ \t]+([0-9]+)" size_match "${size_out}")
+    set(text ${CMAKE_MATCH_1})
+    if(baseline STREQUAL "")
+        set(baseline ${text})
+    endif()
+    math(EXPR code "${text} - ${baseline}")
+    message("${ram_line}   code +${code} B")
+endforeach()
@@ -0,0 +1,53 @@
+/*
+    OWX size report: one emulator configuration per binary
+
+    Built once per OWX_SIZE_CONFIG value (see CMakeLists.txt, target owx_size_report).
+    Each binary prints the RAM of one instance; size_report.cmake compares the code size
+    of every binary against config 0 (hub only) to get the emulator's share.
+    Host (x86-64) code size is a proxy for the relative cost on target, not an absolute.
+*/
+#include <OWX_Slave_Emulator.h>
+#include <stdio.h>
+
+#ifndef OWX_SIZE_CONFIG
+#define OWX_SIZE_CONFIG 1
+#endif
+
+#if OWX_SIZE_CONFIG == 1
+#define SIZE_NAME "Emulator (9 B scratchpad, 32 B payload, all types)"
+typedef Emulator SizeEmulator;
+#elif OWX_SIZE_CONFIG == 2
+#define SIZE_NAME "BasicEmulator<4, 4, INT16, FLOAT32>"
+typedef BasicEmulator<4, 4, OW_CMD_INT16, OW_CMD_FLOAT32> SizeEmulator;
+#elif OWX_SIZE_CONFIG == 3
+#define SIZE_NAME "BasicEmulator<9, 16, STRUCT>"
+typedef BasicEmulator<9, 16, OW_CMD_STRUCT> SizeEmulator;
+#elif OWX_SIZE_CONFIG == 4
+#define SIZE_NAME "BasicEmulator<1, 1, UINT8>"
+typedef BasicEmulator<1, 1, OW_CMD_UINT8> SizeEmulator;
+#elif OWX_SIZE_CONFIG == 5
+#define SIZE_NAME "FeatureEmulator<HANDLERS, 4, 4, INT16, FLOAT32>"
+typedef FeatureEmulator<OW_FEATURE_HANDLERS, 4, 4, OW_CMD_INT16, OW_CMD_FLOAT32> SizeEmulator;
+#elif OWX_SIZE_CONFIG == 6
+#define SIZE_NAME "FeatureEmulator<0, 1, 1, UINT8> (minimal)"
+typedef FeatureEmulator<0, 1, 1, OW_CMD_UINT8> SizeEmulator;
+#endif
+
+OneWireHub hub(2);
+
+#if OWX_SIZE_CONFIG == 0
+int main() {
+    printf("%-55s RAM %5u B\n", "hub only (baseline)", 0u);
+    hub.poll();
+    return 0;
+}
+#else
+SizeEmulator emu(0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07);
+
+int main() {
+    printf("%-55s RAM %5u B\n", SIZE_NAME, (unsigned)sizeof(SizeEmulator));
+    hub.attach(emu);
+    hub.poll();
+    return emu.available() ? 1 : 0;
+}
+#endif
@@ -0,0 +1,427 @@
+/*
+    OWX protocol regression test
+
+    Corner cases of the slave protocol that the benches don't reach, each checked against the
+    exact reply bytes on the simulated hub:
+
+        - a struct frame while the last one for the same ID is still queued is refused (BUSY)
+          and leaves the destination alone; once consumed the next one is stored
+        - a deferred struct callback gets every frame's value: the next frame is BUSY until
+          dispatchPending() ran the callback for the last one
+        - a batch naming a struct whose value is still queued is refused as a whole, a batch
+          carrying the same struct twice is NACKed LENGTH (split it)
+        - a batch with more values than the receive queue holds is NACKed LENGTH, not BUSY
+          forever; one that only lacks free slots right now is BUSY
+        - writeScratchpad_*() from loop() is read back at once, stageScratchpad() only after
+          publishScratchpad(), and a handler's writes once it returned true; a handler that
+          fails leaves nothing staged for the next publish
+        - a changed-read whose reply was lost, the very first one included, is answered with
+          the same regions again until the master confirms their generation
+        - an alarm raised while the reply that clears it is on the wire stays active, and 256
+          raises between two clears don't wrap back to "cleared"
+        - a FeatureEmulator without a subsystem carries none of its RAM, ignores its commands
+          like unknown ones and leaves it out of the capabilities; OW_FEATURE_SHARED_HANDLERS
+          instances answer from one table, other configurations keep their own
+
+    Run with ctest, or directly: ./build/owx_protocol_test
+*/
+#include <OWX_Slave_Emulator.h>
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+struct Limits {
+    int16_t low;
+    int16_t high;
+};
+
+static OneWireHub hub(2);
+
+static std::vector<uint8_t> variable_frame(uint8_t cmd, const void *payload, uint8_t len) {
+    std::vector<uint8_t> f = { OW_LOW_CMD_SEND_VARIABLE_, cmd, len };
+    f.insert(f.end(), (const uint8_t *)payload, (const uint8_t *)payload + len);
+    f.push_back(OWXCrc8::compute(&f[1], 2 + len));
+    return f;
+}
+
+static std::vector<uint8_t> struct_payload(uint8_t id, const Limits &value) {
+    std::vector<uint8_t> p(1, id);
+    p.insert(p.end(), (const uint8_t *)&value, (const uint8_t *)&value + sizeof(value));
+    return p;
+}
+
+// Runs one transaction, true if the slave answered exactly reply
+static bool answers(OneWireItem &item, const std::vector<uint8_t> &tx, std::vector<uint8_t> reply) {
+    hub.simTransaction(item, tx.data(), tx.size());
+    return hub.simSlaveOutputLen() == reply.size() &&
+           std::equal(reply.begin(), reply.end(), hub.simSlaveOutput());
+}
+
+static bool check(const char *what, bool ok) {
+    printf("  %-64s %s\n", what, ok ? "ok" : "FAILED");
+    return ok;
+}
+
+static bool struct_not_overwritten() {
+    Emulator emu(0x3A, 0x10, 0x00, 0x00, 0x00, 0x00, 0x01);
+    hub.attach(emu);
+    Limits limits = {};
+    emu.registerStruct(0x01, &limits);
+
+    const Limits first = { -10, 10 }, second = { -20, 20 };
+    std::vector<uint8_t> p1 = struct_payload(0x01, first), p2 = struct_payload(0x01, second);
+    bool ok = check("struct frame stored and queued",
+                    answers(emu, variable_frame(OW_CMD_STRUCT, p1.data(), p1.size()), { OW_CMD_ACK }) &&
+                    emu.pending() == 1 && limits.high == 10);
+    ok &= check("second frame for the queued struct: BUSY, destination kept",
+                answers(emu, variable_frame(OW_CMD_STRUCT, p2.data(), p2.size()), { OW_CMD_NACK, OW_NACK_BUSY }) &&
+                emu.pending() == 1 && limits.low == -10 && limits.high == 10);
+    emu.clearAvailable();
+    ok &= check("after clearAvailable() the retry is stored",
+                answers(emu, variable_frame(OW_CMD_STRUCT, p2.data(), p2.size()), { OW_CMD_ACK }) &&
+                limits.high == 20);
+
+    // Batch: [ STRUCT 0x01 | INT16 ] while 0x01 is still queued, then the same struct twice
+    int16_t i16 = 7;
+    std::vector<uint8_t> batch = { OW_CMD_STRUCT, (uint8_t)p1.size() };
+    batch.insert(batch.end(), p1.begin(), p1.end());
+    batch.push_back(OW_CMD_INT16);
+    batch.push_back(2);
+    batch.insert(batch.end(), (uint8_t *)&i16, (uint8_t *)&i16 + 2);
+    ok &= check("batch with a queued struct: BUSY, nothing delivered",
+                answers(emu, variable_frame(OW_CMD_BATCH, batch.data(), batch.size()), { OW_CMD_NACK, OW_NACK_BUSY }) &&
+                emu.pending() == 1 && limits.high == 20);
+    emu.clearAvailable();
+
+    std::vector<uint8_t> twice = { OW_CMD_STRUCT, (uint8_t)p1.size() };
+    twice.insert(twice.end(), p1.begin(), p1.end());
+    twice.push_back(OW_CMD_STRUCT);
+    twice.push_back((uint8_t)p2.size());
+    twice.insert(twice.end(), p2.begin(), p2.end());
+    ok &= check("batch with the same struct twice: LENGTH (split it)",
+                answers(emu, variable_frame(OW_CMD_BATCH, twice.data(), twice.size()), { OW_CMD_NACK, OW_NACK_LENGTH }) &&
+                emu.pending() == 0);
+    ok &= check("batch with the struct once is delivered",
+                answers(emu, variable_frame(OW_CMD_BATCH, batch.data(), batch.size()), { OW_CMD_ACK }) &&
+                emu.pending() == 2 && limits.high == 10);
+
+    hub.detach(emu);
+    return ok;
+}
+
+static std::vector<Limits> limits_seen;
+
+static void on_limits(const Limits &value) { limits_seen.push_back(value); }
+
+static bool struct_callbacks() {
+    Emulator emu(0x3A, 0x19, 0x00, 0x00, 0x00, 0x00, 0x01);
+    hub.attach(emu);
+    Limits limits = {};
+    emu.registerStruct(0x01, &limits);
+    emu.onReceive(0x01, on_limits);
+    limits_seen.clear();
+
+    const Limits first = { -1, 1 }, second = { -2, 2 };
+    std::vector<uint8_t> p1 = struct_payload(0x01, first), p2 = struct_payload(0x01, second);
+    bool ok = check("two struct frames before dispatchPending(): ACK, then BUSY",
+                    answers(emu, variable_frame(OW_CMD_STRUCT, p1.data(), p1.size()), { OW_CMD_ACK }) &&
+                    answers(emu, variable_frame(OW_CMD_STRUCT, p2.data(), p2.size()), { OW_CMD_NACK, OW_NACK_BUSY }));
+    ok &= check("callback sees the first value",
+                emu.dispatchPending() == 1 && limits_seen.size() == 1 && limits_seen[0].high == 1);
+    ok &= check("retried second frame is delivered to the callback too",
+                answers(emu, variable_frame(OW_CMD_STRUCT, p2.data(), p2.size()), { OW_CMD_ACK }) &&
+                emu.dispatchPending() == 1 && limits_seen.size() == 2 && limits_seen[1].high == 2);
+
+    hub.detach(emu);
+    return ok;
+}
+
+static bool oversize_batch() {
+    Emulator emu(0x3A, 0x11, 0x00, 0x00, 0x00, 0x00, 0x01);
+    hub.attach(emu);
+
+    std::vector<uint8_t> batch;
+    for(uint8_t i = 0; i <= OW_RX_QUEUE_SIZE; i++) {
+        batch.push_back(OW_CMD_UINT8);
+        batch.push_back(1);
+        batch.push_back(i);
+    }
+    bool ok = check("batch of OW_RX_QUEUE_SIZE + 1 values: LENGTH",
+                    answers(emu, variable_frame(OW_CMD_BATCH, batch.data(), batch.size()), { OW_CMD_NACK, OW_NACK_LENGTH }) &&
+                    emu.pending() == 0);
+
+    batch.resize(3 * OW_RX_QUEUE_SIZE);
+    const uint8_t one = 1;
+    answers(emu, variable_frame(OW_CMD_UINT8, &one, 1), { OW_CMD_ACK });
+    ok &= check("batch of OW_RX_QUEUE_SIZE values, one slot taken: BUSY",
+                answers(emu, variable_frame(OW_CMD_BATCH, batch.data(), batch.size()), { OW_CMD_NACK, OW_NACK_BUSY }) &&
+                emu.pending() == 1);
+    emu.clearAvailable();
+    ok &= check("same batch on an empty queue is delivered",
+                answers(emu, variable_frame(OW_CMD_BATCH, batch.data(), batch.size()), { OW_CMD_ACK }) &&
+                emu.pending() == OW_RX_QUEUE_SIZE);
+
+    hub.detach(emu);
+    return ok;
+}
+
+static bool oversize_varint() {
+    Emulator emu(0x3A, 0x1A, 0x00, 0x00, 0x00, 0x00, 0x01);
+    int32_t values[2] = { 7, 7 };
+    emu.registerArray(0x05, values, 2);
+    hub.attach(emu);
+
+    // INT32_MIN zigzags to 0xFFFFFFFF: all four bits the 5th byte may carry
+    const uint8_t widest[] = { 0x05, OW_ARRAY_DELTA_VARINT, 0, 1, 0xFF, 0xFF, 0xFF, 0xFF, 0x0F };
+    bool ok = check("32-bit varint using all 32 bits: ACK",
+                    answers(emu, variable_frame(OW_CMD_ARRAY_INT32, widest, sizeof(widest)), { OW_CMD_ACK }) &&
+                    values[0] == INT32_MIN);
+
+    // 0x10 in the 5th byte is bit 32: used to be shifted out and stored as 0
+    const uint8_t overflow[] = { 0x05, OW_ARRAY_DELTA_VARINT, 1, 1, 0x80, 0x80, 0x80, 0x80, 0x10 };
+    ok &= check("32-bit varint with bit 32 set: LENGTH, element untouched",
+                answers(emu, variable_frame(OW_CMD_ARRAY_INT32, overflow, sizeof(overflow)), { OW_CMD_NACK, OW_NACK_LENGTH }) &&
+                values[1] == 7);
+
+    hub.detach(emu);
+    return ok;
+}
+
+static bool read_scratchpad(OneWireItem &item, uint8_t expect0, uint8_t expect1) {
+    const uint8_t read = OW_READ_SCRATCHPAD;
+    hub.simTransaction(item, &read, 1);
+    return hub.simSlaveOutputLen() == OW_SCRATCHPAD_SIZE &&
+           hub.simSlaveOutput()[0] == expect0 && hub.simSlaveOutput()[1] == expect1;
+}
+
+static Emulator *handler_device;
+
+static bool write_two(uint8_t cmd) {
+    handler_device->writeScratchpad_uint8(cmd, 0);
+    handler_device->writeScratchpad_uint8(cmd + 1, 1);
+    return true;
+}
+
+// Stages a half update, then fails
+static bool write_and_fail(uint8_t cmd) {
+    handler_device->writeScratchpad_uint8(cmd, 0);
+    return false;
+}
+
+static bool scratchpad_publishing() {
+    Emulator emu(0x3A, 0x12, 0x00, 0x00, 0x00, 0x00, 0x01);
+    hub.attach(emu);
+    handler_device = &emu;
+    emu.setCustomHandler(write_two);
+
+    emu.writeScratchpad_uint8(0x11, 0);
+    bool ok = check("writeScratchpad_*() from loop() is read back at once", read_scratchpad(emu, 0x11, 0x00));
+
+    emu.stageScratchpad((uint8_t)0x22, 0);
+    emu.stageScratchpad((uint8_t)0x23, 1);
+    ok &= check("stageScratchpad() stays invisible", read_scratchpad(emu, 0x11, 0x00));
+    emu.publishScratchpad();
+    ok &= check("publishScratchpad() shows both bytes", read_scratchpad(emu, 0x22, 0x23));
+
+    const uint8_t run[] = { OW_HANDLER_COMMAND, 0x40 };
+    ok &= check("handler writes are read back after its ACK",
+                answers(emu, std::vector<uint8_t>(run, run + 2), { OW_CMD_ACK }) && read_scratchpad(emu, 0x40, 0x41));
+
+    emu.setCustomHandler(write_and_fail);
+    const uint8_t fail[] = { OW_HANDLER_COMMAND, 0x77 };
+    ok &= check("failed handler: NACK, its write not visible",
+                answers(emu, std::vector<uint8_t>(fail, fail + 2), { OW_CMD_NACK, OW_NACK_UNHANDLED }) &&
+                read_scratchpad(emu, 0x40, 0x41));
+    emu.stageScratchpad((uint8_t)0x99, 1);
+    emu.publishScratchpad();
+    ok &= check("next publish carries only its own bytes", read_scratchpad(emu, 0x40, 0x99));
+
+    const uint8_t fail_async[] = { OW_HANDLER_COMMAND_ASYNC, 0x66 };
+    answers(emu, std::vector<uint8_t>(fail_async, fail_async + 2), { OW_CMD_ACCEPTED });
+    emu.processPending();
+    emu.stageScratchpad((uint8_t)0x98, 1);
+    emu.publishScratchpad();
+    ok &= check("failed split-phase handler: same", emu.handlerState() == OW_ASYNC_FAILED && read_scratchpad(emu, 0x40, 0x98));
+
+    hub.detach(emu);
+    return ok;
+}
+
+static std::vector<uint8_t> changed_read(OneWireItem &item, uint8_t last_gen) {
+    const uint8_t tx[] = { OW_READ_SCRATCHPAD_CHANGED, last_gen };
+    hub.simTransaction(item, tx, 2);
+    return std::vector<uint8_t>(hub.simSlaveOutput(), hub.simSlaveOutput() + hub.simSlaveOutputLen());
+}
+
+static bool lost_changed_replies() {
+    Emulator emu(0x3A, 0x14, 0x00, 0x00, 0x00, 0x00, 0x01);
+    hub.attach(emu);
+
+    // [ 0x35 | GEN | COUNT=1 | OFFSET=0 | LEN | DATA (LEN) | CRC8 ]
+    std::vector<uint8_t> first = changed_read(emu, 0);
+    bool ok = check("first changed-read: whole scratchpad, generation not 0",
+                    first.size() == 6 + OW_SCRATCHPAD_SIZE && first[0] == OW_SCRATCHPAD_CHANGED &&
+                    first[1] != 0 && first[4] == OW_SCRATCHPAD_SIZE);
+    ok &= check("first reply lost (LAST_GEN still 0): sent again", changed_read(emu, 0) == first);
+    const uint8_t gen = first[1];
+    ok &= check("confirmed: UNCHANGED", changed_read(emu, gen) == std::vector<uint8_t>(1, OW_SCRATCHPAD_UNCHANGED));
+
+    emu.writeScratchpad_uint8(0x5A, 2);
+    std::vector<uint8_t> update = changed_read(emu, gen);
+    ok &= check("one byte written: one region",
+                update.size() == 7 && update[1] != gen && update[2] == 1 && update[3] == 2 && update[5] == 0x5A);
+    ok &= check("update lost: sent again", changed_read(emu, gen) == update);
+    ok &= check("update confirmed: UNCHANGED",
+                changed_read(emu, update[1]) == std::vector<uint8_t>(1, OW_SCRATCHPAD_UNCHANGED));
+
+    hub.detach(emu);
+    return ok;
+}
+
+// Serves one scripted transaction over the hub's virtual bus link and runs during_reply() when
+// the slave's first reply bytes go out, like an interrupt between sending a reply and clearing
+class InterruptingLink : public SimBusLink {
+public:
+    OneWireItem *item;
+    std::vector<uint8_t> script;
+    void (*during_reply)();
+
+    bool select(OneWireHub &, uint8_t rom[8], bool &overdrive) override {
+        memcpy(rom, item->ID, 8);
+        overdrive = false;
+        return true;
+    }
+    uint8_t masterBytes(uint8_t *data, uint8_t len) override {
+        uint8_t n = 0;
+        while (n < len && pos < script.size()) data[n++] = script[pos++];
+        return n;
+    }
+    void slaveBytes(const uint8_t *, uint8_t) override {
+        if (during_reply) during_reply();
+        during_reply = nullptr;
+    }
+    void done() override {}
+
+private:
+    size_t pos = 0;
+};
+
+static void interrupted(OneWireItem &item, std::vector<uint8_t> tx, void (*during_reply)()) {
+    InterruptingLink link;
+    link.item = &item;
+    link.script = tx;
+    link.during_reply = during_reply;
+    hub.simLink(&link);
+    hub.poll();
+    hub.simLink(nullptr);
+}
+
+static Emulator *alarm_device;
+
+static bool alarm_latches() {
+    Emulator emu(0x3A, 0x15, 0x00, 0x00, 0x00, 0x00, 0x01);
+    hub.attach(emu);
+    alarm_device = &emu;
+
+    emu.raiseAlarm();
+    interrupted(emu, { OW_LOW_CMD_ALARM, OW_ALARM_USER }, [] { alarm_device->raiseAlarm(); });
+    bool ok = check("raise during the ALARM reply that clears USER: still active",
+                    emu.alarmFlags() == OW_ALARM_USER);
+    const uint8_t clear[] = { OW_LOW_CMD_ALARM, OW_ALARM_USER }, user = OW_ALARM_USER;
+    ok &= check("next clear without a raise: inactive",
+                answers(emu, std::vector<uint8_t>(clear, clear + 2), { OW_ALARM_USER, OWXCrc8::compute(&user, 1) }) &&
+                emu.alarmFlags() == 0);
+
+    emu.writeScratchpad_uint8(0x01, 0);
+    interrupted(emu, { OW_READ_SCRATCHPAD }, [] { alarm_device->writeScratchpad_uint8(0x02, 0); });
+    ok &= check("publish during READ_SCRATCHPAD: SCRATCHPAD still active", emu.alarmFlags() == OW_ALARM_SCRATCHPAD);
+    ok &= check("read of the new image clears it", read_scratchpad(emu, 0x02, 0x00) && emu.alarmFlags() == 0);
+
+    for (int i = 0; i < 256; i++) emu.raiseAlarm();
+    ok &= check("256 raises since the last clear: still active", emu.alarmFlags() == OW_ALARM_USER);
+    answers(emu, std::vector<uint8_t>(clear, clear + 2), {});
+    ok &= check("one clear catches up with all of them", emu.alarmFlags() == 0);
+
+    handler_device = &emu;
+    emu.setCustomHandler(write_two);
+    answers(emu, { OW_HANDLER_COMMAND, 0x30 }, { OW_CMD_ACK });
+    ok &= check("handler writes the scratchpad: SCRATCHPAD active",
+                emu.alarmed() && (emu.alarmFlags() & OW_ALARM_SCRATCHPAD));
+    const bool cleared = read_scratchpad(emu, 0x30, 0x31) && !(emu.alarmFlags() & OW_ALARM_SCRATCHPAD);
+    answers(emu, { OW_HANDLER_COMMAND_ASYNC, 0x40 }, { OW_CMD_ACK });
+    emu.processPending();
+    ok &= check("split-phase handler writes it: same",
+                cleared && emu.alarmed() && (emu.alarmFlags() & OW_ALARM_SCRATCHPAD));
+
+    hub.detach(emu);
+    return ok;
+}
+
+typedef FeatureEmulator<0, 1, 1, OW_CMD_UINT8> MinimalEmulator;
+static_assert(sizeof(MinimalEmulator) * 2 < sizeof(Emulator), "minimal configuration must not carry the full RAM");
+
+static bool feature_gating() {
+    MinimalEmulator emu(0x3A, 0x13, 0x00, 0x00, 0x00, 0x00, 0x01);
+    hub.attach(emu);
+
+    const uint8_t one = 1;
+    bool ok = check("core: typed frame still ACKed", answers(emu, variable_frame(OW_CMD_UINT8, &one, 1), { OW_CMD_ACK }) &&
+                                                      emu.pending() == 1);
+    const uint8_t handler[] = { OW_HANDLER_COMMAND, 0x40 };
+    const uint8_t sequenced[] = { OW_LOW_CMD_SEQUENCED, 0x01, OW_LOW_CMD_CAPABILITIES };
+    const uint8_t alarm[] = { OW_LOW_CMD_ALARM, 0xFF };
+    const uint8_t stats[] = { OW_LOW_CMD_READ_STATS, 0x00 };
+    ok &= check("handler, sequenced, alarm and stats commands get no reply",
+                answers(emu, std::vector<uint8_t>(handler, handler + 2), {}) &&
+                answers(emu, std::vector<uint8_t>(sequenced, sequenced + 3), {}) &&
+                answers(emu, std::vector<uint8_t>(alarm, alarm + 2), {}) &&
+                answers(emu, std::vector<uint8_t>(stats, stats + 2), {}));
+
+    const uint8_t caps = OW_LOW_CMD_CAPABILITIES;
+    hub.simTransaction(emu, &caps, 1);
+    const uint8_t *reply = hub.simSlaveOutput();
+    ok &= check("capabilities list no left-out feature",
+                hub.simSlaveOutputLen() == 7 && reply[1] == 0 && reply[2] == 0 && reply[3] == 1 &&
+                reply[6] == OWXCrc8::compute(reply, 6));
+
+    hub.detach(emu);
+
+    typedef FeatureEmulator<OW_FEATURE_HANDLERS | OW_FEATURE_SHARED_HANDLERS, 1, 1, OW_CMD_UINT8> SharedEmulator;
+    typedef FeatureEmulator<OW_FEATURE_HANDLERS, 1, 1, OW_CMD_UINT8> OwnEmulator;
+    static_assert(sizeof(SharedEmulator) + sizeof(OWXHandlerTable) == sizeof(OwnEmulator),
+                  "a shared-handler instance must not carry a table");
+    SharedEmulator a(0x3A, 0x16, 0x00, 0x00, 0x00, 0x00, 0x01), b(0x3A, 0x17, 0x00, 0x00, 0x00, 0x00, 0x01);
+    OwnEmulator own(0x3A, 0x18, 0x00, 0x00, 0x00, 0x00, 0x01);
+    hub.attach(a);
+    hub.attach(b);
+    hub.attach(own);
+    a.addHandler(0x40, [](uint8_t) { return true; });
+    const std::vector<uint8_t> run = { OW_HANDLER_COMMAND, 0x40 };
+    ok &= check("handler added on one shared instance runs for the other", answers(b, run, { OW_CMD_ACK }));
+    ok &= check("an instance with its own table doesn't have it", !answers(own, run, { OW_CMD_ACK }));
+    hub.detach(a);
+    hub.detach(b);
+    hub.detach(own);
+    return ok;
+}
+
+int main() {
+    Serial.simMute(true);
+    bool ok = true;
+    printf("Struct destinations:\n");
+    ok &= struct_not_overwritten();
+    ok &= struct_callbacks();
+    printf("Batch limits:\n");
+    ok &= oversize_batch();
+    ok &= oversize_varint();
+    printf("Scratchpad publishing:\n");
+    ok &= scratchpad_publishing();
+    printf("Changed reads:\n");
+    ok &= lost_changed_replies();
+    printf("Alarm latches:\n");
+    ok &= alarm_latches();
+    printf("Feature gating:\n");
+    ok &= feature_gating();
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,202 @@
+/*
+    OWX capture / replay test
+
+    Records a session on the host hub that has what field traces are made of: good frames, a
+    CRC error, a frame cut short by a reset (recv timeout), a sequenced frame resent after a
+    lost ACK plus a REPLAY, a handler command, a batch, an overdrive transaction and one for
+    another device. Then:
+
+        - the .owxcap text round trip keeps every byte, direction and time
+        - replaying it through a fresh emulator with the same setup matches byte for byte, twice
+        - replaying it through an emulator without the handler reports the mismatch
+        - the capture exported as a VCD waveform and decoded again replays the same
+        - a logic analyzer style CSV of it imports and replays the same
+
+    Run with ctest, or directly: ./build/owx_replay_test
+*/
+#include <OWX_Slave_Emulator.h>
+#include <OWX_Capture.h>
+#include <OWX_Replay.h>
+#include <stdio.h>
+#include <vector>
+
+#define ROM 0x3A, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06
+
+static OWXCapture recorded;
+static uint32_t session_us;
+
+static bool handler(uint8_t) { return true; }
+
+static void app_loop(EmulatorBase &emu) {
+    while (emu.available()) emu.clearAvailable();
+}
+
+static std::vector<uint8_t> variable_frame(uint8_t cmd, const void *payload, uint8_t len) {
+    std::vector<uint8_t> f = { OW_LOW_CMD_SEND_VARIABLE_, cmd, len };
+    f.insert(f.end(), (const uint8_t *)payload, (const uint8_t *)payload + len);
+    f.push_back(OWXCrc8::compute(&f[1], 2 + len));
+    return f;
+}
+
+// One poll() of the master script rom_cmd + ROM + tx, added to the capture
+static void record(OneWireHub &hub, uint8_t rom_cmd, const uint8_t *rom, std::vector<uint8_t> tx) {
+    hub.simClear();
+    hub.simMasterWrite(rom_cmd);
+    hub.simMasterWrite(rom, 8);
+    hub.simMasterWrite(tx.data(), tx.size());
+    const bool od = hub.simOverdrive();
+    hub.poll();
+    recorded.addFromHub(hub, session_us, od);
+    session_us += hub.simBusTimeUs() + 1500;
+}
+
+static void record_session() {
+    OneWireHub hub(2);
+    hub.simEnableOverdrive(true);
+    Emulator emu(ROM);
+    Emulator other(0x3A, 0x09, 0x09, 0x09, 0x09, 0x09, 0x09);
+    emu.setCustomHandler(handler);
+    hub.attach(emu);
+    hub.attach(other);
+
+    int16_t i16 = -1234;
+    float f = 21.5f;
+    int32_t i32 = 700000;
+    record(hub, ONEWIRE_CMD_MATCH_ROM, emu.ID, variable_frame(OW_CMD_INT16, &i16, 2));
+
+    std::vector<uint8_t> bad = variable_frame(OW_CMD_FLOAT32, &f, 4);
+    bad.back() ^= 0x5A;
+    record(hub, ONEWIRE_CMD_MATCH_ROM, emu.ID, bad);
+
+    std::vector<uint8_t> cut = variable_frame(OW_CMD_INT32, &i32, 4);
+    cut.resize(5);   // reset after two payload bytes
+    record(hub, ONEWIRE_CMD_MATCH_ROM, emu.ID, cut);
+
+    std::vector<uint8_t> seq = { OW_LOW_CMD_SEQUENCED, 0x05 };
+    std::vector<uint8_t> frame = variable_frame(OW_CMD_INT32, &i32, 4);
+    seq.insert(seq.end(), frame.begin(), frame.end());
+    record(hub, ONEWIRE_CMD_MATCH_ROM, emu.ID, seq);
+    record(hub, ONEWIRE_CMD_MATCH_ROM, emu.ID, seq);   // ACK lost, resent
+    record(hub, ONEWIRE_CMD_MATCH_ROM, emu.ID, { OW_LOW_CMD_REPLAY, 0x05 });
+
+    record(hub, ONEWIRE_CMD_MATCH_ROM, emu.ID, { OW_HANDLER_COMMAND, 0x42 });
+
+    uint8_t batch[2 * 4];
+    for (uint8_t i = 0; i < 2; i++) {
+        int16_t v = (int16_t)(100 * i);
+        batch[i * 4] = OW_CMD_INT16;
+        batch[i * 4 + 1] = 2;
+        memcpy(&batch[i * 4 + 2], &v, 2);
+    }
+    record(hub, ONEWIRE_CMD_MATCH_ROM, emu.ID, variable_frame(OW_CMD_BATCH, batch, sizeof(batch)));
+    record(hub, ONEWIRE_CMD_MATCH_ROM, other.ID, variable_frame(OW_CMD_INT16, &i16, 2));
+
+    int8_t i8 = -7;
+    record(hub, ONEWIRE_CMD_OD_MATCH_ROM, emu.ID, variable_frame(OW_CMD_INT8, &i8, 1));
+    record(hub, ONEWIRE_CMD_OD_MATCH_ROM, emu.ID, { OW_LOW_CMD_CAPABILITIES });
+    hub.simStandardReset();
+    record(hub, ONEWIRE_CMD_MATCH_ROM, emu.ID, { OW_READ_SCRATCHPAD });
+    app_loop(emu);
+}
+
+static std::vector<OWXReplayResult> replay(const OWXCapture &capture, bool with_handler, uint32_t *timeouts = nullptr) {
+    OneWireHub hub(2);
+    Emulator emu(ROM);
+    if (with_handler) emu.setCustomHandler(handler);
+    hub.attach(emu);
+    std::vector<OWXReplayResult> results = OWXReplay::run(capture, hub, emu, app_loop);
+    if (timeouts) *timeouts = emu.getStats().events[OWX_STAT_TIMEOUTS];
+    return results;
+}
+
+// Replayed and skipped transactions, mismatched ones
+static void summarize(const std::vector<OWXReplayResult> &results, uint32_t &replayed, uint32_t &mismatched) {
+    replayed = mismatched = 0;
+    for (const OWXReplayResult &r : results) {
+        if (r.skipped) continue;
+        replayed++;
+        if (r.mismatches) mismatched++;
+    }
+}
+
+static bool same_bytes(const OWXCapture &a, const OWXCapture &b, bool compare_dir_time) {
+    if (a.transactions.size() != b.transactions.size()) return false;
+    for (size_t i = 0; i < a.transactions.size(); i++) {
+        const OWXCaptureTransaction &x = a.transactions[i], &y = b.transactions[i];
+        if (x.overdrive != y.overdrive || x.bytes.size() != y.bytes.size()) return false;
+        if (compare_dir_time && x.t_us != y.t_us) return false;
+        for (size_t k = 0; k < x.bytes.size(); k++) {
+            if (x.bytes[k].value != y.bytes[k].value) return false;
+            if (compare_dir_time && (x.bytes[k].dir != y.bytes[k].dir || x.bytes[k].t_us != y.bytes[k].t_us)) return false;
+        }
+    }
+    return true;
+}
+
+// Rows the way a logic analyzer's 1-Wire table lists them
+static bool write_csv(const OWXCapture &capture, const char *path) {
+    FILE *out = fopen(path, "w");
+    if (out == nullptr) return false;
+    fprintf(out, "Time [s],Type,Data\n");
+    for (const OWXCaptureTransaction &t : capture.transactions) {
+        fprintf(out, "%.6f,%s,\n", t.t_us / 1e6, t.overdrive ? "Reset (overdrive)" : "Reset");
+        fprintf(out, "%.6f,Presence,\n", (t.t_us + 500) / 1e6);
+        for (const OWXCaptureByte &b : t.bytes)
+            fprintf(out, "%.6f,%s,0x%02X\n", b.t_us / 1e6, b.dir == OWX_CAPTURE_SLAVE ? "Read" : "Write", b.value);
+    }
+    return fclose(out) == 0;
+}
+
+static bool check(const char *what, bool ok) {
+    printf("  %-58s %s\n", what, ok ? "ok" : "FAILED");
+    return ok;
+}
+
+int main() {
+    Serial.simMute(true);
+    record_session();
+    printf("Recorded %u transactions\n", (unsigned)recorded.transactions.size());
+
+    bool ok = true;
+    const char *text_path = "owx_replay_test.owxcap";
+    const char *vcd_path = "owx_replay_test.vcd";
+    const char *csv_path = "owx_replay_test.csv";
+
+    OWXCapture text;
+    ok &= check("text format round trip", recorded.save(text_path) && text.load(text_path) &&
+                                              same_bytes(recorded, text, true));
+
+    uint32_t replayed, mismatched, timeouts;
+    std::vector<OWXReplayResult> first = replay(text, true, &timeouts);
+    summarize(first, replayed, mismatched);
+    ok &= check("replay matches (11 replayed, other ROM skipped)", replayed == 11 && mismatched == 0);
+    ok &= check("cut frame replays as a recv timeout", timeouts == 1 && first[2].response.empty());
+
+    std::vector<OWXReplayResult> second = replay(text, true);
+    bool deterministic = second.size() == first.size();
+    for (size_t i = 0; deterministic && i < first.size(); i++)
+        deterministic = first[i].response == second[i].response && first[i].mismatches == second[i].mismatches;
+    ok &= check("second replay answers the same", deterministic);
+
+    std::vector<OWXReplayResult> changed = replay(text, false);
+    summarize(changed, replayed, mismatched);
+    ok &= check("emulator without the handler: one mismatch, at its reply", mismatched == 1 && changed[6].mismatches &&
+                                                                          changed[6].firstMismatch == 11);
+
+    OWXCapture vcd;
+    ok &= check("VCD export decodes to the same bytes", recorded.exportVcd(vcd_path) && vcd.importVcd(vcd_path) &&
+                                                           same_bytes(recorded, vcd, false));
+    summarize(replay(vcd, true), replayed, mismatched);
+    ok &= check("VCD capture (direction unknown) replays", replayed == 11 && mismatched == 0);
+
+    OWXCapture csv;
+    ok &= check("CSV import keeps bytes, directions and times", write_csv(recorded, csv_path) &&
+                                                                  csv.importCsv(csv_path) && same_bytes(recorded, csv, true));
+    summarize(replay(csv, true), replayed, mismatched);
+    ok &= check("CSV capture replays", replayed == 11 && mismatched == 0);
+
+    remove(text_path);
+    remove(vcd_path);
+    remove(csv_path);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,297 @@
+/*
+    OWX slave timing test (host timing simulation)
+
+    A 1-Wire master drives every time slot; the slave only keeps up if the CPU time duty()
+    spends between two bus operations fits what the master allows (see OWX CAPABILITIES AND
+    OVERDRIVE in OWX_Slave_Emulator.h):
+
+        turnaround  last byte of a command → first reply byte    ≤ OW_TURNAROUND_US
+        byte gap    any other two consecutive bus operations      ≤ OW_BYTE_GAP_US
+
+    The simulated hub timestamps every send() / recv() inside duty(). Host time is scaled to
+    the slowest supported target with TIMING_SLOWDOWN (how many times longer an ESP8266 at
+    80 MHz runs the same code than the build host; conservative default). Each command runs
+    TIMING_RUNS times and the fastest run counts, so scheduler noise doesn't fail the test.
+
+    It also moves a 4 KB bulk transfer at standard and at overdrive speed and reports the bus
+    time of both, turnaround waits included.
+
+    Run with ctest, or directly: ./build/owx_timing_test
+*/
+#include <OWX_Slave_Emulator.h>
+#include <stdio.h>
+#include <vector>
+#include <chrono>
+
+#ifndef TIMING_SLOWDOWN
+#define TIMING_SLOWDOWN 100.0
+#endif
+#define TIMING_RUNS 300
+#define TIMING_MIN_OD_GAIN 5.0   // bulk throughput overdrive / standard the test insists on
+
+static OneWireHub hub(2);
+static Emulator emu(0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07);
+static double ticks_per_us;
+static uint64_t clock_overhead;   // ticks between two back-to-back simClock() reads
+
+struct Setpoints {
+    float low;
+    float high;
+    int16_t offset;
+    uint16_t period;
+};
+static Setpoints setpoints;
+static int16_t samples[64];
+static float live_temp = 21.5f;
+static uint8_t bulk_buf[4096];
+static OWXSampleFifo<32> fifo;
+
+static bool handler(uint8_t cmd) {
+    emu.writeScratchpad_uint8(cmd, 0);
+    return true;
+}
+
+// simClock() ticks per microsecond of the build host; the busy wait before it also
+// brings the host CPU up to speed so the first commands aren't measured at idle clock
+static double calibrate() {
+    auto t0 = std::chrono::steady_clock::now();
+    while (std::chrono::steady_clock::now() - t0 < std::chrono::milliseconds(200)) {}
+    t0 = std::chrono::steady_clock::now();
+    uint64_t c0 = OneWireHub::simClock();
+    while (std::chrono::steady_clock::now() - t0 < std::chrono::milliseconds(20)) {}
+    uint64_t c1 = OneWireHub::simClock();
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+
+    clock_overhead = ~0ULL;
+    for (int i = 0; i < 1000; i++) {
+        uint64_t a = OneWireHub::simClock();
+        uint64_t b = OneWireHub::simClock();
+        if (b - a < clock_overhead) clock_overhead = b - a;
+    }
+    return (c1 - c0) / us;
+}
+
+// Host ticks of one gap → microseconds on the target, without the cost of timestamping it
+static double target_us(uint64_t ticks) {
+    ticks = ticks > clock_overhead ? ticks - clock_overhead : 0;
+    return ticks / ticks_per_us * TIMING_SLOWDOWN;
+}
+
+static std::vector<uint8_t> variable_frame(uint8_t cmd, const void *payload, uint8_t len) {
+    std::vector<uint8_t> f = { OW_LOW_CMD_SEND_VARIABLE_, cmd, len };
+    const uint8_t *p = static_cast<const uint8_t *>(payload);
+    f.insert(f.end(), p, p + len);
+    f.push_back(OWXCrc8::compute(&f[1], 2 + len));
+    return f;
+}
+
+static std::vector<uint8_t> with_crc(std::vector<uint8_t> f) {
+    f.push_back(OWXCrc8::compute(&f[1], f.size() - 1));
+    return f;
+}
+
+// Loop-side work between two transactions of a case, so every run takes the same path
+static void drain() {
+    while (emu.available()) emu.clearAvailable();
+    emu.processPending();
+}
+
+static bool check(const char *name, const std::vector<uint8_t> &tx) {
+    uint64_t turnaround = ~0ULL, byte_gap = ~0ULL;
+    size_t reply_len = 0;
+
+    for (int run = 0; run < TIMING_RUNS; run++) {
+        hub.simTransaction(emu, tx.data(), tx.size());
+        reply_len = hub.simSlaveOutputLen();
+        if (hub.simMaxTurnaround() < turnaround) turnaround = hub.simMaxTurnaround();
+        if (hub.simMaxByteGap() < byte_gap) byte_gap = hub.simMaxByteGap();
+        drain();
+    }
+
+    const double turn_us = target_us(turnaround);
+    const double gap_us = target_us(byte_gap);
+    const bool ok = reply_len > 0 && turn_us <= OW_TURNAROUND_US && gap_us <= OW_BYTE_GAP_US;
+    printf("  %-28s turnaround %6.2f us   byte gap %5.2f us   %s\n", name, turn_us, gap_us,
+           ok ? "" : (reply_len ? "(OVER BUDGET)" : "(NO REPLY)"));
+    return ok;
+}
+
+// One 4 KB transfer in windows of 8 chunks; returns bus time, false in ok if it didn't arrive.
+// gap[i] keeps the smallest max byte gap transaction i has shown so far.
+static uint32_t bulk_transfer(const uint8_t *src, bool overdrive, bool &ok, std::vector<uint64_t> &gap) {
+    const uint16_t total = sizeof(bulk_buf);
+    const uint16_t crc16 = OWXCrc16::compute(src, total);
+    std::vector<std::vector<uint8_t>> script;
+    script.push_back(with_crc({ OW_LOW_CMD_BULK_BEGIN, (uint8_t)total, (uint8_t)(total >> 8),
+                                (uint8_t)crc16, (uint8_t)(crc16 >> 8) }));
+    const uint16_t chunks = total / OW_BULK_CHUNK_SIZE;
+    for (uint16_t first = 0; first < chunks; first += 8) {
+        std::vector<uint8_t> t;
+        // Chunks of a window arrive last-first, so each window folds 8 chunks at once
+        for (int seq = first + 7; seq >= first; seq--) {
+            const uint8_t *data = &src[seq * OW_BULK_CHUNK_SIZE];
+            t.push_back(OW_LOW_CMD_BULK_CHUNK);
+            t.push_back((uint8_t)seq);
+            t.push_back(OW_BULK_CHUNK_SIZE);
+            t.insert(t.end(), data, data + OW_BULK_CHUNK_SIZE);
+            t.push_back(OWXCrc8::compute(&t[t.size() - OW_BULK_CHUNK_SIZE - 2], OW_BULK_CHUNK_SIZE + 2));
+        }
+        t.push_back(OW_LOW_CMD_BULK_STATUS);
+        t.push_back((uint8_t)first);
+        t.push_back(8);
+        script.push_back(t);
+    }
+
+    emu.clearBulk();
+    uint32_t bus_us = 0;
+    gap.resize(script.size(), ~0ULL);
+    for (size_t i = 0; i < script.size(); i++) {
+        if (overdrive) hub.simTransactionOverdrive(emu, script[i].data(), script[i].size());
+        else hub.simTransaction(emu, script[i].data(), script[i].size());
+        bus_us += hub.simBusTimeUs();
+        if (hub.simMaxByteGap() < gap[i]) gap[i] = hub.simMaxByteGap();
+    }
+    // END answers BUSY while the CRC16 check catches up with the last window
+    const uint8_t end = OW_LOW_CMD_BULK_END;
+    for (int tries = 0; tries < 16; tries++) {
+        if (overdrive) hub.simTransactionOverdrive(emu, &end, 1);
+        else hub.simTransaction(emu, &end, 1);
+        bus_us += hub.simBusTimeUs();
+        if (hub.simSlaveOutputLen() != 1 || hub.simSlaveOutput()[0] != OW_CMD_BUSY) break;
+    }
+    ok = emu.bulkAvailable() && memcmp(bulk_buf, src, total) == 0;
+    return bus_us;
+}
+
+static bool check_bulk() {
+    static uint8_t src[sizeof(bulk_buf)];
+    for (size_t i = 0; i < sizeof(src); i++) src[i] = (uint8_t)random(256);
+
+    // Byte gaps: fastest run of each transaction, worst transaction
+    bool ok = true, arrived;
+    std::vector<uint64_t> gap;
+    for (int run = 0; run < TIMING_RUNS / 10; run++) {
+        bulk_transfer(src, false, arrived, gap);
+        ok &= arrived;
+    }
+    uint64_t worst = 0;
+    for (uint64_t g : gap) worst = g > worst ? g : worst;
+    const double gap_us = target_us(worst);
+    ok &= gap_us <= OW_BYTE_GAP_US;
+    printf("  %-28s                       byte gap %5.2f us   %s\n", "BULK 4 KB (out of order)", gap_us,
+           ok ? "" : "(OVER BUDGET)");
+
+    // Throughput: standard vs overdrive bus time for the same transfer
+    hub.simStandardReset();
+    gap.clear();
+    const uint32_t std_us = bulk_transfer(src, false, arrived, gap);
+    ok &= arrived;
+    const uint32_t od_us = bulk_transfer(src, true, arrived, gap);
+    ok &= arrived && hub.simOverdrive();
+    hub.simStandardReset();
+
+    const double gain = (double)std_us / od_us;
+    ok &= gain >= TIMING_MIN_OD_GAIN;
+    printf("Bulk 4 KB bus time: standard %.1f ms (%.1f kbit/s), overdrive %.1f ms (%.1f kbit/s), %.1fx %s\n",
+           std_us / 1000.0, sizeof(src) * 8.0 / std_us * 1000.0, od_us / 1000.0, sizeof(src) * 8.0 / od_us * 1000.0,
+           gain, ok ? "" : "(FAILED)");
+    return ok;
+}
+
+static bool check_overdrive_flow() {
+    const std::vector<uint8_t> caps = { OW_LOW_CMD_CAPABILITIES };
+    bool ok = true;
+
+    // Not advertised and not accepted until both sides enable it
+    hub.simTransaction(emu, caps.data(), caps.size());
+    const uint8_t *r = hub.simSlaveOutput();
+    ok &= hub.simSlaveOutputLen() == 7 && OWXCrc8::compute(r, 6) == r[6] && r[0] == OW_PROTOCOL_VERSION &&
+          !(r[1] & OW_CAP_OVERDRIVE) && r[3] == OW_MAX_PAYLOAD && r[5] == OW_TURNAROUND_US;
+    ok &= !hub.simTransactionOverdrive(emu, caps.data(), caps.size()) && !hub.simOverdrive();
+
+    emu.setOverdrive(true);
+    hub.simEnableOverdrive(true);
+    hub.simTransaction(emu, caps.data(), caps.size());
+    ok &= hub.simSlaveOutputLen() == 7 && (hub.simSlaveOutput()[1] & OW_CAP_OVERDRIVE);
+    ok &= hub.simTransactionOverdrive(emu, caps.data(), caps.size()) && hub.simOverdrive() &&
+          hub.simSlaveOutputLen() == 7;
+
+    // Stays in overdrive for plain MATCH ROM until a standard reset
+    const uint32_t od_us = hub.simBusTimeUs();
+    hub.simTransaction(emu, caps.data(), caps.size());
+    ok &= hub.simOverdrive() && hub.simBusTimeUs() < od_us;
+    hub.simStandardReset();
+    hub.simTransaction(emu, caps.data(), caps.size());
+    ok &= !hub.simOverdrive() && hub.simBusTimeUs() > od_us;
+
+    printf("Overdrive negotiation (capabilities, 0x69, standard reset)  %s\n", ok ? "ok" : "FAILED");
+    return ok;
+}
+
+int main() {
+    Serial.simMute(true);
+    ticks_per_us = calibrate();
+    hub.attach(emu);
+    hub.simSetTurnaroundUs(OW_TURNAROUND_US);
+    emu.setCustomHandler(handler);
+    emu.registerStruct(0x01, &setpoints);
+    emu.registerArray(0x02, samples, 64);
+    emu.bindVariable(0x10, &live_temp);
+    emu.bindVariable(0x11, &setpoints);
+    emu.setBulkBuffer(bulk_buf, sizeof(bulk_buf));
+    emu.useSampleFifo(fifo);
+    for (uint8_t i = 0; i < 16; i++) emu.pushSample(1, (int16_t)(2000 + i), 1000u * i);
+
+    bool ok = check_overdrive_flow();
+
+    printf("Slave timing per command, scaled x%.0f to the target (budget: turnaround %d us, byte gap %d us):\n",
+           TIMING_SLOWDOWN, OW_TURNAROUND_US, OW_BYTE_GAP_US);
+
+    int32_t i32 = -123456;
+    float f = 21.5f;
+    ok &= check("SEND_VARIABLE INT32", variable_frame(OW_CMD_INT32, &i32, 4));
+    ok &= check("SEND_VARIABLE FLOAT32", variable_frame(OW_CMD_FLOAT32, &f, 4));
+
+    uint8_t record[1 + sizeof(Setpoints)] = { 0x01 };
+    ok &= check("SEND_VARIABLE STRUCT (12 B)", variable_frame(OW_CMD_STRUCT, record, sizeof(record)));
+
+    uint8_t batch[5 * 6];
+    for (uint8_t i = 0; i < 5; i++) {
+        batch[i * 6] = OW_CMD_FLOAT32;
+        batch[i * 6 + 1] = 4;
+        memcpy(&batch[i * 6 + 2], &f, 4);
+    }
+    ok &= check("SEND_VARIABLE BATCH (5 float)", variable_frame(OW_CMD_BATCH, batch, sizeof(batch)));
+
+    uint8_t array[OW_MAX_PAYLOAD] = { 0x02, OW_ARRAY_DELTA_VARINT, 0, 0 };
+    uint8_t data_len;
+    for (uint8_t i = 0; i < 64; i++) samples[i] = (int16_t)(2150 + i / 4);
+    array[3] = owx_array_encode(samples, 64, OW_ARRAY_DELTA_VARINT, &array[4], OW_MAX_PAYLOAD - 4, data_len);
+    ok &= check("SEND_VARIABLE ARRAY (delta)", variable_frame(OW_CMD_ARRAY_INT16, array, 4 + data_len));
+
+    uint8_t bad[4] = { 1, 2, 3, 4 };
+    std::vector<uint8_t> bad_crc = variable_frame(OW_CMD_INT32, bad, 4);
+    bad_crc.back() ^= 0xFF;
+    ok &= check("SEND_VARIABLE bad CRC (NACK)", bad_crc);
+
+    std::vector<uint8_t> seq = variable_frame(OW_CMD_INT32, &i32, 4);
+    seq.insert(seq.begin(), { OW_LOW_CMD_SEQUENCED, 0x21 });
+    ok &= check("SEQUENCED (replayed)", seq);
+    ok &= check("REPLAY", { OW_LOW_CMD_REPLAY, 0x21 });
+
+    ok &= check("READ_SCRATCHPAD", { OW_READ_SCRATCHPAD });
+    ok &= check("READ_SCRATCHPAD_RANGE", { OW_READ_SCRATCHPAD_RANGE, 0, 4 });
+    ok &= check("READ_SCRATCHPAD_CHANGED", { OW_READ_SCRATCHPAD_CHANGED, 0 });
+    ok &= check("READ_VARIABLES (float+12B)", with_crc({ OW_LOW_CMD_READ_VARIABLES, 2, 0x10, 0x11 }));
+    ok &= check("DRAIN_SAMPLES (16)", with_crc({ OW_LOW_CMD_DRAIN_SAMPLES, 16, 0, 0 }));
+    ok &= check("HANDLER", { OW_HANDLER_COMMAND, 0x42 });
+    ok &= check("HANDLER_ASYNC", { OW_HANDLER_COMMAND_ASYNC, 0x42 });
+    ok &= check("HANDLER_STATUS", { OW_HANDLER_STATUS });
+    ok &= check("ALARM", { OW_LOW_CMD_ALARM, 0 });
+    ok &= check("CAPABILITIES", { OW_LOW_CMD_CAPABILITIES });
+    ok &= check("READ_STATS", { OW_LOW_CMD_READ_STATS, 0 });
+
+    ok &= check_bulk();
+
+    return ok ? 0 : 1;
+}
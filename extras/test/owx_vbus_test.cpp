@@ -0,0 +1,209 @@
+/*
+    OWX virtual bus test
+
+    Starts owx_busd (--fast) and six slave processes on it: five with one Emulator each, one
+    with two Emulators on one hub that accepts overdrive. Three of the seven devices raise
+    their user alarm. The test process is the master:
+
+        - a ROM search finds all seven ROMs, the conditional search exactly the alarmed ones
+        - the reference scheduler (OWXMaster) polls every slave's bound variable and delivers a
+          setpoint to each; a second poll reads the setpoint back from the slave process
+        - OVERDRIVE MATCH ROM reaches the overdrive device, CAPABILITIES answers at overdrive
+        - MATCH ROM of an unknown ROM gets presence but only idle (0xFF) read slots
+        - READ ROM with seven devices on the bus is counted as a collision
+        - the daemon's report has the utilization and a latency for every device, and every
+          slave process exits cleanly when the daemon shuts down
+
+    Run with ctest, or directly: ./build/owx_vbus_test ./build/owx_busd
+*/
+#include <OWX_Slave_Emulator.h>
+#include <OWX_Master.h>
+#include <OWX_VBusMaster.h>
+#include <OWX_VBusSlave.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+#define PROCESSES 6
+#define DEVICES   7
+
+static char socket_path[64];
+
+static struct {
+    uint32_t value;     // bound as 0x10
+    int16_t setpoint;   // bound as 0x11, written by the master
+} data;
+
+static void on_setpoint(int16_t value) { data.setpoint = value; }
+
+static void rom_of(uint8_t n, uint8_t rom[8]) {
+    const uint8_t id[7] = { 0x3A, 0x7E, 0x57, n, 0x00, 0x00, 0x01 };
+    memcpy(rom, id, 7);
+    rom[7] = OneWireItem::crc8(rom, 7);
+}
+
+static bool alarmed_device(uint8_t n) { return n % 3 == 0; }
+
+// Slave process p: device p, and on the last one also device p + 1 on the same hub
+static int slave_process(uint8_t p) {
+    OneWireHub hub(2);
+    Emulator a(0x3A, 0x7E, 0x57, p, 0x00, 0x00, 0x01);
+    Emulator b(0x3A, 0x7E, 0x57, (uint8_t)(p + 1), 0x00, 0x00, 0x01);
+    const bool two = p == PROCESSES - 1;
+
+    data.value = 1000u + p;
+    a.bindVariable(0x10, &data.value);
+    a.bindVariable(0x11, &data.setpoint);
+    a.onReceive(on_setpoint);
+    if (alarmed_device(p)) a.raiseAlarm();
+    hub.attach(a);
+    if (two) {
+        hub.simEnableOverdrive(true);
+        b.setOverdrive(true);
+        if (alarmed_device(p + 1)) b.raiseAlarm();
+        hub.attach(b);
+    }
+
+    OWXVBusSlave link;
+    for (int tries = 0; !link.connect(hub, socket_path); tries++) {
+        if (tries == 200) return 1;
+        usleep(10000);
+    }
+    while (link.connected()) {
+        if (hub.poll()) a.dispatchPending();
+    }
+    return 0;
+}
+
+static bool check(const char *what, bool ok) {
+    printf("  %-62s %s\n", what, ok ? "ok" : "FAILED");
+    return ok;
+}
+
+static bool same_roms(uint8_t found[][8], uint8_t count, bool (*expected)(uint8_t)) {
+    uint8_t want = 0;
+    for (uint8_t n = 0; n < DEVICES; n++) {
+        if (!expected(n)) continue;
+        want++;
+        uint8_t rom[8];
+        rom_of(n, rom);
+        bool seen = false;
+        for (uint8_t i = 0; i < count; i++) seen |= memcmp(found[i], rom, 8) == 0;
+        if (!seen) return false;
+    }
+    return want == count;
+}
+
+static bool every_device(uint8_t) { return true; }
+
+static bool run_master() {
+    OWXVBusMaster bus;
+    for (int tries = 0; !bus.connect(socket_path); tries++) {
+        if (tries == 200) return check("master connects to owx_busd", false);
+        usleep(10000);
+    }
+    bool ok = check("seven devices in six processes attach", bus.waitDevices(DEVICES, 5000) && bus.devices() == DEVICES);
+
+    uint8_t roms[16][8];
+    uint8_t found = bus.search(ONEWIRE_CMD_SEARCH_ROM, roms, 16);
+    ok &= check("search ROM finds every device", same_roms(roms, found, every_device));
+    found = bus.search(ONEWIRE_CMD_ALARM_SEARCH, roms, 16);
+    ok &= check("conditional search finds the alarmed ones", same_roms(roms, found, alarmed_device));
+
+    // Reference scheduler over the single-device processes: poll, write, poll again
+    OWXMaster master(bus);
+    uint32_t values[PROCESSES - 1] = {};
+    int16_t setpoints[PROCESSES - 1] = {};
+    for (uint8_t p = 0; p < PROCESSES - 1; p++) {
+        uint8_t rom[8];
+        rom_of(p, rom);
+        const int8_t s = master.addSlave(rom, 1, 100000);
+        master.pollVariable(s, 0x10, &values[p], sizeof(uint32_t));
+        master.pollVariable(s, 0x11, &setpoints[p], sizeof(int16_t));
+        master.write(s, (int16_t)(-200 - p));
+    }
+    const uint32_t end = bus.micros() + 2000000;
+    while ((int32_t)(bus.micros() - end) < 0) {
+        if (!master.service()) bus.idle(master.idleFor() ? master.idleFor() : 100);
+    }
+    bool polled = true;
+    for (uint8_t p = 0; p < PROCESSES - 1; p++) {
+        const OWXSlaveReport r = master.report(p);
+        polled &= r.polls >= 2 && r.pollErrors == 0 && r.writes == 1 && values[p] == 1000u + p &&
+                  setpoints[p] == -200 - p;
+    }
+    ok &= check("scheduler polls every slave and reads its setpoint back", polled);
+
+    uint8_t od_rom[8], reply[7];
+    rom_of(PROCESSES, od_rom);
+    const uint8_t od_match = ONEWIRE_CMD_OD_MATCH_ROM, capabilities = OW_LOW_CMD_CAPABILITIES;
+    bool od_ok = bus.reset();
+    bus.writeBytes(&od_match, 1);
+    bus.writeBytes(od_rom, 8);
+    bus.writeBytes(&capabilities, 1);
+    bus.readBytes(reply, sizeof(reply));
+    od_ok &= OWXCrc8::compute(reply, 6) == reply[6] && (reply[1] & OW_CAP_OVERDRIVE);
+    od_ok &= bus.reset(true);   // overdrive reset: still at overdrive speed
+    ok &= check("overdrive match ROM and capabilities at overdrive", od_ok);
+
+    uint8_t unknown[8];
+    rom_of(99, unknown);
+    uint8_t idle[4];
+    const bool present = bus.select(unknown);
+    bus.writeBytes(&capabilities, 1);
+    bus.readBytes(idle, sizeof(idle));
+    ok &= check("unknown ROM: presence, then idle read slots", present && idle[0] == 0xFF && idle[3] == 0xFF);
+
+    const uint8_t read_rom = ONEWIRE_CMD_READ_ROM;
+    bus.reset();
+    bus.writeBytes(&read_rom, 1);
+    bus.readBytes(idle, sizeof(idle));
+
+    const std::string report = bus.report();
+    printf("%s", report.c_str());
+    unsigned latencies = 0;
+    for (size_t at = report.find("\n3A7E57"); at != std::string::npos; at = report.find("\n3A7E57", at + 1)) latencies++;
+    ok &= check("report: utilization, collision and a row per device",
+                report.find("utilization") != std::string::npos && report.find(" 1 ROM collisions") != std::string::npos &&
+                latencies == DEVICES);
+    bus.shutdown();
+    return ok;
+}
+
+int main(int argc, char **argv) {
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s path/to/owx_busd\n", argv[0]);
+        return 2;
+    }
+    Serial.simMute(true);
+    snprintf(socket_path, sizeof(socket_path), "/tmp/owx_vbus_test_%d.sock", (int)getpid());
+
+    const pid_t daemon = fork();
+    if (daemon == 0) {
+        execl(argv[1], argv[1], "--socket", socket_path, "--fast", "--quiet", (char *)nullptr);
+        _exit(127);
+    }
+    std::vector<pid_t> slaves;
+    for (uint8_t p = 0; p < PROCESSES; p++) {
+        const pid_t pid = fork();
+        if (pid == 0) _exit(slave_process(p));
+        slaves.push_back(pid);
+    }
+
+    bool ok = run_master();
+
+    int status = 0;
+    bool clean = true;
+    for (pid_t pid : slaves) {
+        waitpid(pid, &status, 0);
+        clean &= WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    }
+    waitpid(daemon, &status, 0);
+    clean &= WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    ok &= check("slave processes and daemon exit cleanly", clean);
+    return ok ? 0 : 1;
+}
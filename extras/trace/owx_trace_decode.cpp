@@ -0,0 +1,112 @@
+/*
+    OWX trace decoder
+
+    Turns the binary records written by Emulator::drainTrace() (see OWX_Trace.h) into text,
+    one event per line with the time since the first event and since the previous one.
+
+    Capture the slave's serial output raw, then decode on the host:
+        cat /dev/ttyUSB0 > trace.bin          (or pio device monitor --raw > trace.bin)
+        ./build/owx_trace_decode --mhz 80 trace.bin
+
+    Bytes that are not part of a valid record (other Serial prints, line noise) are skipped;
+    the decoder resynchronizes on the next sync byte with a good CRC8.
+*/
+#include <OWX_Trace.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *event_name(uint8_t event) {
+    switch (event) {
+        case OWX_TRACE_LOW_CMD:         return "LOW_CMD";
+        case OWX_TRACE_FRAME_OK:        return "FRAME_OK";
+        case OWX_TRACE_CRC_ERROR:       return "CRC_ERROR";
+        case OWX_TRACE_OVERSIZE:        return "OVERSIZE";
+        case OWX_TRACE_TIMEOUT:         return "TIMEOUT";
+        case OWX_TRACE_UNHANDLED:       return "UNHANDLED";
+        case OWX_TRACE_REPLY:           return "REPLY";
+        case OWX_TRACE_SCRATCHPAD_READ: return "SCRATCHPAD_READ";
+        case OWX_TRACE_HANDLER:         return "HANDLER";
+        case OWX_TRACE_BULK:            return "BULK";
+        case OWX_TRACE_QUEUE_OVERFLOW:  return "QUEUE_OVERFLOW";
+        case OWX_TRACE_VARIABLE_READ:   return "VARIABLE_READ";
+        case OWX_TRACE_SAMPLE_DRAIN:    return "SAMPLE_DRAIN";
+        case OWX_TRACE_LOST:            return "LOST";
+        case OWX_TRACE_REPLAY:          return "REPLAY";
+        case OWX_TRACE_ALARM:           return "ALARM";
+        default:                        return "?";
+    }
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "usage: %s [--mhz CPU_MHZ] [file]   (default 80 MHz, stdin)\n", argv0);
+}
+
+int main(int argc, char **argv) {
+    double mhz = 80.0;
+    const char *path = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--mhz") == 0 && i + 1 < argc) {
+            mhz = atof(argv[++i]);
+        } else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+            usage(argv[0]);
+            return 2;
+        } else {
+            path = argv[i];
+        }
+    }
+    if (mhz <= 0) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    FILE *in = path ? fopen(path, "rb") : stdin;
+    if (in == nullptr) {
+        perror(path);
+        return 1;
+    }
+
+    uint8_t window[OWX_TRACE_RECORD_SIZE];
+    size_t fill = 0;
+    unsigned long records = 0, skipped = 0;
+    uint32_t prev = 0;
+    double elapsed = 0;   // accumulated from 32-bit deltas so cycle counter wrap is harmless
+    int c;
+
+    while ((c = fgetc(in)) != EOF) {
+        window[fill++] = (uint8_t)c;
+        if (window[0] != OWX_TRACE_SYNC) {
+            fill = 0;
+            skipped++;
+            continue;
+        }
+        if (fill < OWX_TRACE_RECORD_SIZE) continue;
+
+        OWXTraceEvent ev;
+        if (!owx_trace_decode(window, ev)) {
+            // False sync: drop one byte and look for the next sync inside the window
+            memmove(window, window + 1, --fill);
+            skipped++;
+            while (fill && window[0] != OWX_TRACE_SYNC) {
+                memmove(window, window + 1, --fill);
+                skipped++;
+            }
+            continue;
+        }
+        fill = 0;
+
+        if (records == 0) prev = ev.cycles;
+        uint32_t delta = ev.cycles - prev;
+        elapsed += delta;
+        prev = ev.cycles;
+
+        printf("%12.3f us  (+%9.3f)  %-16s cmd=0x%02X len=%u\n",
+               elapsed / mhz, delta / mhz, event_name(ev.event), ev.cmd, ev.len);
+        records++;
+    }
+
+    if (in != stdin) fclose(in);
+    fprintf(stderr, "%lu records, %lu bytes skipped\n", records, skipped);
+    return 0;
+}
@@ -0,0 +1,99 @@
+// Socket helpers of the virtual bus, see OWX_VBus.h
+#include "OWX_VBus.h"
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+bool owx_vbus_send(int fd, uint8_t type, const void *data, size_t len, uint32_t bus_us)
+{
+    if (len > OWX_VBUS_MAX_DATA) return false;
+    OWXVBusMsg msg;
+    msg.type = type;
+    msg.reserved = 0;
+    msg.len = (uint16_t)len;
+    msg.bus_us = bus_us;
+    if (len) memcpy(msg.data, data, len);
+    ssize_t n;
+    do {
+        n = send(fd, &msg, OWX_VBUS_HEADER + len, MSG_NOSIGNAL);
+    } while (n < 0 && errno == EINTR);
+    return n == (ssize_t)(OWX_VBUS_HEADER + len);
+}
+
+bool owx_vbus_recv(int fd, OWXVBusMsg &msg)
+{
+    ssize_t n;
+    do {
+        n = recv(fd, &msg, sizeof(msg), 0);
+    } while (n < 0 && errno == EINTR);
+    return n >= OWX_VBUS_HEADER && n == (ssize_t)(OWX_VBUS_HEADER + msg.len);
+}
+
+bool owx_vbus_wait(int fd, int timeout_ms)
+{
+    struct pollfd p = { fd, POLLIN, 0 };
+    int n;
+    do {
+        n = poll(&p, 1, timeout_ms);
+    } while (n < 0 && errno == EINTR);
+    return n > 0;
+}
+
+static bool owx_vbus_address(const char *path, struct sockaddr_un &addr)
+{
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        errno = ENAMETOOLONG;
+        return false;
+    }
+    strcpy(addr.sun_path, path);
+    return true;
+}
+
+int owx_vbus_connect(const char *path)
+{
+    struct sockaddr_un addr;
+    if (!owx_vbus_address(path, addr)) return -1;
+    const int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        const int err = errno;
+        close(fd);
+        errno = err;
+        return -1;
+    }
+    return fd;
+}
+
+int owx_vbus_listen(const char *path)
+{
+    struct sockaddr_un addr;
+    if (!owx_vbus_address(path, addr)) return -1;
+    const int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    unlink(path);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, SOMAXCONN) != 0) {
+        const int err = errno;
+        close(fd);
+        errno = err;
+        return -1;
+    }
+    return fd;
+}
+
+int owx_vbus_accept(int listen_fd)
+{
+    return accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+}
+
+uint64_t owx_vbus_now_us()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
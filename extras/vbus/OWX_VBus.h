@@ -0,0 +1,117 @@
+/*
+    OWX virtual 1-Wire bus: wire protocol between owx_busd and its clients
+
+    One daemon (owx_busd) is the wire. Slave processes attach their OneWireHub through
+    OWXVBusSlave (OWX_VBusSlave.h) and run unmodified Emulator code; one master process drives
+    the bus through OWXVBusMaster (OWX_VBusMaster.h). Everything goes over a Unix domain
+    SOCK_SEQPACKET socket, one message per packet:
+
+        [ TYPE | 0 | LEN (2, LSB first) | BUS_US (4, LSB first) | DATA (LEN bytes) ]
+
+    The daemon does the ROM layer itself: it knows every device's ROM from the slave's HELLO,
+    so a reset, a MATCH ROM or a search costs no slave round trip, and only the addressed
+    slave process sees the bytes of a transaction. Search arbitration is the wired-AND of the
+    participating ROMs, bit by bit; for the conditional search (0xEC) every slave process is
+    asked which of its devices are alarmed at the start of each pass.
+
+    Byte transfer: a master write goes to the selected slave at once. A master read takes the
+    bytes the slave has sent; while the slave has sent nothing yet, the daemon waits for it.
+    If the slave is waiting in recv() itself (NEED), the read slots are what they are on a real
+    wire: the slave sees 0xFF written and the master reads 0xFF. After duty() returned (DONE)
+    reads return 0xFF. A slave's send() does not wait for read slots; bytes the master never
+    reads are dropped at its next write or reset.
+
+    ┌──────────────────────────────────────────────────────────────────────────────┐
+    │ slave → daemon                                                               │
+    │  HELLO    FLAGS (bit 0: accepts overdrive) | COUNT | COUNT × ROM[8]          │
+    │  SEND     bytes the item drove in read slots, BUS_US = CLOCK_MONOTONIC µs    │
+    │           when sent (latency is measured against the daemon's DATA time)     │
+    │  NEED     CONSUMED (4): master bytes taken so far, item waits in recv()      │
+    │  DONE     duty() returned                                                    │
+    │  ALARMED  reply to QUERY: index in HELLO of every alarmed device             │
+    │ daemon → slave                                                               │
+    │  SELECT   ROM[8] | SPEED (1: overdrive): a transaction starts                │
+    │  DATA     master bytes                                                       │
+    │  RESET    the master reset the bus during the transaction                    │
+    │  QUERY    alarm state for a conditional search pass                          │
+    │ master → daemon, each answered with the same TYPE, BUS_US = bus clock after  │
+    │  HELLO    → FLAGS (bit 0: paced) | START_US (8): bus clock origin, paced mode │
+    │  DEVICES  → COUNT (2): devices attached                                      │
+    │  RESET    SPEED (1: overdrive reset) → PRESENCE                              │
+    │  WRITE    bytes                                                              │
+    │  READ     COUNT → COUNT bytes, 0xFF where nobody drove the bus               │
+    │  TRIPLET  DIR → ID_BIT | CMP_BIT | DIR_TAKEN (search, like DS2482-800)        │
+    │  IDLE     US (4): the master waits                                           │
+    │  REPORT   → report text                                                      │
+    │  SHUTDOWN daemon closes every connection and exits                           │
+    └──────────────────────────────────────────────────────────────────────────────┘
+
+    Paced (default): every bus operation takes at least its bus time (owx_busd measures wall
+    time against it), so a master sees a real bus's speed. owx_busd --fast runs operations back
+    to back on a simulated clock.
+*/
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef OWX_VBUS_SOCKET
+#define OWX_VBUS_SOCKET "/tmp/owx_vbus.sock"
+#endif
+
+#define OWX_VBUS_HEADER   8
+#define OWX_VBUS_MAX_DATA 16384
+#define OWX_VBUS_TIMEOUT_MS 5000   // a slave that doesn't answer within this is dropped
+
+// slave → daemon
+#define OWX_VBUS_S_HELLO    0x01
+#define OWX_VBUS_S_SEND     0x02
+#define OWX_VBUS_S_NEED     0x03
+#define OWX_VBUS_S_DONE     0x04
+#define OWX_VBUS_S_ALARMED  0x05
+// daemon → slave
+#define OWX_VBUS_D_SELECT   0x21
+#define OWX_VBUS_D_DATA     0x22
+#define OWX_VBUS_D_RESET    0x23
+#define OWX_VBUS_D_QUERY    0x24
+// master → daemon
+#define OWX_VBUS_M_HELLO    0x81
+#define OWX_VBUS_M_DEVICES  0x82
+#define OWX_VBUS_M_RESET    0x83
+#define OWX_VBUS_M_WRITE    0x84
+#define OWX_VBUS_M_READ     0x85
+#define OWX_VBUS_M_TRIPLET  0x86
+#define OWX_VBUS_M_IDLE     0x87
+#define OWX_VBUS_M_REPORT   0x88
+#define OWX_VBUS_M_SHUTDOWN 0x89
+
+#define OWX_VBUS_HELLO_OVERDRIVE 0x01
+#define OWX_VBUS_HELLO_PACED     0x01
+
+struct OWXVBusMsg {
+    uint8_t type;
+    uint8_t reserved;
+    uint16_t len;
+    uint32_t bus_us;
+    uint8_t data[OWX_VBUS_MAX_DATA];
+};
+
+// false: connection closed or broken
+bool owx_vbus_send(int fd, uint8_t type, const void *data, size_t len, uint32_t bus_us = 0);
+bool owx_vbus_recv(int fd, OWXVBusMsg &msg);
+
+// Waits up to timeout_ms (-1: forever) for a packet; false on timeout
+bool owx_vbus_wait(int fd, int timeout_ms);
+
+int owx_vbus_connect(const char *path);   // -1 on error, errno set
+int owx_vbus_listen(const char *path);
+int owx_vbus_accept(int listen_fd);
+
+uint64_t owx_vbus_now_us();   // CLOCK_MONOTONIC, shared by every process on the machine
+
+static inline void owx_vbus_put32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); p[2] = (uint8_t)(v >> 16); p[3] = (uint8_t)(v >> 24);
+}
+
+static inline uint32_t owx_vbus_get32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
@@ -0,0 +1,161 @@
+#include "OWX_VBusMaster.h"
+#include <OneWireHub.h>   // ROM command constants
+#include <string.h>
+#include <unistd.h>
+
+OWXVBusMaster::OWXVBusMaster() : fd(-1), paced(false), start_us(0), bus_us(0) {}
+
+OWXVBusMaster::~OWXVBusMaster()
+{
+    close();
+}
+
+bool OWXVBusMaster::connect(const char *path)
+{
+    close();
+    fd = owx_vbus_connect(path);
+    if (fd < 0) return false;
+    if (!request(OWX_VBUS_M_HELLO, nullptr, 0) || msg.len != 9) {
+        close();
+        return false;
+    }
+    paced = msg.data[0] & OWX_VBUS_HELLO_PACED;
+    start_us = (uint64_t)owx_vbus_get32(&msg.data[1]) | ((uint64_t)owx_vbus_get32(&msg.data[5]) << 32);
+    return true;
+}
+
+void OWXVBusMaster::close()
+{
+    if (fd >= 0) ::close(fd);
+    fd = -1;
+}
+
+// One request, its reply in msg; false (and closed) when the daemon is gone
+bool OWXVBusMaster::request(uint8_t type, const void *data, size_t len)
+{
+    if (fd < 0) return false;
+    if (!owx_vbus_send(fd, type, data, len) || !owx_vbus_recv(fd, msg) || msg.type != type) {
+        close();
+        return false;
+    }
+    bus_us = msg.bus_us;
+    return true;
+}
+
+uint16_t OWXVBusMaster::devices()
+{
+    if (!request(OWX_VBUS_M_DEVICES, nullptr, 0) || msg.len != 2) return 0;
+    return (uint16_t)(msg.data[0] | (msg.data[1] << 8));
+}
+
+bool OWXVBusMaster::waitDevices(uint16_t count, int timeout_ms)
+{
+    const uint64_t until = owx_vbus_now_us() + (uint64_t)timeout_ms * 1000u;
+    while (connected()) {
+        if (devices() >= count) return true;
+        if (owx_vbus_now_us() >= until) break;
+        usleep(2000);
+    }
+    return false;
+}
+
+bool OWXVBusMaster::reset(bool overdrive)
+{
+    const uint8_t speed = overdrive ? 1 : 0;
+    return request(OWX_VBUS_M_RESET, &speed, 1) && msg.len == 1 && msg.data[0];
+}
+
+void OWXVBusMaster::writeBytes(const uint8_t *data, uint16_t len)
+{
+    request(OWX_VBUS_M_WRITE, data, len);
+}
+
+void OWXVBusMaster::readBytes(uint8_t *data, uint16_t len)
+{
+    while (len) {
+        const uint8_t chunk = len > 255 ? 255 : (uint8_t)len;
+        if (!request(OWX_VBUS_M_READ, &chunk, 1) || msg.len != chunk) {
+            memset(data, 0xFF, len);   // no bus: nobody pulls it low
+            return;
+        }
+        memcpy(data, msg.data, chunk);
+        data += chunk;
+        len -= chunk;
+    }
+}
+
+bool OWXVBusMaster::triplet(bool dir, bool &taken)
+{
+    const uint8_t d = dir ? 1 : 0;
+    if (!request(OWX_VBUS_M_TRIPLET, &d, 1) || msg.len != 3) {
+        taken = true;
+        return false;
+    }
+    taken = msg.data[2] != 0;
+    return !(msg.data[0] && msg.data[1]);
+}
+
+uint8_t OWXVBusMaster::search(uint8_t rom_cmd, uint8_t roms[][8], uint8_t max)
+{
+    uint8_t rom[8] = { 0 };
+    int last_discrepancy = -1;   // bit where the previous pass took the 0 branch, -1: none left
+    uint8_t found = 0;
+
+    while (found < max) {
+        if (!reset()) break;
+        writeBytes(&rom_cmd, 1);
+
+        int last_zero = -1;
+        bool answered = true;
+        for (int bit = 0; bit < 64 && answered; bit++) {
+            const bool want = bit < last_discrepancy ? ((rom[bit / 8] >> (bit % 8)) & 1) : bit == last_discrepancy;
+            bool taken;
+            answered = triplet(want, taken);
+            // Both branches present and the 0 one taken: next pass tries the 1 branch here
+            if (answered && !taken && msg.data[0] == 0 && msg.data[1] == 0) last_zero = bit;
+            if (taken) rom[bit / 8] |= (uint8_t)(1 << (bit % 8));
+            else rom[bit / 8] &= (uint8_t)~(1 << (bit % 8));
+        }
+        if (!answered) break;
+
+        if (OneWireItem::crc8(rom, 7) == rom[7]) memcpy(roms[found++], rom, 8);
+        last_discrepancy = last_zero;
+        if (last_discrepancy < 0) break;
+    }
+    return found;
+}
+
+std::string OWXVBusMaster::report()
+{
+    if (!request(OWX_VBUS_M_REPORT, nullptr, 0)) return std::string();
+    return std::string((const char *)msg.data, msg.len);
+}
+
+void OWXVBusMaster::shutdown()
+{
+    request(OWX_VBUS_M_SHUTDOWN, nullptr, 0);
+    close();
+}
+
+bool OWXVBusMaster::select(const uint8_t *rom)
+{
+    if (!reset()) return false;
+    const uint8_t match = ONEWIRE_CMD_MATCH_ROM;
+    writeBytes(&match, 1);
+    writeBytes(rom, 8);
+    return true;
+}
+
+uint32_t OWXVBusMaster::micros()
+{
+    if (!paced) return bus_us;
+    const uint32_t wall = (uint32_t)(owx_vbus_now_us() - start_us);
+    return (int32_t)(wall - bus_us) > 0 ? wall : bus_us;
+}
+
+void OWXVBusMaster::idle(uint32_t us)
+{
+    uint8_t data[4];
+    owx_vbus_put32(data, us);
+    request(OWX_VBUS_M_IDLE, data, sizeof(data));
+}
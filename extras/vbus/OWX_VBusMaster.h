@@ -0,0 +1,62 @@
+/*
+    OWX virtual bus: master side
+
+    A 1-Wire master on owx_busd: reset, byte read / write, search triplets, plus the
+    OWXMasterBus interface so the reference scheduler (extras/master) drives the slave
+    processes on the bus unchanged. One master per bus.
+
+    micros() is the bus clock: wall time since the daemon started when it paces the bus (the
+    default), the simulated clock with owx_busd --fast. idle() lets the master wait on either.
+*/
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <OWX_Master.h>
+#include "OWX_VBus.h"
+
+class OWXVBusMaster : public OWXMasterBus
+{
+private:
+    int fd;
+    bool paced;
+    uint64_t start_us;   // daemon's clock origin (paced)
+    uint32_t bus_us;     // clock of the last reply
+    OWXVBusMsg msg;
+
+    bool request(uint8_t type, const void *data, size_t len);
+
+public:
+    OWXVBusMaster();
+    ~OWXVBusMaster();
+
+    bool connect(const char *path = OWX_VBUS_SOCKET);
+    void close();
+    bool connected() const { return fd >= 0; }
+
+    // Waits until at least count devices are attached; false after timeout_ms
+    bool waitDevices(uint16_t count, int timeout_ms);
+    uint16_t devices();
+
+    // Reset + presence; overdrive: short reset, the bus stays at overdrive speed
+    bool reset(bool overdrive = false);
+    void writeBytes(const uint8_t *data, uint16_t len);
+    void readBytes(uint8_t *data, uint16_t len);
+
+    // One search bit: reads bit and complement, writes dir where both appear (Maxim AN187).
+    // Returns false when nobody answered (both read 1)
+    bool triplet(bool dir, bool &taken);
+
+    // Complete ROM search with ONEWIRE_CMD_SEARCH_ROM or ONEWIRE_CMD_ALARM_SEARCH; ROMs found, up to max
+    uint8_t search(uint8_t rom_cmd, uint8_t roms[][8], uint8_t max);
+
+    // The daemon's utilization and per-device latency report
+    std::string report();
+    void shutdown();   // stops the daemon
+
+    // OWXMasterBus
+    bool select(const uint8_t *rom) override;
+    void write(const uint8_t *data, uint8_t len) override { writeBytes(data, len); }
+    void read(uint8_t *data, uint8_t len) override { readBytes(data, len); }
+    uint32_t micros() override;
+    void idle(uint32_t us);
+};
@@ -0,0 +1,127 @@
+#include "OWX_VBusSlave.h"
+#include <string.h>
+#include <unistd.h>
+
+OWXVBusSlave::OWXVBusSlave() : fd(-1), waitMs(-1), pendingPos(0), consumed(0), reset(false) {}
+
+OWXVBusSlave::~OWXVBusSlave()
+{
+    close();
+}
+
+bool OWXVBusSlave::connect(OneWireHub &hub, const char *path)
+{
+    close();
+    items.clear();
+    for (uint8_t i = 0; i < HUB_SLAVE_LIMIT; i++) {
+        if (hub.simItem(i)) items.push_back(hub.simItem(i));
+    }
+    if (items.empty() || items.size() > 255) return false;
+
+    fd = owx_vbus_connect(path);
+    if (fd < 0) return false;
+
+    uint8_t hello[2 + 255 * 8];
+    hello[0] = hub.simOverdriveEnabled() ? OWX_VBUS_HELLO_OVERDRIVE : 0;
+    hello[1] = (uint8_t)items.size();
+    for (size_t i = 0; i < items.size(); i++) memcpy(&hello[2 + 8 * i], items[i]->ID, 8);
+    if (!owx_vbus_send(fd, OWX_VBUS_S_HELLO, hello, 2 + 8 * items.size())) {
+        close();
+        return false;
+    }
+    hub.simLink(this);
+    return true;
+}
+
+void OWXVBusSlave::close()
+{
+    if (fd >= 0) ::close(fd);
+    fd = -1;
+}
+
+// Next message from the daemon; false on timeout, or when the connection is gone (closed)
+bool OWXVBusSlave::receive(OWXVBusMsg &msg, int timeout_ms)
+{
+    if (fd < 0 || !owx_vbus_wait(fd, timeout_ms)) return false;
+    if (owx_vbus_recv(fd, msg)) return true;
+    close();
+    return false;
+}
+
+// Conditional search pass: which of the items take part right now
+void OWXVBusSlave::answer_query()
+{
+    uint8_t alarmed[255];
+    uint8_t count = 0;
+    for (size_t i = 0; i < items.size(); i++) {
+        if (items[i]->alarmed()) alarmed[count++] = (uint8_t)i;
+    }
+    if (!owx_vbus_send(fd, OWX_VBUS_S_ALARMED, alarmed, count)) close();
+}
+
+bool OWXVBusSlave::select(OneWireHub &, uint8_t rom[8], bool &overdrive)
+{
+    static OWXVBusMsg msg;
+    while (receive(msg, waitMs)) {
+        switch (msg.type) {
+            case OWX_VBUS_D_SELECT:
+                if (msg.len != 9) break;
+                memcpy(rom, msg.data, 8);
+                overdrive = msg.data[8] != 0;
+                pending.clear();
+                pendingPos = 0;
+                consumed = 0;
+                reset = false;
+                return true;
+            case OWX_VBUS_D_QUERY:
+                answer_query();
+                break;
+            default:
+                break;   // DATA / RESET of a transaction that already ended
+        }
+    }
+    return false;
+}
+
+uint8_t OWXVBusSlave::masterBytes(uint8_t *data, uint8_t len)
+{
+    static OWXVBusMsg msg;
+    uint8_t got = 0;
+    bool asked = false;
+    while (got < len) {
+        if (pendingPos < pending.size()) {
+            data[got++] = pending[pendingPos++];
+            consumed++;
+            continue;
+        }
+        pending.clear();
+        pendingPos = 0;
+        if (reset || fd < 0) break;
+        if (!asked) {
+            uint8_t need[4];
+            owx_vbus_put32(need, consumed);
+            if (!owx_vbus_send(fd, OWX_VBUS_S_NEED, need, sizeof(need))) close();
+            asked = true;
+        }
+        if (!receive(msg, -1)) break;
+        if (msg.type == OWX_VBUS_D_DATA) {
+            pending.assign(msg.data, msg.data + msg.len);
+            asked = false;
+        } else if (msg.type == OWX_VBUS_D_RESET) {
+            reset = true;
+        } else if (msg.type == OWX_VBUS_D_QUERY) {
+            answer_query();
+        }
+    }
+    return got;
+}
+
+void OWXVBusSlave::slaveBytes(const uint8_t *data, uint8_t len)
+{
+    if (fd >= 0 && !owx_vbus_send(fd, OWX_VBUS_S_SEND, data, len, (uint32_t)owx_vbus_now_us())) close();
+}
+
+void OWXVBusSlave::done()
+{
+    if (fd >= 0 && !owx_vbus_send(fd, OWX_VBUS_S_DONE, nullptr, 0)) close();
+}
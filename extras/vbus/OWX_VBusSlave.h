@@ -0,0 +1,56 @@
+/*
+    OWX virtual bus: slave side
+
+    Attaches a host OneWireHub (extras/host) to owx_busd as a SimBusLink. The hub's items
+    answer on the shared bus with their unmodified duty(); the application loop stays the same
+    as on hardware:
+
+        OneWireHub hub(2);
+        Emulator emu(0x3A, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06);
+        hub.attach(emu);
+        OWXVBusSlave link;
+        if (!link.connect(hub)) return 1;     // registers the ROMs of the attached items
+        link.setWait(10);                     // poll() returns after 10 ms without traffic
+        while (link.connected()) {
+            hub.poll();                       // serves one transaction when addressed
+            loop();
+        }
+
+    Attach every item before connect(): the daemon learns the ROMs from it.
+*/
+#pragma once
+#include <OneWireHub.h>
+#include <vector>
+#include "OWX_VBus.h"
+
+class OWXVBusSlave : public SimBusLink
+{
+private:
+    int fd;
+    int waitMs;
+    std::vector<OneWireItem *> items;
+    std::vector<uint8_t> pending;   // master bytes not taken by recv() yet
+    size_t pendingPos;
+    uint32_t consumed;              // master bytes taken in this transaction
+    bool reset;                     // the master reset the bus during the transaction
+
+    bool receive(OWXVBusMsg &msg, int timeout_ms);
+    void answer_query();
+
+public:
+    OWXVBusSlave();
+    ~OWXVBusSlave();
+
+    // Registers the hub's items with the daemon and sets hub.simLink(); false: no daemon at path
+    bool connect(OneWireHub &hub, const char *path = OWX_VBUS_SOCKET);
+    void close();
+    bool connected() const { return fd >= 0; }
+
+    // How long poll() waits for a transaction, ms; -1: until one comes (default)
+    void setWait(int timeout_ms) { waitMs = timeout_ms; }
+
+    bool select(OneWireHub &hub, uint8_t rom[8], bool &overdrive) override;
+    uint8_t masterBytes(uint8_t *data, uint8_t len) override;
+    void slaveBytes(const uint8_t *data, uint8_t len) override;
+    void done() override;
+};
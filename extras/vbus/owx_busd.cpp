@@ -0,0 +1,728 @@
+/*
+    owx_busd: virtual 1-Wire bus daemon
+
+    One simulated wire for many processes (protocol: OWX_VBus.h). Slave processes attach
+    their host OneWireHub with OWXVBusSlave and run unmodified Emulator code; one master
+    drives the bus with OWXVBusMaster. The daemon models reset / presence, the ROM commands
+    (MATCH, SKIP, READ ROM and their overdrive forms), search arbitration as the wired-AND of
+    the participating ROMs, and the byte transfers between the master and the selected slave.
+
+        ./build/owx_busd [--socket PATH] [--fast] [--report-every S] [--quiet]
+
+        --socket        Unix socket path, default /tmp/owx_vbus.sock
+        --fast          no pacing: operations run back to back on a simulated bus clock
+        --report-every  print the report every S seconds (also on SIGINT / SIGTERM and exit)
+
+    Bus time of an operation: reset 960 µs (118 µs at overdrive), 8 time slots per byte, 3 per
+    search bit, at 65 µs (10 µs) per slot. Paced (default), the bus clock follows the wall
+    clock and an operation returns no earlier than the bus would let it, so a master sees the
+    throughput of a real wire; an operation whose slave took longer than its bus time is an
+    overrun. Report:
+
+        utilization   bus time spent in resets, slots and searches over the bus clock
+        per device    transactions, bytes each way, idle reads (slots the slave did not drive),
+                      transactions cut by a reset while the slave still waited for bytes, and
+                      latency: last master byte to the slave's first reply byte, wall clock,
+                      slave CPU and IPC included (mean, p99, max)
+*/
+#include <errno.h>
+#include <signal.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+#include <OneWireHub.h>   // ROM commands, bus timing
+#include "OWX_VBus.h"
+
+#define BUSD_PACE_SLACK_US 2000   // paced: the bus clock may run this far ahead of the wall clock
+
+struct Device {
+    uint8_t rom[8];
+    int fd;               // slave connection, -1: gone
+    unsigned process;     // slave connection number, for the report
+    uint8_t index;        // position in the slave's HELLO
+    bool overdrive;
+    uint32_t transactions;
+    uint32_t cut;         // reset while the slave still waited for master bytes
+    uint64_t written;
+    uint64_t read;
+    uint64_t idleReads;
+    std::vector<uint32_t> latency;   // µs
+};
+
+struct Conn {
+    enum Kind { UNKNOWN, SLAVE, MASTER } kind;
+    unsigned number;
+    bool overdrive;
+    std::vector<size_t> devices;
+    // transaction of a selected device on this slave
+    bool inTxn;           // SELECT sent, no DONE yet
+    bool starved;         // waits in recv() with every forwarded byte taken
+    uint32_t forwarded;
+    std::deque<uint8_t> out;
+    bool awaitReply;      // next byte read is the first of a reply: latency sample
+    uint32_t lastForward; // owx_vbus_now_us() of the last SELECT / DATA, low 32 bits
+    uint32_t firstReply;  // slave's time stamp of its first SEND after it
+    bool replied;
+    bool alarmAnswered;
+    std::vector<uint8_t> alarmed;
+};
+
+enum BusState { BUS_IDLE, BUS_ROM_CMD, BUS_MATCH, BUS_SELECTED, BUS_READ_ROM, BUS_SEARCH, BUS_IGNORE };
+
+static const char *socket_path = OWX_VBUS_SOCKET;
+static bool paced = true;
+static bool quiet = false;
+static volatile sig_atomic_t stop_signal = 0;
+
+static int listen_fd = -1;
+static std::map<int, Conn> conns;
+static std::vector<Device> devices;
+static unsigned slave_numbers = 0;
+static int master_fd = -1;
+static OWXVBusMsg msg;
+
+// Bus state
+static BusState state = BUS_IDLE;
+static bool od = false;
+static uint8_t match_rom[8];
+static uint8_t match_pos;
+static bool match_od;
+static long selected = -1;            // device
+static uint8_t read_rom[8];
+static uint8_t read_rom_pos;
+static std::vector<size_t> search_active;
+static uint8_t search_bit;
+
+// Clock and statistics
+static uint64_t origin_us;            // wall clock at start
+static uint64_t clock_us;             // bus clock since origin
+static uint64_t op_start;
+static uint64_t busy_reset_us, busy_data_us, busy_search_us;
+static uint32_t overruns;
+static uint64_t worst_overrun_us;
+static uint32_t resets, no_presence, search_passes, triplets, rom_collisions;
+static uint64_t bytes_written, bytes_read, idle_reads;
+
+static uint32_t slot_us() { return od ? ONEWIRE_OD_SLOT_US : ONEWIRE_STD_SLOT_US; }
+static uint64_t wall_us() { return owx_vbus_now_us() - origin_us; }
+
+static size_t attached() {
+    size_t n = 0;
+    for (const Device &d : devices) n += d.fd >= 0;
+    return n;
+}
+
+static void drop(int fd, const char *why) {
+    std::map<int, Conn>::iterator it = conns.find(fd);
+    if (it == conns.end()) return;
+    Conn &c = it->second;
+    if (c.kind == Conn::SLAVE) {
+        if (!quiet && why) fprintf(stderr, "owx_busd: slave %u dropped: %s\n", c.number, why);
+        for (size_t d : c.devices) {
+            devices[d].fd = -1;
+            if ((long)d == selected) {
+                selected = -1;
+                state = BUS_IGNORE;
+            }
+        }
+    }
+    if (fd == master_fd) master_fd = -1;
+    close(fd);
+    conns.erase(it);
+}
+
+// --- slave messages -------------------------------------------------------------------
+
+static void slave_hello(int fd, Conn &c) {
+    if (msg.len < 2 || msg.len != 2 + 8 * msg.data[1] || msg.data[1] == 0) {
+        drop(fd, "bad HELLO");
+        return;
+    }
+    c.kind = Conn::SLAVE;
+    c.number = ++slave_numbers;
+    c.overdrive = msg.data[0] & OWX_VBUS_HELLO_OVERDRIVE;
+    for (uint8_t i = 0; i < msg.data[1]; i++) {
+        const uint8_t *rom = &msg.data[2 + 8 * i];
+        size_t d = devices.size();
+        for (size_t k = 0; k < devices.size(); k++) {
+            if (memcmp(devices[k].rom, rom, 8) != 0) continue;
+            if (devices[k].fd < 0) d = k;   // same device back: keep its statistics
+            else if (!quiet) fprintf(stderr, "owx_busd: ROM attached twice, MATCH ROM finds the first\n");
+        }
+        if (d == devices.size()) {
+            devices.push_back(Device());
+            memcpy(devices[d].rom, rom, 8);
+        }
+        devices[d].fd = fd;
+        devices[d].process = c.number;
+        devices[d].index = i;
+        devices[d].overdrive = c.overdrive;
+        c.devices.push_back(d);
+    }
+}
+
+static void slave_message(int fd, Conn &c) {
+    switch (msg.type) {
+        case OWX_VBUS_S_SEND:
+            if (c.inTxn) {
+                if (!c.replied && msg.len) {
+                    c.firstReply = msg.bus_us;
+                    c.replied = true;
+                }
+                c.out.insert(c.out.end(), msg.data, msg.data + msg.len);
+                c.starved = false;
+            }
+            break;
+        case OWX_VBUS_S_NEED:
+            if (msg.len == 4) c.starved = c.inTxn && owx_vbus_get32(msg.data) == c.forwarded;
+            break;
+        case OWX_VBUS_S_DONE:
+            c.inTxn = false;
+            c.starved = false;
+            break;
+        case OWX_VBUS_S_ALARMED:
+            c.alarmed.assign(msg.data, msg.data + msg.len);
+            c.alarmAnswered = true;
+            break;
+        default:
+            drop(fd, "unexpected message");
+            break;
+    }
+}
+
+// Reads one message of slave fd within OWX_VBUS_TIMEOUT_MS; false when the slave was dropped
+static bool slave_step(int fd) {
+    if (!owx_vbus_wait(fd, OWX_VBUS_TIMEOUT_MS)) {
+        drop(fd, "no answer");
+        return false;
+    }
+    if (!owx_vbus_recv(fd, msg)) {
+        drop(fd, "disconnected");
+        return false;
+    }
+    slave_message(fd, conns[fd]);
+    return conns.count(fd) != 0;
+}
+
+// --- bus operations -------------------------------------------------------------------
+
+static void forward(int fd, Conn &c, const uint8_t *data, size_t len) {
+    bytes_written += len;
+    devices[selected].written += len;
+    c.out.clear();   // reply bytes the master never read
+    c.forwarded += (uint32_t)len;
+    c.starved = false;
+    c.awaitReply = true;
+    c.lastForward = (uint32_t)owx_vbus_now_us();
+    c.replied = false;
+    if (!owx_vbus_send(fd, OWX_VBUS_D_DATA, data, len)) drop(fd, "disconnected");
+}
+
+static void select_device(size_t d) {
+    Conn &c = conns[devices[d].fd];
+    uint8_t sel[9];
+    memcpy(sel, devices[d].rom, 8);
+    sel[8] = od ? 1 : 0;
+    selected = (long)d;
+    state = BUS_SELECTED;
+    c.inTxn = true;
+    c.starved = false;
+    c.forwarded = 0;
+    c.out.clear();
+    c.awaitReply = true;
+    c.lastForward = (uint32_t)owx_vbus_now_us();
+    c.replied = false;
+    devices[d].transactions++;
+    if (!owx_vbus_send(devices[d].fd, OWX_VBUS_D_SELECT, sel, sizeof(sel))) drop(devices[d].fd, "disconnected");
+}
+
+// Ends the selected slave's transaction: RESET, then its DONE
+static void end_transaction() {
+    if (selected >= 0 && devices[selected].fd >= 0) {
+        const int fd = devices[selected].fd;
+        Conn &c = conns[fd];
+        if (c.inTxn) {
+            if (c.starved) devices[selected].cut++;
+            if (owx_vbus_send(fd, OWX_VBUS_D_RESET, nullptr, 0)) {
+                while (conns.count(fd) && conns[fd].inTxn && slave_step(fd)) {}
+            } else {
+                drop(fd, "disconnected");
+            }
+        }
+        if (conns.count(fd)) conns[fd].out.clear();
+    }
+    selected = -1;
+}
+
+static bool bus_reset(bool overdrive_reset) {
+    end_transaction();
+    if (!overdrive_reset) od = false;
+    resets++;
+    const bool presence = attached() > 0;
+    if (!presence) no_presence++;
+    state = presence ? BUS_ROM_CMD : BUS_IDLE;
+    return presence;
+}
+
+static void start_search(uint8_t rom_cmd) {
+    search_passes++;
+    search_active.clear();
+    search_bit = 0;
+    state = BUS_SEARCH;
+    if (rom_cmd == ONEWIRE_CMD_SEARCH_ROM) {
+        for (size_t d = 0; d < devices.size(); d++) {
+            if (devices[d].fd >= 0) search_active.push_back(d);
+        }
+        return;
+    }
+    // Conditional search: every slave tells which of its devices are alarmed right now
+    std::vector<int> asked;
+    for (std::map<int, Conn>::iterator it = conns.begin(); it != conns.end(); ++it) {
+        if (it->second.kind != Conn::SLAVE) continue;
+        it->second.alarmAnswered = false;
+        if (owx_vbus_send(it->first, OWX_VBUS_D_QUERY, nullptr, 0)) asked.push_back(it->first);
+    }
+    for (int fd : asked) {
+        while (conns.count(fd) && !conns[fd].alarmAnswered && slave_step(fd)) {}
+        if (!conns.count(fd)) continue;
+        const Conn &c = conns[fd];
+        for (uint8_t i : c.alarmed) {
+            if (i < c.devices.size()) search_active.push_back(c.devices[i]);
+        }
+    }
+}
+
+static void rom_command(uint8_t cmd) {
+    switch (cmd) {
+        case ONEWIRE_CMD_OD_MATCH_ROM:
+            od = true;   // ROM bytes already at overdrive speed; devices without it drop out
+            // fall through
+        case ONEWIRE_CMD_MATCH_ROM:
+            state = BUS_MATCH;
+            match_pos = 0;
+            match_od = cmd == ONEWIRE_CMD_OD_MATCH_ROM;
+            break;
+
+        case ONEWIRE_CMD_OD_SKIP_ROM:
+        case ONEWIRE_CMD_SKIP_ROM: {
+            if (cmd == ONEWIRE_CMD_OD_SKIP_ROM) od = true;
+            std::vector<size_t> listening;
+            for (size_t d = 0; d < devices.size(); d++) {
+                if (devices[d].fd >= 0 && (cmd == ONEWIRE_CMD_SKIP_ROM || devices[d].overdrive)) listening.push_back(d);
+            }
+            // Several devices would all answer: a collision, nobody is served
+            if (listening.size() == 1) select_device(listening[0]);
+            else state = BUS_IGNORE;
+            if (listening.size() > 1) rom_collisions++;
+            break;
+        }
+
+        case ONEWIRE_CMD_READ_ROM: {
+            // Every device sends its ROM at once: the master reads the wired-AND
+            memset(read_rom, 0xFF, sizeof(read_rom));
+            size_t senders = 0;
+            for (const Device &d : devices) {
+                if (d.fd < 0) continue;
+                senders++;
+                for (uint8_t i = 0; i < 8; i++) read_rom[i] &= d.rom[i];
+            }
+            if (senders > 1) rom_collisions++;
+            read_rom_pos = 0;
+            state = BUS_READ_ROM;
+            break;
+        }
+
+        case ONEWIRE_CMD_SEARCH_ROM:
+        case ONEWIRE_CMD_ALARM_SEARCH:
+            start_search(cmd);
+            break;
+
+        default:
+            state = BUS_IGNORE;
+            break;
+    }
+}
+
+static uint64_t bus_write(const uint8_t *data, size_t len) {
+    uint64_t t = 0;
+    for (size_t i = 0; i < len; i++) {
+        t += 8 * slot_us();   // the byte goes at the speed before it takes effect
+        switch (state) {
+            case BUS_ROM_CMD:
+                bytes_written++;
+                rom_command(data[i]);
+                break;
+            case BUS_MATCH:
+                bytes_written++;
+                match_rom[match_pos++] = data[i];
+                if (match_pos == 8) {
+                    state = BUS_IGNORE;
+                    for (size_t d = 0; d < devices.size(); d++) {
+                        if (devices[d].fd < 0 || memcmp(devices[d].rom, match_rom, 8) != 0) continue;
+                        if (!match_od || devices[d].overdrive) select_device(d);
+                        break;
+                    }
+                }
+                break;
+            case BUS_SELECTED: {
+                // The rest goes to the slave in one piece
+                const int fd = devices[selected].fd;
+                if (fd >= 0) forward(fd, conns[fd], &data[i], len - i);
+                else bytes_written += len - i;
+                return t + (len - i - 1) * 8 * slot_us();
+            }
+            default:
+                bytes_written++;
+                break;
+        }
+    }
+    return t;
+}
+
+// One byte of a read from the selected slave
+static uint8_t read_selected() {
+    Device &dev = devices[selected];
+    while (dev.fd >= 0) {
+        const int fd = dev.fd;
+        Conn &c = conns[fd];
+        if (!c.out.empty()) {
+            const uint8_t b = c.out.front();
+            c.out.pop_front();
+            dev.read++;
+            if (c.awaitReply) {
+                c.awaitReply = false;
+                const int32_t latency = (int32_t)(c.firstReply - c.lastForward);
+                dev.latency.push_back(latency > 0 ? (uint32_t)latency : 0);
+            }
+            return b;
+        }
+        if (!c.inTxn) break;
+        if (c.starved) {
+            // The slave waits for a master byte: these read slots write it 0xFF
+            const uint8_t ones = 0xFF;
+            forward(fd, c, &ones, 1);
+            bytes_written--;   // counted as a read
+            dev.written--;
+            break;
+        }
+        slave_step(fd);
+    }
+    dev.idleReads++;
+    idle_reads++;
+    return 0xFF;
+}
+
+static uint64_t bus_read(uint8_t *data, uint8_t len) {
+    for (uint8_t i = 0; i < len; i++) {
+        if (state == BUS_SELECTED && selected >= 0) data[i] = read_selected();
+        else if (state == BUS_READ_ROM && read_rom_pos < 8) data[i] = read_rom[read_rom_pos++];
+        else {
+            data[i] = 0xFF;
+            idle_reads++;
+        }
+    }
+    bytes_read += len;
+    return (uint64_t)len * 8 * slot_us();
+}
+
+static void bus_triplet(uint8_t dir, uint8_t reply[3]) {
+    triplets++;
+    if (state != BUS_SEARCH) {
+        reply[0] = reply[1] = reply[2] = 1;
+        return;
+    }
+    bool any0 = false, any1 = false;
+    for (size_t d : search_active) {
+        if ((devices[d].rom[search_bit / 8] >> (search_bit % 8)) & 1) any1 = true;
+        else any0 = true;
+    }
+    reply[0] = any0 ? 0 : 1;   // wired-AND of the bit
+    reply[1] = any1 ? 0 : 1;   // and of its complement
+    bool taken;
+    if (any0 && any1) taken = dir != 0;
+    else taken = !any0;
+    reply[2] = taken;
+
+    std::vector<size_t> still;
+    for (size_t d : search_active) {
+        if (((devices[d].rom[search_bit / 8] >> (search_bit % 8)) & 1) == taken) still.push_back(d);
+    }
+    search_active.swap(still);
+    if (++search_bit == 64) state = BUS_IGNORE;   // a search pass ends with nobody selected
+}
+
+// --- clock ----------------------------------------------------------------------------
+
+static void begin_op() {
+    if (paced) clock_us = std::max(clock_us, wall_us());
+    op_start = clock_us;
+}
+
+static void end_op(uint64_t t, uint64_t *busy) {
+    clock_us = op_start + t;
+    if (busy) *busy += t;
+    if (!paced) return;
+    const uint64_t wall = wall_us();
+    if (wall > clock_us && busy && t) {
+        overruns++;
+        worst_overrun_us = std::max(worst_overrun_us, wall - clock_us);
+    }
+    if (clock_us > wall + BUSD_PACE_SLACK_US) {
+        const uint64_t ahead = clock_us - wall;
+        struct timespec ts = { (time_t)(ahead / 1000000u), (long)(ahead % 1000000u) * 1000 };
+        nanosleep(&ts, nullptr);
+    }
+}
+
+// --- report ---------------------------------------------------------------------------
+
+static std::string report() {
+    std::string r;
+    char line[256];
+    size_t processes = 0;
+    for (const std::pair<const int, Conn> &c : conns) processes += c.second.kind == Conn::SLAVE;
+    const uint64_t busy = busy_reset_us + busy_data_us + busy_search_us;
+
+    snprintf(line, sizeof(line), "owx_busd: %u devices in %u slave processes, %s, bus clock %.3f s\n",
+             (unsigned)attached(), (unsigned)processes, paced ? "paced" : "fast", clock_us / 1e6);
+    r += line;
+    snprintf(line, sizeof(line), "utilization %.1f%%: busy %.3f s = reset %.3f + data %.3f + search %.3f s",
+             clock_us ? 100.0 * busy / clock_us : 0.0, busy / 1e6, busy_reset_us / 1e6, busy_data_us / 1e6,
+             busy_search_us / 1e6);
+    r += line;
+    if (paced) {
+        snprintf(line, sizeof(line), "; %u overruns (worst %.2f ms)", overruns, worst_overrun_us / 1000.0);
+        r += line;
+    }
+    snprintf(line, sizeof(line),
+             "\n%u resets (%u without presence), %llu bytes written, %llu read (%llu idle), %u search passes,"
+             " %u triplets, %u ROM collisions\n",
+             resets, no_presence, (unsigned long long)bytes_written, (unsigned long long)bytes_read,
+             (unsigned long long)idle_reads, search_passes, triplets, rom_collisions);
+    r += line;
+    r += "device            proc   txns   written      read  idle   cut  latency us: mean    p99    max\n";
+    for (const Device &d : devices) {
+        std::vector<uint32_t> l = d.latency;
+        double mean = 0;
+        uint32_t p99 = 0, worst = 0;
+        if (!l.empty()) {
+            std::sort(l.begin(), l.end());
+            uint64_t sum = 0;
+            for (uint32_t v : l) sum += v;
+            mean = (double)sum / l.size();
+            p99 = l[(l.size() * 99) / 100 < l.size() ? (l.size() * 99) / 100 : l.size() - 1];
+            worst = l.back();
+        }
+        snprintf(line, sizeof(line), "%02X%02X%02X%02X%02X%02X%02X%02X %5u%s %6u %9llu %9llu %5llu %5u %18.1f %6u %6u\n",
+                 d.rom[0], d.rom[1], d.rom[2], d.rom[3], d.rom[4], d.rom[5], d.rom[6], d.rom[7], d.process,
+                 d.fd >= 0 ? " " : "x", d.transactions, (unsigned long long)d.written, (unsigned long long)d.read,
+                 (unsigned long long)d.idleReads, d.cut, mean, p99, worst);
+        r += line;
+    }
+    return r;
+}
+
+// --- master requests ------------------------------------------------------------------
+
+static void master_hello(int fd, Conn &c) {
+    if (master_fd >= 0) {
+        drop(fd, nullptr);   // one master per bus
+        return;
+    }
+    c.kind = Conn::MASTER;
+    master_fd = fd;
+    state = BUS_IDLE;
+    uint8_t reply[9];
+    reply[0] = paced ? OWX_VBUS_HELLO_PACED : 0;
+    owx_vbus_put32(&reply[1], (uint32_t)origin_us);
+    owx_vbus_put32(&reply[5], (uint32_t)(origin_us >> 32));
+    if (!owx_vbus_send(fd, OWX_VBUS_M_HELLO, reply, sizeof(reply), (uint32_t)clock_us)) drop(fd, nullptr);
+}
+
+// false: shut down
+static bool master_request(int fd) {
+    const uint8_t type = msg.type;
+    const uint16_t len = msg.len;
+    uint8_t in[OWX_VBUS_MAX_DATA];
+    memcpy(in, msg.data, len);
+    std::string text;
+    uint8_t reply[256];
+    size_t reply_len = 0;
+    const uint8_t *reply_data = reply;
+
+    begin_op();
+    switch (type) {
+        case OWX_VBUS_M_DEVICES: {
+            const size_t n = attached();
+            reply[0] = (uint8_t)n;
+            reply[1] = (uint8_t)(n >> 8);
+            reply_len = 2;
+            end_op(0, nullptr);
+            break;
+        }
+        case OWX_VBUS_M_RESET: {
+            const bool overdrive_reset = len == 1 && in[0] && od;
+            reply[0] = bus_reset(overdrive_reset);
+            reply_len = 1;
+            end_op(overdrive_reset ? ONEWIRE_OD_RESET_US : ONEWIRE_STD_RESET_US, &busy_reset_us);
+            break;
+        }
+        case OWX_VBUS_M_WRITE:
+            end_op(bus_write(in, len), state == BUS_SEARCH ? &busy_search_us : &busy_data_us);
+            break;
+        case OWX_VBUS_M_READ:
+            if (len != 1) return false;
+            reply_len = in[0];
+            end_op(bus_read(reply, in[0]), &busy_data_us);
+            break;
+        case OWX_VBUS_M_TRIPLET:
+            bus_triplet(len ? in[0] : 1, reply);
+            reply_len = 3;
+            end_op(3 * slot_us(), &busy_search_us);
+            break;
+        case OWX_VBUS_M_IDLE:
+            end_op(len == 4 ? owx_vbus_get32(in) : 0, nullptr);
+            break;
+        case OWX_VBUS_M_REPORT:
+            text = report();
+            if (text.size() > OWX_VBUS_MAX_DATA) text.resize(OWX_VBUS_MAX_DATA);
+            reply_data = (const uint8_t *)text.data();
+            reply_len = text.size();
+            end_op(0, nullptr);
+            break;
+        case OWX_VBUS_M_SHUTDOWN:
+            owx_vbus_send(fd, type, nullptr, 0, (uint32_t)clock_us);
+            return false;
+        default:
+            drop(fd, nullptr);
+            return true;
+    }
+    if (conns.count(fd) && !owx_vbus_send(fd, type, reply_data, reply_len, (uint32_t)clock_us)) drop(fd, nullptr);
+    return true;
+}
+
+// false: shut down
+static bool connection_readable(int fd) {
+    if (!owx_vbus_recv(fd, msg)) {
+        if (fd == master_fd) {
+            end_transaction();
+            state = BUS_IDLE;
+        }
+        drop(fd, "disconnected");
+        return true;
+    }
+    Conn &c = conns[fd];
+    switch (c.kind) {
+        case Conn::UNKNOWN:
+            if (msg.type == OWX_VBUS_S_HELLO) slave_hello(fd, c);
+            else if (msg.type == OWX_VBUS_M_HELLO) master_hello(fd, c);
+            else drop(fd, nullptr);
+            return true;
+        case Conn::SLAVE:
+            slave_message(fd, c);
+            return true;
+        case Conn::MASTER:
+            return master_request(fd);
+    }
+    return true;
+}
+
+static void on_signal(int) {
+    stop_signal = 1;
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "usage: %s [--socket PATH] [--fast] [--report-every SECONDS] [--quiet]\n", argv0);
+}
+
+int main(int argc, char **argv) {
+    unsigned report_every = 0;
+    for (int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (strcmp(a, "--socket") == 0 && has_value) socket_path = argv[++i];
+        else if (strcmp(a, "--fast") == 0) paced = false;
+        else if (strcmp(a, "--report-every") == 0 && has_value) report_every = (unsigned)atoi(argv[++i]);
+        else if (strcmp(a, "--quiet") == 0) quiet = true;
+        else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    listen_fd = owx_vbus_listen(socket_path);
+    if (listen_fd < 0) {
+        perror(socket_path);
+        return 1;
+    }
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_signal;   // no SA_RESTART: poll() returns EINTR
+    sigaction(SIGINT, &sa, nullptr);
+    sigaction(SIGTERM, &sa, nullptr);
+
+    origin_us = owx_vbus_now_us();
+    uint64_t next_report = report_every ? origin_us + report_every * 1000000ull : 0;
+    if (!quiet) printf("owx_busd: listening on %s (%s)\n", socket_path, paced ? "paced" : "fast");
+    fflush(stdout);
+
+    bool running = true;
+    std::vector<struct pollfd> fds;
+    while (running && !stop_signal) {
+        fds.clear();
+        struct pollfd l = { listen_fd, POLLIN, 0 };
+        fds.push_back(l);
+        for (const std::pair<const int, Conn> &c : conns) {
+            struct pollfd p = { c.first, POLLIN, 0 };
+            fds.push_back(p);
+        }
+        int timeout = -1;
+        if (next_report) {
+            const uint64_t now = owx_vbus_now_us();
+            timeout = now >= next_report ? 0 : (int)((next_report - now) / 1000 + 1);
+        }
+        const int n = poll(fds.data(), fds.size(), timeout);
+        if (n < 0 && errno != EINTR) {
+            perror("poll");
+            break;
+        }
+
+        if (next_report && owx_vbus_now_us() >= next_report) {
+            printf("%s\n", report().c_str());
+            fflush(stdout);
+            next_report += report_every * 1000000ull;
+        }
+        if (n <= 0) continue;
+
+        if (fds[0].revents & POLLIN) {
+            const int fd = owx_vbus_accept(listen_fd);
+            if (fd >= 0) {
+                Conn c = Conn();
+                c.kind = Conn::UNKNOWN;
+                conns[fd] = c;
+            }
+        }
+        for (size_t i = 1; i < fds.size() && running; i++) {
+            if (!fds[i].revents || !conns.count(fds[i].fd)) continue;
+            // A nested wait on a slave may have taken what poll() saw
+            if (!owx_vbus_wait(fds[i].fd, 0)) continue;
+            running = connection_readable(fds[i].fd);
+        }
+    }
+
+    if (!quiet) printf("%s", report().c_str());
+    std::vector<int> open_fds;
+    for (const std::pair<const int, Conn> &c : conns) open_fds.push_back(c.first);
+    for (int fd : open_fds) drop(fd, nullptr);
+    close(listen_fd);
+    unlink(socket_path);
+    return 0;
+}
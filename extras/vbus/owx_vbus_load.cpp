@@ -0,0 +1,120 @@
+/*
+    owx_vbus_load: master load on the virtual bus
+
+    Finds every slave on owx_busd with a ROM search and serves them with the reference
+    scheduler (OWXMaster) for --seconds of bus time: each slave's three variables (see
+    owx_vbus_slave) polled every --period ms, a setpoint written every --write-every ms. Prints
+    polls per second and the worst staleness, then the daemon's utilization and per-slave
+    latency report.
+
+        --expect N        wait until N devices are attached (default 1)
+        --seconds S       bus time to run (default 10)
+        --period MS       poll period of every slave (default 1000)
+        --write-every MS  setpoint writes per slave, 0: none (default 2000)
+        --shutdown        stop the daemon afterwards
+        --socket PATH     daemon socket, default /tmp/owx_vbus.sock
+
+    Exit code: 0 every slave polled and every write delivered, 1 otherwise, 2 no bus.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <OWX_Master.h>
+#include <OneWireHub.h>
+#include "OWX_VBusMaster.h"
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "usage: %s [--expect N] [--seconds S] [--period MS] [--write-every MS] [--shutdown] [--socket PATH]\n",
+            argv0);
+}
+
+int main(int argc, char **argv) {
+    const char *socket_path = OWX_VBUS_SOCKET;
+    unsigned expect = 1, seconds = 10, period_ms = 1000, write_every_ms = 2000;
+    bool shutdown = false;
+    for (int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (strcmp(a, "--expect") == 0 && has_value) expect = (unsigned)atoi(argv[++i]);
+        else if (strcmp(a, "--seconds") == 0 && has_value) seconds = (unsigned)atoi(argv[++i]);
+        else if (strcmp(a, "--period") == 0 && has_value) period_ms = (unsigned)atoi(argv[++i]);
+        else if (strcmp(a, "--write-every") == 0 && has_value) write_every_ms = (unsigned)atoi(argv[++i]);
+        else if (strcmp(a, "--shutdown") == 0) shutdown = true;
+        else if (strcmp(a, "--socket") == 0 && has_value) socket_path = argv[++i];
+        else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    OWXVBusMaster bus;
+    if (!bus.connect(socket_path)) {
+        perror(socket_path);
+        return 2;
+    }
+    if (!bus.waitDevices((uint16_t)expect, 10000)) {
+        fprintf(stderr, "only %u of %u devices attached\n", bus.devices(), expect);
+        return 2;
+    }
+
+    static uint8_t roms[OWX_MASTER_MAX_SLAVES][8];
+    const uint32_t search_start = bus.micros();
+    const uint8_t found = bus.search(ONEWIRE_CMD_SEARCH_ROM, roms, OWX_MASTER_MAX_SLAVES);
+    printf("search: %u devices in %.1f ms of bus time\n", found, (bus.micros() - search_start) / 1000.0);
+
+    static OWXMaster master(bus);
+    static struct {
+        float temperature;
+        int16_t setpoint;
+        uint32_t counter;
+    } values[OWX_MASTER_MAX_SLAVES];
+    for (uint8_t i = 0; i < found; i++) {
+        const int8_t s = master.addSlave(roms[i], 1, period_ms * 1000u);
+        master.pollVariable(s, 0x10, &values[i].temperature, sizeof(float));
+        master.pollVariable(s, 0x11, &values[i].setpoint, sizeof(int16_t));
+        master.pollVariable(s, 0x12, &values[i].counter, sizeof(uint32_t));
+    }
+
+    const uint32_t start = bus.micros();
+    const uint32_t end = start + seconds * 1000000u;
+    uint32_t next_write = start + write_every_ms * 1000u;
+    uint32_t queued = 0, refused = 0;
+    int16_t setpoint = 0;
+    while ((int32_t)(bus.micros() - end) < 0) {
+        if (write_every_ms && (int32_t)(bus.micros() - next_write) >= 0) {
+            setpoint++;
+            for (uint8_t i = 0; i < found; i++) {
+                if (master.write(i, setpoint)) queued++;
+                else refused++;
+            }
+            next_write += write_every_ms * 1000u;
+        }
+        if (!master.service()) {
+            uint32_t wait = master.idleFor();
+            if (wait > 10000) wait = 10000;
+            bus.idle(wait ? wait : 100);
+        }
+        if (!bus.connected()) {
+            fprintf(stderr, "daemon went away\n");
+            return 2;
+        }
+    }
+
+    uint32_t polls = 0, errors = 0, writes = 0, pending = 0, worst = 0, unpolled = 0;
+    for (uint8_t i = 0; i < found; i++) {
+        const OWXSlaveReport r = master.report(i);
+        polls += r.polls;
+        errors += r.pollErrors + r.writeErrors;
+        writes += r.writes;
+        pending += master.writesPending(i);
+        if (r.worstStaleness > worst) worst = r.worstStaleness;
+        if (r.polls == 0) unpolled++;
+    }
+    const double s = (bus.micros() - start) / 1e6;
+    printf("%u slaves, %.1f s: %.1f polls/s, %u errors, %u of %u writes delivered (%u pending, %u refused),"
+           " worst staleness %.1f ms\n",
+           found, s, polls / s, errors, writes, queued, pending, refused, worst / 1000.0);
+    printf("%s", bus.report().c_str());
+    if (shutdown) bus.shutdown();
+    return found >= expect && unpolled == 0 && writes + pending == queued ? 0 : 1;
+}
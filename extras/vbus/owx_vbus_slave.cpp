@@ -0,0 +1,121 @@
+/*
+    owx_vbus_slave: a fleet of OWX slaves on the virtual bus
+
+    Starts --count processes, each an ordinary Emulator application attached to owx_busd with
+    OWXVBusSlave: three bound variables like the master bench (0x10 float temperature, 0x11
+    int16 setpoint, 0x12 uint32 counter), setpoint writes taken with a receive callback. The
+    processes exit when the daemon goes away.
+
+        ./build/owx_busd &
+        ./build/owx_vbus_slave --count 50 &
+        ./build/owx_vbus_load --expect 50 --seconds 10
+
+        --count N        slave processes, one Emulator each (default 8)
+        --first N        number of the first slave, part of its ROM (default 0)
+        --overdrive      hubs accept overdrive ROM commands, slaves advertise it
+        --alarm-every MS raise the user alarm every MS (conditional search traffic)
+        --socket PATH    daemon socket, default /tmp/owx_vbus.sock
+
+    ROM of slave n: 3A 56 42 <n LSB first, 2 bytes> 00 01 + CRC8.
+*/
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+#include <OWX_Slave_Emulator.h>
+#include "OWX_VBusSlave.h"
+
+static const char *socket_path = OWX_VBUS_SOCKET;
+static bool overdrive = false;
+static uint32_t alarm_every_ms = 0;
+
+static struct {
+    float temperature;
+    int16_t setpoint;
+    uint32_t counter;
+} data;
+
+static void on_setpoint(int16_t value) { data.setpoint = value; }
+
+// One slave process: the application's setup() and loop()
+static int run_slave(uint16_t n) {
+    OneWireHub hub(2);
+    hub.simEnableOverdrive(overdrive);
+    Emulator emu(0x3A, 0x56, 0x42, (uint8_t)n, (uint8_t)(n >> 8), 0x00, 0x01);
+    emu.setOverdrive(overdrive);
+    emu.bindVariable(0x10, &data.temperature);
+    emu.bindVariable(0x11, &data.setpoint);
+    emu.bindVariable(0x12, &data.counter);
+    emu.onReceive(on_setpoint);
+    hub.attach(emu);
+
+    OWXVBusSlave link;
+    if (!link.connect(hub, socket_path)) {
+        perror(socket_path);
+        return 1;
+    }
+    link.setWait(10);
+
+    data.temperature = 20.0f + n / 10.0f;
+    uint32_t last_alarm = millis();
+    while (link.connected()) {
+        hub.poll();
+        emu.dispatchPending();
+        data.counter++;
+        data.temperature += 0.01f;
+        if (alarm_every_ms && millis() - last_alarm >= alarm_every_ms) {
+            emu.raiseAlarm();
+            last_alarm = millis();
+        }
+    }
+    return 0;
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "usage: %s [--count N] [--first N] [--overdrive] [--alarm-every MS] [--socket PATH]\n", argv0);
+}
+
+int main(int argc, char **argv) {
+    unsigned count = 8, first = 0;
+    for (int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (strcmp(a, "--count") == 0 && has_value) count = (unsigned)atoi(argv[++i]);
+        else if (strcmp(a, "--first") == 0 && has_value) first = (unsigned)atoi(argv[++i]);
+        else if (strcmp(a, "--overdrive") == 0) overdrive = true;
+        else if (strcmp(a, "--alarm-every") == 0 && has_value) alarm_every_ms = (uint32_t)atoi(argv[++i]);
+        else if (strcmp(a, "--socket") == 0 && has_value) socket_path = argv[++i];
+        else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (count == 0 || first + count > 0x10000) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    Serial.simMute(true);
+    std::vector<pid_t> children;
+    for (unsigned n = first; n < first + count; n++) {
+        const pid_t pid = fork();
+        if (pid == 0) _exit(run_slave((uint16_t)n));
+        if (pid < 0) {
+            perror("fork");
+            break;
+        }
+        children.push_back(pid);
+    }
+
+    int failed = 0;
+    for (pid_t pid : children) {
+        int status = 0;
+        waitpid(pid, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) failed++;
+    }
+    if (failed) fprintf(stderr, "%d of %u slave processes failed\n", failed, (unsigned)children.size());
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,136 @@
+/*
+    OWX array codec
+
+    Encoding of OW_CMD_ARRAY_* payloads, shared by the slave decoder and by masters / host tools
+    that build the frames:
+
+        OW_ARRAY_RAW          elements LSB first, sizeof(T) bytes each
+        OW_ARRAY_DELTA_VARINT first element and then the difference to the previous one,
+                              zigzag mapped and written as a LEB128 varint (7 bits per byte)
+
+    Differences are taken on the element bits with wrap-around in the element width, so every
+    value round-trips exactly; floats use their IEEE bit pattern, which changes little between
+    close values of the same sign. Every frame restarts from 0, so frames decode on their own.
+
+    Slow-moving signals (temperatures, filtered ADC readings) need 1 byte per element instead
+    of 2 or 4; see extras/bench/array_bench.cpp.
+*/
+#pragma once
+#include <stdint.h>
+#include <string.h>
+
+#define OW_ARRAY_RAW          0x00
+#define OW_ARRAY_DELTA_VARINT 0x01
+
+// Element type → unsigned container of its bits
+template <typename T> struct OWXArrayTraits;
+template <> struct OWXArrayTraits<int16_t>  { typedef uint16_t Bits; };
+template <> struct OWXArrayTraits<uint16_t> { typedef uint16_t Bits; };
+template <> struct OWXArrayTraits<int32_t>  { typedef uint32_t Bits; };
+template <> struct OWXArrayTraits<float>    { typedef uint32_t Bits; };
+
+template <typename Bits>
+inline Bits owx_zigzag(Bits delta) {
+    // (d << 1) ^ (d >> width-1) on the signed value, done on unsigned bits
+    return (Bits)((Bits)(delta << 1) ^ (Bits)(0 - (delta >> (sizeof(Bits) * 8 - 1))));
+}
+
+template <typename Bits>
+inline Bits owx_unzigzag(Bits z) {
+    return (Bits)((z >> 1) ^ (Bits)(0 - (z & 1)));
+}
+
+// Writes v as a varint; returns bytes written, 0 if it doesn't fit in max
+inline uint8_t owx_varint_put(uint32_t v, uint8_t *out, uint8_t max) {
+    uint8_t n = 0;
+    do {
+        if (n >= max) return 0;
+        uint8_t b = v & 0x7F;
+        v >>= 7;
+        out[n++] = v ? (uint8_t)(b | 0x80) : b;
+    } while (v);
+    return n;
+}
+
+// Reads one varint of at most max_bytes; returns bytes consumed, 0 if truncated or too long.
+// A 5th byte carries bits 28..34: anything above bit 31 would be shifted out, so it is rejected
+inline uint8_t owx_varint_get(const uint8_t *in, uint8_t avail, uint8_t max_bytes, uint32_t &v) {
+    v = 0;
+    for (uint8_t n = 0; n < avail && n < max_bytes; n++) {
+        if (n == 4 && (in[n] & 0x70)) return 0;
+        v |= (uint32_t)(in[n] & 0x7F) << (7 * n);
+        if (!(in[n] & 0x80)) return n + 1;
+    }
+    return 0;
+}
+
+template <typename T>
+inline typename OWXArrayTraits<T>::Bits owx_array_bits(const T &value) {
+    typename OWXArrayTraits<T>::Bits bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+// Encodes as many of count elements as fit in out_max bytes.
+// Returns elements encoded, out_len = bytes used.
+template <typename T>
+uint8_t owx_array_encode(const T *src, uint8_t count, uint8_t encoding, uint8_t *out, uint8_t out_max, uint8_t &out_len) {
+    typedef typename OWXArrayTraits<T>::Bits Bits;
+    uint8_t n = 0;
+    out_len = 0;
+
+    if (encoding == OW_ARRAY_RAW) {
+        while (n < count && out_len + sizeof(T) <= out_max) {
+            Bits bits = owx_array_bits(src[n]);
+            for (uint8_t b = 0; b < sizeof(T); b++) out[out_len++] = (uint8_t)(bits >> (8 * b));
+            n++;
+        }
+        return n;
+    }
+
+    Bits prev = 0;
+    while (n < count) {
+        Bits bits = owx_array_bits(src[n]);
+        uint8_t used = owx_varint_put(owx_zigzag((Bits)(bits - prev)), &out[out_len], out_max - out_len);
+        if (used == 0) break;
+        out_len += used;
+        prev = bits;
+        n++;
+    }
+    return n;
+}
+
+// Decodes exactly count elements from len bytes into dest; false (dest untouched) on any mismatch
+template <typename T>
+bool owx_array_decode(const uint8_t *in, uint8_t len, uint8_t encoding, T *dest, uint8_t count) {
+    typedef typename OWXArrayTraits<T>::Bits Bits;
+    const uint8_t max_bytes = sizeof(Bits) == 2 ? 3 : 5;
+
+    if (encoding == OW_ARRAY_RAW) {
+        if (len != (uint16_t)count * sizeof(T)) return false;
+        memcpy(dest, in, len);   // every supported target is little-endian
+        return true;
+    }
+    if (encoding != OW_ARRAY_DELTA_VARINT) return false;
+
+    // Pass 1: the stream must hold exactly count varints, so a bad frame changes nothing
+    uint8_t pos = 0;
+    uint32_t v;
+    for (uint8_t i = 0; i < count; i++) {
+        uint8_t used = owx_varint_get(&in[pos], len - pos, max_bytes, v);
+        if (used == 0) return false;
+        if ((Bits)v != v) return false;   // more bits than the element has
+        pos += used;
+    }
+    if (pos != len) return false;
+
+    // Pass 2: rebuild the values straight into the destination
+    Bits prev = 0;
+    pos = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        pos += owx_varint_get(&in[pos], len - pos, max_bytes, v);
+        prev = (Bits)(prev + owx_unzigzag((Bits)v));
+        memcpy(&dest[i], &prev, sizeof(T));
+    }
+    return true;
+}
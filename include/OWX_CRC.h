@@ -0,0 +1,206 @@
+/*
+    OWX CRC subsystem
+
+    Dallas/Maxim CRC8 (polynomial x^8 + x^5 + x^4 + 1, reflected 0x8C) used by every
+    OWX packet. Three interchangeable implementations are provided:
+
+        - OWX_CRC8_IMPL_TABLE256 : 256-entry table generated at compile time, kept in flash (PROGMEM).
+                                   One lookup per byte. Default.
+        - OWX_CRC8_IMPL_NIBBLE   : two 16-entry tables, two lookups per byte. For RAM/flash-tight builds.
+        - OWX_CRC8_IMPL_BITWISE  : original shift/xor loop, eight steps per byte, no tables.
+
+    Select the implementation used by the emulator with a build flag, e.g.
+        build_flags = -D OWX_CRC8_IMPL=OWX_CRC8_IMPL_NIBBLE
+
+    OWXCrc8 is streaming: call update() as every byte arrives from the bus, read value() at the end.
+    This header has no Arduino dependency so it can also be built on the host (see extras/bench).
+*/
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+#if defined(ARDUINO)
+#include <Arduino.h>
+#endif
+
+#ifndef PROGMEM
+#define PROGMEM
+#endif
+#ifndef pgm_read_byte
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#endif
+
+#define OWX_CRC8_IMPL_TABLE256 0
+#define OWX_CRC8_IMPL_NIBBLE   1
+#define OWX_CRC8_IMPL_BITWISE  2
+
+#ifndef OWX_CRC8_IMPL
+#define OWX_CRC8_IMPL OWX_CRC8_IMPL_TABLE256
+#endif
+
+#define OWX_CRC8_POLY 0x8C   // Dallas/Maxim CRC polynomial (reflected)
+
+// --- Compile-time table generation ---
+
+// One bit step of the reflected CRC8
+constexpr uint8_t owx_crc8_step(uint8_t crc) {
+    return (crc & 0x01) ? (uint8_t)((crc >> 1) ^ OWX_CRC8_POLY) : (uint8_t)(crc >> 1);
+}
+
+// CRC8 of a single byte value starting from crc = 0 (table entry)
+constexpr uint8_t owx_crc8_entry(uint8_t value, uint8_t bits = 8) {
+    return bits == 0 ? value : owx_crc8_entry(owx_crc8_step(value), (uint8_t)(bits - 1));
+}
+
+#define OWX_CRC8_E4(n)  owx_crc8_entry((uint8_t)(n)), owx_crc8_entry((uint8_t)((n) + 1)), \
+                        owx_crc8_entry((uint8_t)((n) + 2)), owx_crc8_entry((uint8_t)((n) + 3))
+#define OWX_CRC8_E16(n) OWX_CRC8_E4(n), OWX_CRC8_E4((n) + 4), OWX_CRC8_E4((n) + 8), OWX_CRC8_E4((n) + 12)
+#define OWX_CRC8_E64(n) OWX_CRC8_E16(n), OWX_CRC8_E16((n) + 16), OWX_CRC8_E16((n) + 32), OWX_CRC8_E16((n) + 48)
+
+// Lookup tables. Static members of a class template so the program holds one copy of each
+// however many translation units include this header (a const array at namespace scope has
+// internal linkage: one copy per TU in flash).
+template <typename Unused = void>
+struct OWXCrc8Tables {
+    static const uint8_t full[256] PROGMEM;    // crc' = full[crc ^ byte]
+    static const uint8_t nibbleLo[16] PROGMEM; // crc' = lo[x & 0x0F] ^ hi[x >> 4], x = crc ^ byte
+    static const uint8_t nibbleHi[16] PROGMEM;
+};
+
+template <typename Unused>
+const uint8_t OWXCrc8Tables<Unused>::full[256] PROGMEM = {
+    OWX_CRC8_E64(0), OWX_CRC8_E64(64), OWX_CRC8_E64(128), OWX_CRC8_E64(192)
+};
+
+template <typename Unused>
+const uint8_t OWXCrc8Tables<Unused>::nibbleLo[16] PROGMEM = { OWX_CRC8_E16(0) };
+
+template <typename Unused>
+const uint8_t OWXCrc8Tables<Unused>::nibbleHi[16] PROGMEM = {
+    owx_crc8_entry(0x00), owx_crc8_entry(0x10), owx_crc8_entry(0x20), owx_crc8_entry(0x30),
+    owx_crc8_entry(0x40), owx_crc8_entry(0x50), owx_crc8_entry(0x60), owx_crc8_entry(0x70),
+    owx_crc8_entry(0x80), owx_crc8_entry(0x90), owx_crc8_entry(0xA0), owx_crc8_entry(0xB0),
+    owx_crc8_entry(0xC0), owx_crc8_entry(0xD0), owx_crc8_entry(0xE0), owx_crc8_entry(0xF0)
+};
+
+#undef OWX_CRC8_E4
+#undef OWX_CRC8_E16
+#undef OWX_CRC8_E64
+
+// Known-answer check: table[0x01] of the Dallas/Maxim CRC8 is 0x5E (Maxim AN27)
+static_assert(owx_crc8_entry(0x01) == 0x5E, "CRC8 table generation is broken");
+
+// Streaming CRC8 engine, Impl selects one of OWX_CRC8_IMPL_*
+template <uint8_t Impl>
+class OWXCrc8Engine
+{
+private:
+    uint8_t crc;
+
+public:
+    explicit OWXCrc8Engine(uint8_t crc_init = 0) : crc(crc_init) {}
+
+    void reset(uint8_t crc_init = 0) { crc = crc_init; }
+    uint8_t value() const { return crc; }
+
+    // Folds one byte into the running CRC
+    void update(uint8_t in) { crc = step(crc, in); }
+
+    // Folds a whole buffer into the running CRC
+    void update(const uint8_t *data, size_t len) {
+        uint8_t c = crc;
+        while (len--) c = step(c, *data++);
+        crc = c;
+    }
+
+    // One-shot CRC of a buffer
+    static uint8_t compute(const uint8_t *data, size_t len, uint8_t crc_init = 0) {
+        OWXCrc8Engine engine(crc_init);
+        engine.update(data, len);
+        return engine.value();
+    }
+
+    static uint8_t step(uint8_t crc, uint8_t in);
+};
+
+template <>
+inline uint8_t OWXCrc8Engine<OWX_CRC8_IMPL_TABLE256>::step(uint8_t crc, uint8_t in) {
+    return pgm_read_byte(&OWXCrc8Tables<>::full[crc ^ in]);
+}
+
+template <>
+inline uint8_t OWXCrc8Engine<OWX_CRC8_IMPL_NIBBLE>::step(uint8_t crc, uint8_t in) {
+    uint8_t x = crc ^ in;
+    return pgm_read_byte(&OWXCrc8Tables<>::nibbleLo[x & 0x0F]) ^ pgm_read_byte(&OWXCrc8Tables<>::nibbleHi[x >> 4]);
+}
+
+template <>
+inline uint8_t OWXCrc8Engine<OWX_CRC8_IMPL_BITWISE>::step(uint8_t crc, uint8_t in) {
+    for (uint8_t i = 0; i < 8; ++i) {
+        uint8_t mix = (crc ^ in) & 0x01;
+        crc >>= 1;
+        if (mix) crc ^= OWX_CRC8_POLY;
+        in >>= 1;
+    }
+    return crc;
+}
+
+// CRC8 engine used by the emulator
+typedef OWXCrc8Engine<OWX_CRC8_IMPL> OWXCrc8;
+
+// --- CRC16 ---
+
+#define OWX_CRC16_POLY 0xA001   // Dallas/Maxim CRC16 polynomial (reflected 0x8005)
+
+// CRC16 of a nibble value starting from crc = 0 (table entry)
+constexpr uint16_t owx_crc16_entry(uint16_t value, uint8_t bits = 4) {
+    return bits == 0 ? value
+        : owx_crc16_entry((value & 0x01) ? (uint16_t)((value >> 1) ^ OWX_CRC16_POLY) : (uint16_t)(value >> 1),
+                          (uint8_t)(bits - 1));
+}
+
+#define OWX_CRC16_E4(n) owx_crc16_entry(n), owx_crc16_entry((n) + 1), owx_crc16_entry((n) + 2), owx_crc16_entry((n) + 3)
+// One copy per program, see OWXCrc8Tables
+template <typename Unused = void>
+struct OWXCrc16Tables {
+    static const uint16_t nibble[16] PROGMEM;
+};
+
+template <typename Unused>
+const uint16_t OWXCrc16Tables<Unused>::nibble[16] PROGMEM = {
+    OWX_CRC16_E4(0), OWX_CRC16_E4(4), OWX_CRC16_E4(8), OWX_CRC16_E4(12)
+};
+#undef OWX_CRC16_E4
+
+#ifndef pgm_read_word
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+#endif
+
+// Streaming Dallas/Maxim CRC16 (same as OneWireItem::crc16), nibble table, used for whole-transfer checks
+class OWXCrc16
+{
+private:
+    uint16_t crc;
+
+public:
+    explicit OWXCrc16(uint16_t crc_init = 0) : crc(crc_init) {}
+
+    void reset(uint16_t crc_init = 0) { crc = crc_init; }
+    uint16_t value() const { return crc; }
+
+    void update(uint8_t in) {
+        uint16_t c = crc ^ in;
+        c = (c >> 4) ^ pgm_read_word(&OWXCrc16Tables<>::nibble[c & 0x0F]);
+        crc = (c >> 4) ^ pgm_read_word(&OWXCrc16Tables<>::nibble[c & 0x0F]);
+    }
+
+    void update(const uint8_t *data, size_t len) {
+        while (len--) update(*data++);
+    }
+
+    static uint16_t compute(const uint8_t *data, size_t len, uint16_t crc_init = 0) {
+        OWXCrc16 engine(crc_init);
+        engine.update(data, len);
+        return engine.value();
+    }
+};
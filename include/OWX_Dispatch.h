@@ -0,0 +1,142 @@
+/*
+    OWX handler command dispatch
+
+    Handlers for OW_HANDLER_COMMAND are plain function pointer + context pairs keyed by
+    the command byte; no std::function, no heap. Two table layouts, chosen at compile time:
+
+        - OW_HANDLER_TABLE_DENSE  : OW_MAX_HANDLERS entries plus a 256-byte command → entry
+                                    index, one indexed load per dispatch (constant time).
+                                    Default.
+        - OW_HANDLER_TABLE_SORTED : the same entries kept sorted by command, binary search
+                                    (up to log2(OW_MAX_HANDLERS) + 1 compares). Saves the
+                                    256-byte index, for parts with 2 KB of RAM or less.
+
+        build_flags = -D OW_HANDLER_TABLE=OW_HANDLER_TABLE_SORTED
+
+    Commands without a registered handler fall through to the catch-all handler.
+*/
+#pragma once
+#include <stdint.h>
+#include <string.h>
+
+#define OW_HANDLER_TABLE_SORTED 0
+#define OW_HANDLER_TABLE_DENSE  1
+
+#ifndef OW_HANDLER_TABLE
+#define OW_HANDLER_TABLE OW_HANDLER_TABLE_DENSE
+#endif
+
+#ifndef OW_MAX_HANDLERS
+#define OW_MAX_HANDLERS 8
+#endif
+
+static_assert(OW_MAX_HANDLERS < 255, "OW_MAX_HANDLERS must fit the one-byte dense index");
+
+// Handler signature: context as registered, command byte received. Return true to ACK.
+typedef bool (*OWXHandlerFn)(void *context, uint8_t cmd);
+
+// Legacy single-argument handler, as passed to setCustomHandler()
+typedef bool (*OWXPlainHandlerFn)(uint8_t cmd);
+
+struct OWXHandler {
+    OWXHandlerFn fn;
+    void *context;
+
+    bool operator()(uint8_t cmd) const { return fn(context, cmd); }
+
+    // Adapts a plain bool(uint8_t) function: the function pointer travels as the context
+    static bool call_plain(void *context, uint8_t cmd) {
+        return reinterpret_cast<OWXPlainHandlerFn>(context)(cmd);
+    }
+    static OWXHandler plain(OWXPlainHandlerFn fn) {
+        OWXHandler handler = { fn ? call_plain : nullptr, reinterpret_cast<void *>(fn) };
+        return handler;
+    }
+};
+
+class OWXHandlerTable
+{
+private:
+    struct Entry {
+        uint8_t cmd;
+        OWXHandler handler;
+    };
+    Entry entries[OW_MAX_HANDLERS];   // sorted by cmd
+    uint8_t count;
+    OWXHandler fallback;
+
+#if OW_HANDLER_TABLE == OW_HANDLER_TABLE_DENSE
+    uint8_t index[256];               // cmd → entry + 1, 0 = no handler
+
+    void rebuild_index() {
+        memset(index, 0, sizeof(index));
+        for (uint8_t i = 0; i < count; i++)
+            index[entries[i].cmd] = i + 1;
+    }
+#else
+    void rebuild_index() {}
+#endif
+
+    // Position of cmd in entries, or where it would be inserted
+    uint8_t lower_bound(uint8_t cmd) const {
+        uint8_t lo = 0, hi = count;
+        while (lo < hi) {
+            uint8_t mid = (lo + hi) >> 1;
+            if (entries[mid].cmd < cmd) lo = mid + 1;
+            else hi = mid;
+        }
+        return lo;
+    }
+
+public:
+    OWXHandlerTable() : count(0) {
+        fallback.fn = nullptr;
+        fallback.context = nullptr;
+        rebuild_index();
+    }
+
+    // Adds or replaces the handler for cmd; false when the table is full
+    bool add(uint8_t cmd, OWXHandler handler) {
+        if (handler.fn == nullptr) return remove(cmd);
+
+        uint8_t pos = lower_bound(cmd);
+        if (pos < count && entries[pos].cmd == cmd) {
+            entries[pos].handler = handler;
+            return true;
+        }
+        if (count >= OW_MAX_HANDLERS) return false;
+
+        memmove(&entries[pos + 1], &entries[pos], (count - pos) * sizeof(Entry));
+        entries[pos].cmd = cmd;
+        entries[pos].handler = handler;
+        count++;
+        rebuild_index();
+        return true;
+    }
+
+    bool remove(uint8_t cmd) {
+        uint8_t pos = lower_bound(cmd);
+        if (pos >= count || entries[pos].cmd != cmd) return false;
+
+        memmove(&entries[pos], &entries[pos + 1], (count - pos - 1) * sizeof(Entry));
+        count--;
+        rebuild_index();
+        return true;
+    }
+
+    void setFallback(OWXHandler handler) { fallback = handler; }
+
+    // Handler for cmd (registered one first, then the catch-all), nullptr if none
+    const OWXHandler *find(uint8_t cmd) const {
+#if OW_HANDLER_TABLE == OW_HANDLER_TABLE_DENSE
+        uint8_t slot = index[cmd];
+        if (slot) return &entries[slot - 1].handler;
+#else
+        uint8_t pos = lower_bound(cmd);
+        if (pos < count && entries[pos].cmd == cmd) return &entries[pos].handler;
+#endif
+        return fallback.fn ? &fallback : nullptr;
+    }
+
+    uint8_t size() const { return count; }
+};
@@ -0,0 +1,39 @@
+/*
+    OWX shared protocol engine state
+
+    The protocol code (dispatch, decoders, replies) is one copy in EmulatorBase whatever the
+    number of instances. The state of the transaction being parsed is kept once as well: the hub
+    serves one item at a time, so the addressed device, the NACK reason of a refused frame and
+    the sequence number of a sequenced command live here for every emulator. That is a few bytes,
+    not a per-device saving worth planning around. Everything else an instance holds is device
+    state and stays per instance: ROM, scratchpad, queues, registries, statistics, the sequence
+    reply cache, bulk transfer and trace ring.
+
+    The one large table devices often have in common is the handler table. An emulator built with
+    OW_FEATURE_SHARED_HANDLERS (see FeatureEmulator) uses owx_shared_handlers() instead of a table
+    of its own: addHandler() / setCustomHandler() on any such instance change it for all of them,
+    and a handler finds the device that was addressed with EmulatorBase::serving().
+
+    duty() of two emulators must not run concurrently: one hub, or several hubs serviced from
+    the same context.
+*/
+#pragma once
+#include <stdint.h>
+#include <OWX_Dispatch.h>
+
+class EmulatorBase;
+
+struct OWXEngine {
+    EmulatorBase *device;   // emulator in duty(), or running its handler in processPending()
+    uint8_t nackReason;     // OW_NACK_* of the frame a decoder refused
+    bool seqActive;         // the command being dispatched carries seqCurrent
+    uint8_t seqCurrent;
+};
+
+// Handler table of every emulator with OW_FEATURE_SHARED_HANDLERS. A function-local static of an
+// inline function is one object per program whatever the translation unit, and is not linked
+// into a program without such an emulator.
+inline OWXHandlerTable *owx_shared_handlers() {
+    static OWXHandlerTable table;
+    return &table;
+}
@@ -0,0 +1,81 @@
+/*
+    OWX lock-free single-producer / single-consumer queue
+
+    Fixed capacity (power of two, up to 128), no allocation. The bus path (duty(), the
+    producer) and loop() (the consumer) each own one index, so neither side ever waits on
+    the other. A slot is published by the release store of head after it has been filled
+    completely, so the consumer never sees a half-written message.
+
+    Two-phase produce avoids a copy: fill the slot returned by reserve(), then commit().
+*/
+#pragma once
+#include <stdint.h>
+#include <atomic>
+
+template <typename T, uint8_t N>
+class OWXSpscQueue
+{
+    static_assert(N >= 2 && N <= 128 && (N & (N - 1)) == 0, "OWXSpscQueue capacity must be a power of two in 2..128");
+
+private:
+    T slots[N];
+    std::atomic<uint8_t> head;   // next slot to write, owned by the producer
+    std::atomic<uint8_t> tail;   // next slot to read, owned by the consumer
+
+public:
+    OWXSpscQueue() : head(0), tail(0) {}
+
+    // --- producer side ---
+
+    // Returns the next free slot, or nullptr if the queue is full
+    T *reserve() {
+        uint8_t h = head.load(std::memory_order_relaxed);
+        if ((uint8_t)(h - tail.load(std::memory_order_acquire)) >= N) return nullptr;
+        return &slots[h & (N - 1)];
+    }
+
+    // Publishes the slot returned by reserve()
+    void commit() {
+        head.store((uint8_t)(head.load(std::memory_order_relaxed) + 1), std::memory_order_release);
+    }
+
+    bool push(const T &item) {
+        T *slot = reserve();
+        if (!slot) return false;
+        *slot = item;
+        commit();
+        return true;
+    }
+
+    // --- consumer side ---
+
+    // Oldest message, or nullptr if the queue is empty
+    const T *front() const {
+        uint8_t t = tail.load(std::memory_order_relaxed);
+        if (head.load(std::memory_order_acquire) == t) return nullptr;
+        return &slots[t & (N - 1)];
+    }
+
+    // Drops the oldest message
+    void pop() {
+        uint8_t t = tail.load(std::memory_order_relaxed);
+        if (head.load(std::memory_order_acquire) == t) return;
+        tail.store((uint8_t)(t + 1), std::memory_order_release);
+    }
+
+    bool pop(T &item) {
+        const T *slot = front();
+        if (!slot) return false;
+        item = *slot;
+        pop();
+        return true;
+    }
+
+    // --- either side (snapshot) ---
+    uint8_t size() const {
+        return (uint8_t)(head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire));
+    }
+    bool empty() const { return size() == 0; }
+    bool full() const { return size() >= N; }
+    static uint8_t capacity() { return N; }
+};
@@ -0,0 +1,74 @@
+/*
+    OWX typed receive callbacks
+
+    onReceive<T>(fn) subscribes a plain function to every received value of type T, or to one
+    struct ID given to registerStruct(). The value type is fixed when subscribing: the stored
+    thunk is the instantiation for T, so a value reaches the application with one indirect call
+    in its own type, without available() / availableType() / getX() / clearAvailable().
+
+        OW_RECEIVE_DEFERRED  the value is queued as before and fn runs from dispatchPending()
+                             in loop(), oldest value first (default)
+        OW_RECEIVE_INLINE    fn runs from duty() once the frame is verified, before the ACK, and
+                             the value is never queued. Lowest latency, but fn runs inside the
+                             master's turnaround budget (OW_TURNAROUND_US): keep it to a few
+                             stores, no Serial, no I2C.
+
+    Function pointers only, no std::function, no heap. Subscribe from setup(): a subscription is
+    not updated atomically against a duty() running from an interrupt. The subscriptions live in
+    an OWXReceiverTable owned by the configuration, only with OW_FEATURE_CALLBACKS.
+*/
+#pragma once
+#include <stdint.h>
+#include <string.h>
+
+#define OW_RECEIVE_DEFERRED 0
+#define OW_RECEIVE_INLINE   1
+
+#define OW_RECEIVE_SCALARS  7   // subscribable scalar types, OW_CMD_UINT8..OW_CMD_UINT32
+
+struct OWXReceiver {
+    typedef void (*AnyFn)();
+    typedef void (*Thunk)(AnyFn fn, const uint8_t *value);
+
+    Thunk thunk;     // instantiation for the subscribed type, nullptr = no subscription
+    AnyFn fn;        // the application's function, cast back by thunk
+    uint8_t mode;    // OW_RECEIVE_*
+
+    void operator()(const uint8_t *value) const { thunk(fn, value); }
+    bool subscribed() const { return thunk != nullptr; }
+    bool inlined() const { return thunk != nullptr && mode == OW_RECEIVE_INLINE; }
+
+    // Scalars: the LSB-first payload bytes copied into a T
+    template <typename T>
+    static void call_value(AnyFn fn, const uint8_t *value) {
+        T v;
+        memcpy(&v, value, sizeof(T));
+        reinterpret_cast<void (*)(T)>(fn)(v);
+    }
+
+    // Structs: the registered destination, already decoded in place
+    template <typename T>
+    static void call_struct(AnyFn fn, const uint8_t *dest) {
+        reinterpret_cast<void (*)(const T &)>(fn)(*reinterpret_cast<const T *>(dest));
+    }
+
+    template <typename T>
+    static OWXReceiver forValue(void (*fn)(T), uint8_t mode) {
+        OWXReceiver r = { fn ? call_value<T> : nullptr, reinterpret_cast<AnyFn>(fn), mode };
+        return r;
+    }
+
+    template <typename T>
+    static OWXReceiver forStruct(void (*fn)(const T &), uint8_t mode) {
+        OWXReceiver r = { fn ? call_struct<T> : nullptr, reinterpret_cast<AnyFn>(fn), mode };
+        return r;
+    }
+};
+
+// Subscriptions of one emulator: scalars by OW_CMD_* - OW_CMD_UINT8, then one per struct slot
+template <uint8_t Structs>
+struct OWXReceiverTable {
+    OWXReceiver entries[OW_RECEIVE_SCALARS + Structs];
+
+    OWXReceiverTable() { memset(entries, 0, sizeof(entries)); }
+};
@@ -0,0 +1,119 @@
+/*
+    OWX timestamped sample FIFO
+
+    The application pushes readings as it takes them (pushSample() from loop()); the master
+    drains them with OW_LOW_CMD_DRAIN_SAMPLES, many records per frame, and can poll far less
+    often than the sensor is sampled without losing readings.
+
+    loop() is the producer and owns head; duty() is the consumer and owns tail. Records are
+    removed only when the master acknowledges them (ACK_SEQ of the next request), so a drain
+    reply lost on the bus is simply sent again.
+
+    Storage is caller-provided, so instances that don't use it pay nothing:
+        OWXSampleFifo<32> fifo;        // 32 records, power of two
+        slaveEmu.useSampleFifo(fifo);
+*/
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+
+// One sample as stored and sent: CHANNEL | TYPE | TIMESTAMP (4) | VALUE (4), LSB first
+struct OWXSample {
+    uint32_t timestamp;   // millis() when pushed, unless the application gives its own
+    uint8_t value[4];     // LSB first, unused bytes 0
+    uint8_t channel;      // application defined
+    uint8_t type;         // OW_CMD_* scalar type of value
+};
+
+#define OWX_SAMPLE_RECORD_SIZE 10
+
+class OWXSampleFifoBase
+{
+private:
+    OWXSample *slots;
+    uint8_t mask;
+    std::atomic<uint8_t> head;   // next slot to write, owned by loop()
+    std::atomic<uint8_t> tail;   // oldest unacknowledged record, owned by duty()
+    uint16_t tailSeq;            // sequence number of the record at tail
+    uint16_t lostSamples;        // pushes refused because the FIFO was full
+    uint16_t overflowEvents;     // times the FIFO ran full
+    bool wasFull;
+
+protected:
+    OWXSampleFifoBase(OWXSample *slots_, uint8_t capacity)
+        : slots(slots_), mask(capacity - 1), head(0), tail(0), tailSeq(0),
+          lostSamples(0), overflowEvents(0), wasFull(false) {}
+
+public:
+    OWXSampleFifoBase(const OWXSampleFifoBase &) = delete;
+    OWXSampleFifoBase &operator=(const OWXSampleFifoBase &) = delete;
+
+    // --- producer side (loop()) ---
+
+    bool push(uint8_t channel, uint8_t type, const void *value, uint8_t len, uint32_t timestamp) {
+        uint8_t h = head.load(std::memory_order_relaxed);
+        if ((uint8_t)(h - tail.load(std::memory_order_acquire)) > mask) {
+            lostSamples++;
+            if (!wasFull) overflowEvents++;
+            wasFull = true;
+            return false;
+        }
+        wasFull = false;
+
+        OWXSample &s = slots[h & mask];
+        s.timestamp = timestamp;
+        memset(s.value, 0, sizeof(s.value));
+        memcpy(s.value, value, len);
+        s.channel = channel;
+        s.type = type;
+        head.store((uint8_t)(h + 1), std::memory_order_release);
+        return true;
+    }
+
+    // --- consumer side (duty()) ---
+
+    // Drops the records before ack_seq; an ack outside the stored range drops nothing
+    uint8_t acknowledge(uint16_t ack_seq) {
+        uint16_t n = (uint16_t)(ack_seq - tailSeq);
+        if (n == 0 || n > size()) return 0;
+        tail.store((uint8_t)(tail.load(std::memory_order_relaxed) + n), std::memory_order_release);
+        tailSeq = ack_seq;
+        return (uint8_t)n;
+    }
+
+    // Record i after the oldest unacknowledged one, i < size()
+    const OWXSample &peek(uint8_t i) const { return slots[(tail.load(std::memory_order_relaxed) + i) & mask]; }
+
+    uint8_t size() const {
+        return (uint8_t)(head.load(std::memory_order_acquire) - tail.load(std::memory_order_relaxed));
+    }
+    uint16_t firstSeq() const { return tailSeq; }
+    uint16_t lost() const { return lostSamples; }
+    uint16_t overflows() const { return overflowEvents; }
+    uint8_t capacity() const { return mask + 1; }
+
+    // Packs record i into its 10 byte wire form
+    void encode(uint8_t i, uint8_t *out) const {
+        const OWXSample &s = peek(i);
+        out[0] = s.channel;
+        out[1] = s.type;
+        out[2] = (uint8_t)s.timestamp;
+        out[3] = (uint8_t)(s.timestamp >> 8);
+        out[4] = (uint8_t)(s.timestamp >> 16);
+        out[5] = (uint8_t)(s.timestamp >> 24);
+        memcpy(&out[6], s.value, 4);
+    }
+};
+
+template <uint8_t N>
+class OWXSampleFifo : public OWXSampleFifoBase
+{
+    static_assert(N >= 2 && N <= 128 && (N & (N - 1)) == 0, "OWXSampleFifo capacity must be a power of two in 2..128");
+
+private:
+    OWXSample records[N];
+
+public:
+    OWXSampleFifo() : OWXSampleFifoBase(records, N) {}
+};
@@ -0,0 +1,144 @@
+/*
+    OWX double-buffered scratchpad
+
+    Writers (loop() or a handler) stage bytes into the back buffer; publish() makes the
+    staged image visible in one atomic index store and then refreshes the back buffer from
+    it, so later partial writes keep the rest of the image. duty() streams the front buffer
+    it picked at the start of OW_READ_SCRATCHPAD, so the master always gets one consistent
+    snapshot, never a half-updated float.
+
+    The hub is expected to be serviced on the same core as the writers (hub.poll() from
+    loop(), or from an interrupt): a read then never overlaps the refresh of the buffer it
+    is streaming.
+
+    Change tracking: stage() marks the bytes it actually modifies, publish() folds them into
+    the "changed" map and bumps the generation counter. OW_READ_SCRATCHPAD_CHANGED hands that
+    map out with take_changes(); the bytes of the last reply stay in the "sent" map until the
+    master confirms their generation, so a lost reply is sent again instead of lost. The
+    generation skips 0, which is what a master that has received no reply yet confirms: a lost
+    first reply is sent again as well.
+    publish() stores the new front image before it sets change bits: a read in between can only
+    report a byte twice, never miss it.
+
+    Size is fixed per instance at compile time:
+        OWXScratchpad<16>       sensorPad;      // 16 bytes
+        OWXScratchpad<8, true>  crcPad;         // 8 bytes + CRC8 appended at publish time
+*/
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <OWX_CRC.h>
+
+class OWXScratchpadBase
+{
+private:
+    uint8_t *storage;             // two images of stride bytes
+    uint8_t *maps;                // staged, changed and sent bitmaps of map_len bytes, one bit per data byte
+    uint8_t size;                 // data bytes
+    uint8_t stride;               // data bytes + optional CRC8
+    uint8_t map_len;
+    uint8_t gen;                  // bumped by every publish() that changes something, never 0
+    uint8_t sent_gen;             // generation of the last OW_READ_SCRATCHPAD_CHANGED reply
+    bool staged_any;
+    std::atomic<uint8_t> front;   // image the master reads
+
+    uint8_t *staged_map() { return maps; }
+    uint8_t *changed_map() { return maps + map_len; }
+    uint8_t *sent_map() { return maps + 2 * map_len; }
+
+protected:
+    OWXScratchpadBase(uint8_t *storage_, uint8_t *maps_, uint8_t size_, bool append_crc)
+        : storage(storage_), maps(maps_), size(size_), stride(append_crc ? size_ + 1 : size_),
+          map_len((size_ + 7) / 8), gen(1), sent_gen(0), staged_any(false), front(0) {
+        memset(storage, 0, 2 * stride);
+        memset(maps, 0, 3 * map_len);
+        // The master has seen nothing yet: the first changed-read returns the whole image
+        for (uint8_t i = 0; i < size; i++) changed_map()[i >> 3] |= (1 << (i & 7));
+    }
+
+public:
+    OWXScratchpadBase(const OWXScratchpadBase &) = delete;
+    OWXScratchpadBase &operator=(const OWXScratchpadBase &) = delete;
+
+    // Stages len bytes at addr; not visible to the master until publish()
+    bool stage(const uint8_t *data, uint8_t len, uint8_t addr) {
+        if (addr > size || len > size - addr) return false;
+        uint8_t *image = back_image() + addr;
+        for (uint8_t i = 0; i < len; i++) {
+            if (image[i] == data[i]) continue;
+            image[i] = data[i];
+            staged_map()[(addr + i) >> 3] |= (1 << ((addr + i) & 7));
+            staged_any = true;
+        }
+        return true;
+    }
+
+    // Makes the staged image the one the master reads
+    void publish() {
+        uint8_t back = front.load(std::memory_order_relaxed) ^ 1;
+        uint8_t *image = &storage[back * stride];
+        if (stride > size) image[size] = OWXCrc8::compute(image, size);
+
+        front.store(back, std::memory_order_release);
+
+        // New back buffer starts as a copy of what was just published
+        memcpy(&storage[(back ^ 1) * stride], image, stride);
+
+        if (staged_any) {
+            for (uint8_t i = 0; i < map_len; i++) {
+                changed_map()[i] |= staged_map()[i];
+                staged_map()[i] = 0;
+            }
+            staged_any = false;
+            if (++gen == 0) gen = 1;
+        }
+    }
+
+    // Drops everything staged since the last publish(): the back buffer becomes the front
+    // image again, nothing is marked changed
+    void discard() {
+        const uint8_t front_index = front.load(std::memory_order_relaxed);
+        memcpy(&storage[(front_index ^ 1) * stride], &storage[front_index * stride], stride);
+        memset(staged_map(), 0, map_len);
+        staged_any = false;
+    }
+
+    // Bitmap of bytes to send for OW_READ_SCRATCHPAD_CHANGED, nullptr if nothing changed.
+    // acked_gen is the generation of the last reply the master received intact, 0 for none.
+    const uint8_t *take_changes(uint8_t acked_gen) {
+        bool resend = acked_gen != sent_gen;
+        bool any = false;
+        for (uint8_t i = 0; i < map_len; i++) {
+            uint8_t bits = changed_map()[i] | (resend ? sent_map()[i] : 0);
+            changed_map()[i] = 0;
+            sent_map()[i] = bits;
+            any |= bits != 0;
+        }
+        sent_gen = gen;
+        return any ? sent_map() : nullptr;
+    }
+
+    uint8_t generation() const { return gen; }
+
+    // Snapshot for the reader: stays valid for the whole transaction
+    const uint8_t *read_image() const { return &storage[front.load(std::memory_order_acquire) * stride]; }
+    uint8_t read_length() const { return stride; }
+
+    uint8_t *back_image() { return &storage[(front.load(std::memory_order_relaxed) ^ 1) * stride]; }
+    uint8_t length() const { return size; }
+    bool appendsCrc() const { return stride > size; }
+};
+
+template <uint8_t Size, bool AppendCrc = false>
+class OWXScratchpad : public OWXScratchpadBase
+{
+    static_assert(Size > 0 && Size < 255, "OWXScratchpad size must be 1..254");
+
+private:
+    uint8_t buffers[2 * (Size + (AppendCrc ? 1 : 0))];
+    uint8_t bitmaps[3 * ((Size + 7) / 8)];
+
+public:
+    OWXScratchpad() : OWXScratchpadBase(buffers, bitmaps, Size, AppendCrc) {}
+};
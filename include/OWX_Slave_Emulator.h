@@ -15,8 +15,9 @@
         - Implements a OneWire device emulator.
         - Supports sending and receiving various data types: int8, uint8, int16, uint16, int32, uint32, float32, and structures.
         - Handles scratchpad memory and packet transmission with CRC8.
-        - Allows custom command handling via callback (`setCustomHandler`).
+        - Allows custom command handling via callbacks (`setCustomHandler`, `addHandler`).
         - API for checking new data availability (`available()`, `availableType()`, `clearAvailable()`).
+        - Typed receive callbacks (`onReceive<T>()`), run inline from duty() or from `dispatchPending()`.
         - Easy access to the last received data through getters (`getInt8()`, `getFloat()`, etc.).
         - Fully compatible with PlatformIO and Arduino/ESP8266.
         - Easy integration with OneWireHub and other bus devices.
@@ -59,7 +60,18 @@
 #include <Arduino.h>
 #include <OneWireHub.h>
 #include <OneWireItem.h>
-#include <functional>
+#include <type_traits>
+#include <atomic>
+#include <OWX_CRC.h>
+#include <OWX_Queue.h>
+#include <OWX_Dispatch.h>
+#include <OWX_Receive.h>
+#include <OWX_Engine.h>
+#include <OWX_Scratchpad.h>
+#include <OWX_Stats.h>
+#include <OWX_Trace.h>
+#include <OWX_Array.h>
+#include <OWX_Samples.h>
 
 // Packet command definitions
 
@@ -72,18 +84,145 @@
 #define OW_CMD_INT32       0x10  // payload: 4 bytes (int32_t,)
 #define OW_CMD_FLOAT32     0x11  
 #define OW_CMD_CHAR8       0x13  // payload: 1 byte (char)
-#define OW_CMD_STRUCT      0x14  
+#define OW_CMD_STRUCT      0x14  // payload: 1 byte struct ID + sizeof(struct) bytes (registerStruct)
+#define OW_CMD_BATCH       0x15  // payload: several [ OW_CMD_* | LEN | VALUE ] entries under one CRC
+#define OW_CMD_ARRAY_INT16   0x16  // payload: ID | ENCODING | START | COUNT | elements (registerArray)
+#define OW_CMD_ARRAY_UINT16  0x17
+#define OW_CMD_ARRAY_INT32   0x18
+#define OW_CMD_ARRAY_FLOAT32 0x19
+
+#define OW_CMD_FIRST_TYPE  OW_CMD_UINT8          // data type commands span 0x0C..0x19,
+#define OW_CMD_LAST_TYPE   OW_CMD_ARRAY_FLOAT32  // one bit each in a BasicEmulator type mask
 
 #define OW_HANDLER_COMMAND 0xFF // користувацька команда для обробки користувацьким обробником
+#define OW_HANDLER_COMMAND_ASYNC 0xFE  // handler command executed later from loop() (split-phase)
+#define OW_HANDLER_STATUS  0xFD        // poll state of the last split-phase handler command
 
 
 #define OW_READ_SCRATCHPAD     0x20  
+#define OW_READ_SCRATCHPAD_RANGE   0x21  // [ 0x21 | OFFSET | LEN ] → [ DATA | CRC8 ]
+#define OW_READ_SCRATCHPAD_CHANGED 0x22  // [ 0x22 | LAST_GEN ] → UNCHANGED or only the modified regions
+#define OW_LOW_CMD_READ_VARIABLES  0x28  // [ 0x28 | COUNT | IDs | CRC8 ] → one typed frame per ID (bindVariable)
+#define OW_LOW_CMD_DRAIN_SAMPLES   0x29  // [ 0x29 | MAX | ACK_SEQ (2) | CRC8 ] → header + up to MAX sample records
+#define OW_LOW_CMD_SEQUENCED       0x2A  // [ 0x2A | SEQ | command ... ] → a repeated SEQ is answered from the reply cache
+#define OW_LOW_CMD_REPLAY          0x2B  // [ 0x2B | SEQ ] → reply of sequenced transaction SEQ, without resending it
+#define OW_LOW_CMD_ALARM           0x2C  // [ 0x2C | CLEAR_MASK ] → [ FLAGS | CRC8 ], clears the latched sources in CLEAR_MASK
+#define OW_LOW_CMD_CAPABILITIES    0x2D  // [ 0x2D ] → [ VERSION | FEATURES (2) | MAX_PAYLOAD | SCRATCHPAD_LEN | TURNAROUND_US | CRC8 ]
 #define OW_CMD_ACK         0x30 
+#define OW_CMD_NACK        0x31  // negative acknowledge; followed by an OW_NACK_* reason except in bulk transfers
+#define OW_CMD_ACCEPTED    0x32  // split-phase handler command queued for loop()
+#define OW_CMD_BUSY        0x33  // split-phase handler command refused, previous one not finished
+#define OW_SCRATCHPAD_UNCHANGED 0x34  // reply to OW_READ_SCRATCHPAD_CHANGED: nothing new, nothing follows
+#define OW_SCRATCHPAD_CHANGED   0x35  // reply to OW_READ_SCRATCHPAD_CHANGED: regions follow
+
+// Reason byte after OW_CMD_NACK for SEND_VARIABLE, handler and REPLAY commands: [ 0x31 | REASON ]
+#define OW_NACK_CRC           0x01  // frame CRC8 mismatch
+#define OW_NACK_LENGTH        0x02  // LEN is 0, over the configuration's max payload or wrong for the data type;
+                                    // batch: can never be accepted as one frame, split it
+#define OW_NACK_UNKNOWN_TYPE  0x03  // data type unknown / not enabled, or unknown array encoding
+#define OW_NACK_BUSY          0x04  // receive queue full, or the struct's last value not consumed yet
+                                    // (OW_QUEUE_REJECT): nothing stored, retry later
+#define OW_NACK_UNKNOWN_ID    0x05  // struct / array ID not registered
+#define OW_NACK_UNHANDLED     0x06  // no handler for the command, or the handler returned false
+#define OW_NACK_NOT_EXECUTED  0x07  // REPLAY: SEQ is not the last executed transaction, send the command again
+
+// Split-phase handler states reported by OW_HANDLER_STATUS
+#define OW_ASYNC_IDLE      0x00
+#define OW_ASYNC_PENDING   0x01  // accepted, waiting for processPending()
+#define OW_ASYNC_RUNNING   0x02
+#define OW_ASYNC_DONE      0x03  // handler returned true
+#define OW_ASYNC_FAILED    0x04  // handler returned false or no handler for the command
+
+// "Data ready" sources that make the slave answer the conditional (alarm) search 0xEC
+#define OW_ALARM_SAMPLES    0x01  // sample FIFO not empty (clears itself when drained)
+#define OW_ALARM_HANDLER    0x02  // split-phase handler finished; cleared by OW_HANDLER_STATUS
+#define OW_ALARM_SCRATCHPAD 0x04  // published scratchpad bytes changed; cleared by a full or CHANGED read
+#define OW_ALARM_USER       0x08  // raiseAlarm() from the application
+#define OW_ALARM_ALL        0x0F
+
+// OW_LOW_CMD_CAPABILITIES reply
+#define OW_PROTOCOL_VERSION 1
+#define OW_CAP_OVERDRIVE    0x0001  // hub accepts overdrive skip / match ROM 0x3C / 0x69 (setOverdrive())
+#define OW_CAP_SEQUENCED    0x0002  // OW_LOW_CMD_SEQUENCED / OW_LOW_CMD_REPLAY
+#define OW_CAP_ALARM        0x0004  // data ready flag for the conditional search 0xEC
+#define OW_CAP_BULK         0x0008  // bulk buffer installed (setBulkBuffer())
+#define OW_CAP_SAMPLES      0x0010  // sample FIFO installed (useSampleFifo())
+#define OW_CAP_STATS        0x0020  // OW_LOW_CMD_READ_STATS returns counters (OW_STATS=1)
+
+// Optional subsystems of a FeatureEmulator configuration. A feature left out costs no RAM, its
+// code is never referenced (dropped at link time) and its low-level commands are ignored like
+// unknown ones. OW_READ_SCRATCHPAD, OW_LOW_CMD_SEND_VARIABLE_ and OW_LOW_CMD_CAPABILITIES are
+// always there.
+#define OW_FEATURE_HANDLERS      0x0001  // OW_HANDLER_COMMAND, setCustomHandler(), addHandler()
+#define OW_FEATURE_ASYNC         0x0002  // OW_HANDLER_COMMAND_ASYNC, processPending() (needs HANDLERS)
+#define OW_FEATURE_SEQUENCED     0x0004  // OW_LOW_CMD_SEQUENCED / OW_LOW_CMD_REPLAY reply cache
+#define OW_FEATURE_PARTIAL_READ  0x0008  // OW_READ_SCRATCHPAD_RANGE / OW_READ_SCRATCHPAD_CHANGED
+#define OW_FEATURE_VARIABLES     0x0010  // bindVariable(), OW_LOW_CMD_READ_VARIABLES
+#define OW_FEATURE_SAMPLES       0x0020  // useSampleFifo(), OW_LOW_CMD_DRAIN_SAMPLES
+#define OW_FEATURE_ALARM         0x0040  // conditional search 0xEC, OW_LOW_CMD_ALARM
+#define OW_FEATURE_BULK          0x0080  // setBulkBuffer(), OW_LOW_CMD_BULK_*
+#define OW_FEATURE_STATS         0x0100  // counters, OW_LOW_CMD_READ_STATS
+#define OW_FEATURE_CALLBACKS     0x0200  // onReceive() subscriptions and dispatchPending()
+#define OW_FEATURES_ALL          0x03FF
+#define OW_FEATURE_SHARED_HANDLERS 0x0400  // HANDLERS in owx_shared_handlers(), one table for every such instance
 
+// Slave timing the master has to allow for, CPU time of duty() and so the same at both speeds
+#ifndef OW_TURNAROUND_US
+#define OW_TURNAROUND_US 50   // between the master's last byte of a command and the first read slot of the reply
+#endif
+#define OW_BYTE_GAP_US 5      // longest the slave takes between any other two bytes of a transaction
 
-#define OW_SCRATCHPAD_SIZE 9 
+#define OW_LOW_CMD_READ_STATS 0x50  // [ 0x50 | FLAGS ] → [ LEN | OWXStatsBlock | CRC8 ]
+#define OW_STATS_FLAG_CLEAR   0x01  // FLAGS: reset all counters after this read
+
+// Bulk (fragmented) transfer commands, see BULK TRANSFER FORMAT below
+#define OW_LOW_CMD_BULK_BEGIN  0x40
+#define OW_LOW_CMD_BULK_CHUNK  0x41
+#define OW_LOW_CMD_BULK_STATUS 0x42
+#define OW_LOW_CMD_BULK_END    0x43
+
+
+#ifndef OW_SCRATCHPAD_SIZE
+#define OW_SCRATCHPAD_SIZE 9   // size of the built-in scratchpad, useScratchpad() installs another size
+#endif
+#ifndef OW_SCRATCHPAD_MAX_REGIONS
+#define OW_SCRATCHPAD_MAX_REGIONS 8   // regions per OW_READ_SCRATCHPAD_CHANGED reply, the last one absorbs the rest
+#endif
 #define OW_MAX_PAYLOAD 32  
 
+#ifndef OW_MAX_STRUCTS
+#define OW_MAX_STRUCTS 4     // struct types that can be registered per emulator
+#endif
+static_assert(OW_MAX_STRUCTS <= 16, "OW_MAX_STRUCTS: at most 16 struct types per emulator");
+
+#ifndef OW_MAX_ARRAYS
+#define OW_MAX_ARRAYS 2      // array buffers that can be registered per emulator
+#endif
+
+#ifndef OW_MAX_VARIABLES
+#define OW_MAX_VARIABLES 8   // live variables the master can read by ID (bindVariable)
+#endif
+#define OW_MAX_READ_IDS 8    // IDs per OW_LOW_CMD_READ_VARIABLES request
+#define OW_SAMPLE_DRAIN_MAX 16   // sample records per OW_LOW_CMD_DRAIN_SAMPLES reply
+
+#ifndef OW_RX_QUEUE_SIZE
+#define OW_RX_QUEUE_SIZE 8   // received values buffered between duty() and loop(), power of two
+#endif
+
+// What the bus path does when the receive queue is full
+#define OW_QUEUE_REJECT      0   // NACK OW_NACK_BUSY, raiseDeviceError(): the master retries later (default)
+#define OW_QUEUE_DROP_NEWEST 1   // ACK anyway and discard the new value
+
+#define OW_BULK_CHUNK_SIZE OW_MAX_PAYLOAD   // every chunk except the last one carries exactly this many bytes
+#define OW_BULK_MAX_CHUNKS 256              // sequence number is one byte → up to 8 KB per transfer
+#define OW_BULK_STATUS_MAX 64               // max chunks covered by one status bitmap
+#ifndef OW_BULK_FOLD_PER_BYTE
+#define OW_BULK_FOLD_PER_BYTE 1             // CRC16 bytes verified per received chunk byte (byte gap budget)
+#endif
+#ifndef OW_BULK_FOLD_PER_REPLY
+#define OW_BULK_FOLD_PER_REPLY 32           // CRC16 bytes verified before a STATUS / END reply (turnaround budget)
+#endif
+
 
 /*
     ┌──────────────────────────────────────────────────────────────────────────────┐
@@ -97,6 +236,16 @@
     │           │       │       └────────── length in bytes                        │
     │           │       └────────────────── command describing data type           │
     │           └────────────────────────── main command "send variable"           │
+    ├──────────────────────────────────────────────────────────────────────────────┤
+    │  Struct:  0x01 | 0x14 | 1+N | ID | N struct bytes | CRC                      │
+    │           ID selects the destination given to registerStruct()               │
+    │  Batch:   0x01 | 0x15 | LEN | T1 | L1 | V1 | T2 | L2 | V2 ... | CRC           │
+    │           T = OW_CMD_* (scalar or STRUCT), one ACK for all entries,          │
+    │           entries are delivered in order and only if all of them are valid   │
+    │  Array:   0x01 | 0x16..0x19 | LEN | ID | ENC | START | COUNT | DATA | CRC      │
+    │           COUNT elements for indexes START.. of the buffer given to          │
+    │           registerArray(); ENC = OW_ARRAY_RAW or OW_ARRAY_DELTA_VARINT        │
+    │           (see OWX_Array.h), a longer block is sent as several frames         │
     └──────────────────────────────────────────────────────────────────────────────┘
 */
 
@@ -107,12 +256,246 @@
     |     [   CMD_HANDLER_COMMAND 0xFF ] │           [   CMD  ]                    |
     |            (1 byte)                │          (1 byte)                       |
     |____________________________________|_________________________________________|
+    |  Split-phase (handler runs later from loop() via processPending()):         |
+    |     [ 0xFE | CMD ]   slave → ACCEPTED (0x32) or BUSY (0x33)                  |
+    |     [ 0xFD ]         slave → [ STATE | CMD | RESULT | CRC8 ]                 |
+    |                      STATE = OW_ASYNC_*, RESULT set by setHandlerResult()   |
+    |  0xFF with no handler or a handler returning false → [ 0x31 | 0x06 ]        |
+    |______________________________________________________________________________|
 
 
  */
 
+/*
+    ┌──────────────────────────────────────────────────────────────────────────────┐
+    │                 OWX REPLIES, NACK REASONS AND SEQUENCED RETRIES              │
+    ├──────────────────────────────────────────────────────────────────────────────┤
+    │ SEND_VARIABLE / 0xFF handler → [ 0x30 ] ACK  or  [ 0x31 | REASON ] NACK      │
+    │ 0xFE split-phase handler     → [ 0x32 ] ACCEPTED  or  [ 0x33 ] BUSY          │
+    │         REASON = OW_NACK_*. A NACK means nothing was stored or executed,     │
+    │         except OW_NACK_UNHANDLED from a handler that ran and returned false. │
+    │         No reply (master reads 0xFF): the frame was cut off, or its LEN      │
+    │         byte was hit and the slave is still waiting for payload.             │
+    ├──────────────────────────────────────────────────────────────────────────────┤
+    │ SEQUENCED: [ 0x2A | SEQ | 0x01 ... ]  [ 0x2A | SEQ | 0xFF | CMD ]            │
+    │            [ 0x2A | SEQ | 0xFE | CMD ]                                       │
+    │         The command runs as usual and its reply is cached with SEQ. The      │
+    │         same command sent again with the same SEQ is not executed again;     │
+    │         the cached reply is sent instead. Other commands ignore SEQ.         │
+    │ REPLAY   : [ 0x2B | SEQ ]                                                    │
+    │         slave → cached reply if SEQ is the last executed sequenced command,  │
+    │         else [ 0x31 | OW_NACK_NOT_EXECUTED ]: the command never ran          │
+    ├──────────────────────────────────────────────────────────────────────────────┤
+    │  The master bumps SEQ (mod 256) for every new command. A reply lost on the   │
+    │  bus is recovered with REPLAY (2 bytes) instead of resending the frame.      │
+    │  NACKs for bad CRC / length / busy are not cached: the command didn't run,   │
+    │  the retry with the same SEQ executes it.                                    │
+    └──────────────────────────────────────────────────────────────────────────────┘
+*/
+
+/*
+    ┌──────────────────────────────────────────────────────────────────────────────┐
+    │                  OWX BULK TRANSFER FORMAT (MASTER → SLAVE)                   │
+    ├──────────────────────────────────────────────────────────────────────────────┤
+    │ BEGIN : [ 0x40 | TOTAL_LEN (2, LSB first) | CRC16 (2, LSB first) | CRC8 ]    │
+    │         slave → ACK if it fits the buffer set with setBulkBuffer(), else NACK│
+    │ CHUNK : [ 0x41 | SEQ | LEN | PAYLOAD (LEN) | CRC8 ]        no reply          │
+    │         chunk SEQ lands at offset SEQ * OW_BULK_CHUNK_SIZE                   │
+    │ STATUS: [ 0x42 | FIRST_SEQ | COUNT ]                                         │
+    │         slave → [ FIRST_SEQ | COUNT | BITMAP (COUNT/8 rounded up) | CRC8 ]   │
+    │         bit i set = chunk FIRST_SEQ + i received with good CRC8              │
+    │ END   : [ 0x43 ]  slave → ACK if all chunks present and CRC16 matches        │
+    │         BUSY (0x33) if all chunks are present but the CRC16 check hasn't     │
+    │         caught up yet: send END again (normally after out-of-order chunks)   │
+    ├──────────────────────────────────────────────────────────────────────────────┤
+    │  Commands can follow each other inside one transaction (one ROM match):      │
+    │  BEGIN, CHUNK 0..7, STATUS → resend missing chunks → ... → END               │
+    │  CRC8 covers every byte after the low-level command byte.                    │
+    │  CRC16 is the Dallas CRC16 (OneWireItem::crc16) of the whole transfer.       │
+    └──────────────────────────────────────────────────────────────────────────────┘
+*/
+
+/*
+    ┌──────────────────────────────────────────────────────────────────────────────┐
+    │                      OWX SCRATCHPAD READS (SLAVE → MASTER)                   │
+    ├──────────────────────────────────────────────────────────────────────────────┤
+    │ FULL   : [ 0x20 ]                   slave → all scratchpad bytes             │
+    │ RANGE  : [ 0x21 | OFFSET | LEN ]    slave → [ DATA (LEN) | CRC8 ]            │
+    │          CRC8 covers OFFSET, LEN and DATA; out of range → no reply           │
+    │ CHANGED: [ 0x22 | LAST_GEN ]                                                 │
+    │          slave → [ 0x34 ]  nothing changed since the last CHANGED read       │
+    │          slave → [ 0x35 | GEN | COUNT | { OFFSET | LEN | DATA } x COUNT | CRC8 ]│
+    │          CRC8 covers GEN..last DATA byte                                     │
+    ├──────────────────────────────────────────────────────────────────────────────┤
+    │  LAST_GEN is GEN of the last 0x35 reply the master received intact, 0 before │
+    │  the first one (GEN is never 0). If it doesn't match, the regions of that    │
+    │  reply are sent again with the new ones.                                     │
+    │  The first CHANGED read after power-up returns the whole scratchpad.         │
+    └──────────────────────────────────────────────────────────────────────────────┘
+*/
+
+/*
+    ┌──────────────────────────────────────────────────────────────────────────────┐
+    │                   OWX VARIABLE READ BY ID (SLAVE → MASTER)                   │
+    ├──────────────────────────────────────────────────────────────────────────────┤
+    │ [ 0x28 | COUNT | ID1 .. IDn | CRC8 ]      CRC8 covers COUNT and the IDs      │
+    │ slave → one data PACKET per ID, in request order, same transaction:          │
+    │         [ 0x01 | OW_CMD_* | LEN | VALUE | CRC8 ]                             │
+    │         scalars: VALUE as in the master → slave packets                      │
+    │         structs: OW_CMD_STRUCT, VALUE = ID | struct bytes                    │
+    │         unknown ID: [ 0x01 | OW_CMD_NACK | 0 | CRC8 ]                        │
+    ├──────────────────────────────────────────────────────────────────────────────┤
+    │  COUNT is 1..OW_MAX_READ_IDS. Bad CRC8 or COUNT → no reply.                  │
+    └──────────────────────────────────────────────────────────────────────────────┘
+*/
+
+/*
+    ┌──────────────────────────────────────────────────────────────────────────────┐
+    │                   OWX SAMPLE FIFO DRAIN (SLAVE → MASTER)                     │
+    ├──────────────────────────────────────────────────────────────────────────────┤
+    │ [ 0x29 | MAX | ACK_SEQ (2) | CRC8 ]        CRC8 covers MAX and ACK_SEQ       │
+    │ slave → [ COUNT | FIRST_SEQ (2) | PENDING | LOST (2) | OVERFLOWS (2) |       │
+    │           NOW (4) | COUNT x RECORD | CRC8 ]                                  │
+    │         RECORD = [ CHANNEL | OW_CMD_* | TIMESTAMP (4) | VALUE (4) ]          │
+    ├──────────────────────────────────────────────────────────────────────────────┤
+    │  ACK_SEQ: sequence number of the first record the master has NOT received   │
+    │  yet (FIRST_SEQ + COUNT of the last good reply, 0 at start). Records before  │
+    │  it are dropped; a lost reply is sent again. PENDING = records left after    │
+    │  this reply (max 255). LOST / OVERFLOWS are running 16-bit counts of pushes  │
+    │  refused by a full FIFO and of times it ran full. NOW and TIMESTAMP are      │
+    │  millis() of the slave. No FIFO installed → no reply.                        │
+    └──────────────────────────────────────────────────────────────────────────────┘
+*/
+
+/*
+    ┌──────────────────────────────────────────────────────────────────────────────┐
+    │                     OWX DATA READY (CONDITIONAL SEARCH 0xEC)                 │
+    ├──────────────────────────────────────────────────────────────────────────────┤
+    │ The slave takes part in the 1-Wire conditional search (ROM command 0xEC)     │
+    │ while one of the OW_ALARM_* sources enabled with setAlarmMask() is active:   │
+    │   SAMPLES    sample FIFO holds records         (off once drained)            │
+    │   HANDLER    split-phase handler DONE / FAILED (off after OW_HANDLER_STATUS) │
+    │   SCRATCHPAD publishScratchpad() changed bytes (off after a 0x20 / 0x22 read)│
+    │   USER       raiseAlarm()                                                    │
+    │ [ 0x2C | CLEAR_MASK ]  slave → [ FLAGS | CRC8 ]                              │
+    │         FLAGS = active sources before the read, then the latched ones in     │
+    │         CLEAR_MASK are cleared (SAMPLES follows the FIFO and can't be)       │
+    ├──────────────────────────────────────────────────────────────────────────────┤
+    │  Master cycle: 0xEC search → only the ROMs found have something to report,   │
+    │  visit those. A search nobody answers ends after the 0xEC byte + 2 slots.    │
+    │  Needs a hub that implements 0xEC and asks OneWireItem::alarmed(); the host  │
+    │  hub in extras/host does, upstream OneWireHub answers 0xEC with an error.    │
+    └──────────────────────────────────────────────────────────────────────────────┘
+*/
+
+/*
+    ┌──────────────────────────────────────────────────────────────────────────────┐
+    │                  OWX CAPABILITIES AND OVERDRIVE (MASTER ↔ SLAVE)             │
+    ├──────────────────────────────────────────────────────────────────────────────┤
+    │ [ 0x2D ]  slave → [ VERSION | FEATURES (2) | MAX_PAYLOAD | SCRATCHPAD_LEN |  │
+    │                     TURNAROUND_US | CRC8 ]                                   │
+    │         FEATURES = OW_CAP_* bits, LSB first; CRC8 covers VERSION..TURNAROUND │
+    ├──────────────────────────────────────────────────────────────────────────────┤
+    │  Overdrive flow: read the capabilities at standard speed; if OW_CAP_OVERDRIVE│
+    │  is set, address the slave with OVERDRIVE MATCH ROM 0x69 (or OVERDRIVE SKIP  │
+    │  ROM 0x3C): ROM and OWX command bytes then run at overdrive speed, and the   │
+    │  slave stays there until a standard-length reset. Nothing else changes.      │
+    │  Slave timing, both speeds:                                                  │
+    │    - master waits TURNAROUND_US after the last byte of a command before the  │
+    │      first read slot of the reply (CRC check, decoding, reply built)         │
+    │    - between any other two bytes the slave needs at most OW_BYTE_GAP_US, so  │
+    │      an overdrive master (tSLOT 8 µs + tREC 2 µs) never has to pause         │
+    │  extras/test/owx_timing_test checks both limits for every command.           │
+    └──────────────────────────────────────────────────────────────────────────────┘
+*/
+
+/*
+    ┌──────────────────────────────────────────────────────────────────────────────┐
+    │                      OWX STATISTICS READ (SLAVE → MASTER)                    │
+    ├──────────────────────────────────────────────────────────────────────────────┤
+    │ [ 0x50 | FLAGS ]  slave → [ LEN | OWXStatsBlock (LEN bytes) | CRC8 ]         │
+    │         FLAGS bit 0 (OW_STATS_FLAG_CLEAR): reset counters after the read     │
+    │         LEN = 0 when built with OW_STATS=0                                   │
+    ├──────────────────────────────────────────────────────────────────────────────┤
+    │  uint16_t LSB first: events[OWXStatEvent], commands[OWXStatCommand],         │
+    │  service_cycles[OW_STATS_HIST_BUCKETS] (duty() time histogram, see OWX_Stats.h)│
+    └──────────────────────────────────────────────────────────────────────────────┘
+*/
+
+
+// Received value storage: one slot shared by every data type
+union OWXValue {
+    int8_t   i8;
+    uint8_t  u8;
+    int16_t  i16;
+    uint16_t u16;
+    int32_t  i32;
+    uint32_t u32;
+    float    f32;
+    uint8_t  raw[4];     // LSB first as received (DATA_STRUCT: raw[0] = struct ID,
+                         // DATA_ARRAY: raw[0] = array ID, raw[1] = START, raw[2] = COUNT)
+};
+
+// One received value as queued by the bus path, tagged with its type
+struct OWXMessage {
+    uint8_t type;        // Emulator::DataType
+    uint8_t command;     // OW_CMD_* it arrived with
+    uint8_t len;         // payload bytes (DATA_STRUCT: struct size, DATA_ARRAY: elements written)
+    OWXValue value;
+    uint32_t timestamp;  // micros() when the frame was accepted
+};
+
+// Bit of a data type command in a type mask
+constexpr uint16_t owx_type_bit(uint8_t cmd) {
+    return (cmd >= OW_CMD_FIRST_TYPE && cmd <= OW_CMD_LAST_TYPE) ? (uint16_t)(1u << (cmd - OW_CMD_FIRST_TYPE)) : 0;
+}
+
+#define OW_TYPES_ALL ((uint16_t)((1u << (OW_CMD_LAST_TYPE - OW_CMD_FIRST_TYPE + 1)) - 1))
+
+// Variable type → scalar OW_CMD_* command, 0 for structs
+template <typename T> struct OWXScalarCommand { static constexpr uint8_t value = 0; };
+template <> struct OWXScalarCommand<int8_t>   { static constexpr uint8_t value = OW_CMD_INT8; };
+template <> struct OWXScalarCommand<uint8_t>  { static constexpr uint8_t value = OW_CMD_UINT8; };
+template <> struct OWXScalarCommand<char>     { static constexpr uint8_t value = OW_CMD_CHAR8; };
+template <> struct OWXScalarCommand<int16_t>  { static constexpr uint8_t value = OW_CMD_INT16; };
+template <> struct OWXScalarCommand<uint16_t> { static constexpr uint8_t value = OW_CMD_UINT16; };
+template <> struct OWXScalarCommand<int32_t>  { static constexpr uint8_t value = OW_CMD_INT32; };
+template <> struct OWXScalarCommand<uint32_t> { static constexpr uint8_t value = OW_CMD_UINT32; };
+template <> struct OWXScalarCommand<float>    { static constexpr uint8_t value = OW_CMD_FLOAT32; };
+
+// Array element type → OW_CMD_ARRAY_* command
+template <typename T> struct OWXArrayCommand;
+template <> struct OWXArrayCommand<int16_t>  { static constexpr uint8_t value = OW_CMD_ARRAY_INT16; };
+template <> struct OWXArrayCommand<uint16_t> { static constexpr uint8_t value = OW_CMD_ARRAY_UINT16; };
+template <> struct OWXArrayCommand<int32_t>  { static constexpr uint8_t value = OW_CMD_ARRAY_INT32; };
+template <> struct OWXArrayCommand<float>    { static constexpr uint8_t value = OW_CMD_ARRAY_FLOAT32; };
+
+constexpr bool owx_is_array_cmd(uint8_t cmd) { return cmd >= OW_CMD_ARRAY_INT16 && cmd <= OW_CMD_ARRAY_FLOAT32; }
+
+#define OW_TYPES_ARRAYS (owx_type_bit(OW_CMD_ARRAY_INT16) | owx_type_bit(OW_CMD_ARRAY_UINT16) | \
+                         owx_type_bit(OW_CMD_ARRAY_INT32) | owx_type_bit(OW_CMD_ARRAY_FLOAT32))
+
+// Type mask of a list of OW_CMD_* data type commands
+template <uint8_t... Cmds> struct OWXTypeMask;
+template <> struct OWXTypeMask<> { static constexpr uint16_t value = 0; };
+template <uint8_t Cmd, uint8_t... Rest> struct OWXTypeMask<Cmd, Rest...> {
+    static_assert(owx_type_bit(Cmd) != 0, "BasicEmulator: enabled types must be OW_CMD_* data type commands");
+    static constexpr uint16_t value = owx_type_bit(Cmd) | OWXTypeMask<Rest...>::value;
+};
+
+// Storage of a feature a configuration leaves out: no RAM, and owx_storage() gives nullptr.
+// A configuration with OW_FEATURE_SHARED_HANDLERS holds an OWXSharedHandlers instead of a table.
+struct OWXNoStorage {};
+struct OWXSharedHandlers {};
+template <typename T> T *owx_storage(T &storage) { return &storage; }
+inline decltype(nullptr) owx_storage(OWXNoStorage &) { return nullptr; }
+inline OWXHandlerTable *owx_storage(OWXSharedHandlers &) { return owx_shared_handlers(); }
+template <uint8_t Structs> OWXReceiver *owx_storage(OWXReceiverTable<Structs> &table) { return table.entries; }
+static_assert(OW_CMD_UINT32 - OW_CMD_UINT8 + 1 == OW_RECEIVE_SCALARS, "OWXReceiverTable: one scalar entry per OW_CMD_UINT8..OW_CMD_UINT32");
 
-class Emulator : public OneWireItem
+
+// Protocol logic shared by every FeatureEmulator configuration
+class EmulatorBase : public OneWireItem
 {
 public:
     enum DataType : uint8_t {
@@ -124,37 +507,272 @@ public:
         DATA_INT32,
         DATA_UINT32,
         DATA_FLOAT32,
-        DATA_STRUCT
+        DATA_STRUCT,
+        DATA_ARRAY
     };
+protected:
+    struct StructSlot;
+    struct ArraySlot;
+    struct VariableTable;
+    struct AlarmState;
+    struct AlarmMark;
+    struct SeqCache;
+    struct BulkState;
+
 private:
-    uint8_t scratchpadLen;
-    uint8_t scratchpad[9];
-    uint8_t rawBufferLen;
+    OWXScratchpadBase *scratchpad;   // double-buffered, see OWX_Scratchpad.h
+    bool handlerRunning;             // writeScratchpad_*() inside a handler wait for its return
     uint8_t lastCommand;
 
-    int8_t int8_value;
-    uint8_t uint8_value;
-    int16_t int16_value;
-    uint16_t uint16_value;
-    int32_t int32_value;
-    uint32_t uint32_value;
-    float float_value;
+    // registered OW_CMD_STRUCT destinations, storage owned by the configuration
+    StructSlot *structSlots;
+    uint8_t structCapacity;
+    uint8_t structCount;
+    bool register_struct(uint8_t id, void *dest, uint8_t size);
+    const StructSlot *find_struct(uint8_t id) const;
+    StructSlot *find_struct(uint8_t id);
+    void release_struct(uint8_t id);
+    bool struct_pending(const StructSlot *slot) const { return slot->notified != slot->taken; }
 
-    // нові поля
-    volatile bool dataAvailable;
-    volatile DataType lastDataType;
+    // onReceive() callbacks, see OWXReceiverTable; nullptr without OW_FEATURE_CALLBACKS
+    OWXReceiver *receivers;
+    const OWXReceiver *scalar_receiver(uint8_t cmd) const { return receivers ? &receivers[cmd - OW_CMD_UINT8] : nullptr; }
+    OWXReceiver *struct_receiver(const StructSlot *slot) const {
+        return receivers ? &receivers[OW_RECEIVE_SCALARS + (slot - structSlots)] : nullptr;
+    }
+    static bool inlined(const OWXReceiver *receiver) { return receiver && receiver->inlined(); }
+    bool on_receive(uint8_t cmd, uint8_t id, const OWXReceiver &receiver, uint8_t size);
+    bool receives_inline(uint8_t cmd, const uint8_t *payload) const;
 
-    std::function<bool(uint8_t)> customHandler; // callback для кастомних команд
-    void read_variable_payload(OneWireHub *hub);
-    void parse_handler_command(OneWireHub *hub);
-    
+    // registered OW_CMD_ARRAY_* destinations, storage owned by the configuration
+    ArraySlot *arraySlots;
+    uint8_t arrayCapacity;
+    uint8_t arrayCount;
+    bool register_array(uint8_t id, uint8_t cmd, void *dest, uint16_t capacity);
 
-public:
-    Emulator(uint8_t ID1, uint8_t ID2, uint8_t ID3, uint8_t ID4,
-             uint8_t ID5, uint8_t ID6, uint8_t ID7);
+    // live variables readable with OW_LOW_CMD_READ_VARIABLES
+    VariableTable *variables;
+    bool bind_variable(uint8_t id, uint8_t cmd, const volatile void *src, uint8_t size);
+    void send_variables(OneWireHub *hub);
+
+    // timestamped samples pushed by loop(), drained by the master
+    OWXSampleFifoBase *sampleFifo;
+    void send_samples(OneWireHub *hub);
+
+    // data ready flag for the conditional search
+    AlarmState *alarm;
+    void raise_alarm(uint8_t source);
+    AlarmMark mark_alarm() const;
+    void clear_alarm(uint8_t sources, const AlarmMark &seen);
+    void send_alarm(OneWireHub *hub);
+
+    bool overdriveCapable;
+    void send_capabilities(OneWireHub *hub, uint8_t max_payload);
+
+    // received values: filled by duty(), drained by loop()
+    OWXSpscQueue<OWXMessage, OW_RX_QUEUE_SIZE> rxQueue;
+    uint8_t rxDropPolicy;
+    volatile uint32_t rxOverflows;
+    bool refuse_value(OneWireHub *hub, uint8_t cmd, uint8_t len);
+    void pop_value();
+
+    BulkState *bulk;
+
+    OWXStats *stats;
+    void stat(OWXStatEvent event) { if (stats) stats->count(event); }
+    void stat(OWXStatCommand cmd) { if (stats) stats->command(cmd); }
+    OWXTrace trace;   // OWX_TRACE() points on the bus path, see OWX_Trace.h
+
+    // transaction state shared by every instance, see OWX_Engine.h
+    static OWXEngine engine;
+    OWXHandlerTable *handlers; // обробники користувацьких команд (per command + catch-all)
+    const OWXHandler *find_handler(uint8_t cmd) const { return handlers ? handlers->find(cmd) : nullptr; }
+    void dispatch_command(OneWireHub *hub, uint8_t *payload_buf, uint8_t max_payload);
+    void execute_command(OneWireHub *hub, uint8_t low_cmd, uint8_t *payload_buf, uint8_t max_payload);
+    void read_variable_payload(OneWireHub *hub, uint8_t *payload_buf, uint8_t max_payload);
+    void parse_handler_command(OneWireHub *hub, uint8_t low_cmd);
+    void send_reply(OneWireHub *hub, uint8_t reply);
+    void send_nack(OneWireHub *hub, uint8_t reason);
+    bool reject(OneWireHub *hub, uint8_t cmd, uint8_t reason);
+
+    // sequenced transactions (OW_LOW_CMD_SEQUENCED): last executed one and its reply
+    SeqCache *seq;
+    bool replay_duplicate(OneWireHub *hub, uint8_t low_cmd, uint8_t fingerprint);
+    void remember_reply(uint8_t low_cmd, uint8_t fingerprint, uint8_t reply, uint8_t reason);
+    void send_cached_reply(OneWireHub *hub, uint8_t seq);
+    void send_stats(OneWireHub *hub);
+    void send_scratchpad(OneWireHub *hub);
+    void send_scratchpad_range(OneWireHub *hub);
+    void send_scratchpad_changes(OneWireHub *hub);
+
+    // split-phase handler command: written by duty() (PENDING) and processPending()
+    std::atomic<uint8_t> asyncState;
+    uint8_t asyncCommand;
+    uint8_t asyncResult;
+    void parse_async_handler_command(OneWireHub *hub, uint8_t low_cmd);
+    void send_handler_status(OneWireHub *hub);
+
+    void bulk_session(OneWireHub *hub, uint8_t low_cmd);
+    bool bulk_begin(OneWireHub *hub);
+    bool bulk_chunk(OneWireHub *hub);
+    bool bulk_status(OneWireHub *hub);
+    void bulk_end(OneWireHub *hub);
+    void bulk_fold(uint8_t max_bytes);
+    uint16_t bulk_chunk_count() const;
+
+protected:
+    // Optional subsystem state, owned by the configuration; nullptr when it leaves the feature out
+    struct FeatureStorage {
+        OWXHandlerTable *handlers;
+        SeqCache *seq;
+        VariableTable *variables;
+        AlarmState *alarm;
+        BulkState *bulk;
+        OWXStats *stats;
+        OWXReceiver *receivers;
+    };
+
+    struct VariableTable {
+        struct Slot {
+            uint8_t id;
+            uint8_t cmd;         // scalar OW_CMD_* or OW_CMD_STRUCT
+            uint8_t size;
+            const volatile void *src;
+        };
+        Slot slots[OW_MAX_VARIABLES];
+        uint8_t count;
+
+        VariableTable() : count(0) {}
+    };
+
+    // Latched sources (HANDLER, SCRATCHPAD, USER) are raised by loop() and cleared by duty()
+    // without sharing a byte: a source is active while its raise count differs from the count
+    // the master last cleared. The count stops 255 raises ahead instead of wrapping back to
+    // "cleared".
+    struct AlarmState {
+        uint8_t mask;
+        volatile uint8_t raised[3];
+        volatile uint8_t cleared[3];
+
+        AlarmState() : mask(OW_ALARM_ALL) {
+            for (uint8_t i = 0; i < 3; i++) {
+                raised[i] = 0;
+                cleared[i] = 0;
+            }
+        }
+    };
+
+    // Raise counts taken before a reply is built; clearing to them keeps raises made while
+    // the reply was on the wire
+    struct AlarmMark {
+        uint8_t raised[3];
+    };
+
+    struct SeqCache {
+        bool valid;
+        uint8_t last;
+        uint8_t lastCmd;   // low-level command and fingerprint (frame CRC8 / handler command)
+        uint8_t lastFp;
+        uint8_t reply[2];
+        uint8_t replyLen;
+
+        SeqCache() : valid(false), last(0), lastCmd(0), lastFp(0), replyLen(0) {}
+    };
+
+    struct BulkState {
+        uint8_t *buf;
+        uint16_t capacity;
+        uint16_t total;
+        uint16_t expectedCrc;
+        uint16_t crcLen;                      // bytes of the in-order prefix already folded into crc
+        OWXCrc16 crc;
+        uint8_t map[OW_BULK_MAX_CHUNKS / 8];  // received chunks
+        volatile bool active;
+        volatile bool complete;
+
+        BulkState() : buf(nullptr), capacity(0), total(0), expectedCrc(0), crcLen(0), active(false), complete(false) {
+            memset(map, 0, sizeof(map));
+        }
+    };
+
+    struct StructSlot {
+        uint8_t id;
+        uint8_t size;
+        void *dest;
+        // DATA_STRUCT notifications committed by duty() and consumed by loop(): while they
+        // differ dest holds a value the application hasn't taken yet and a new frame is refused
+        uint8_t notified;
+        volatile uint8_t taken;
+    };
+
+    struct ArraySlot {
+        uint8_t id;
+        uint8_t cmd;         // OW_CMD_ARRAY_* of the element type
+        uint16_t capacity;   // elements
+        void *dest;
+    };
 
-    void duty(OneWireHub *hub);
-    void writeScratchpad_byte(uint8_t* data, uint8_t len, uint8_t addr = 0);
+    EmulatorBase(uint8_t ID1, uint8_t ID2, uint8_t ID3, uint8_t ID4,
+                 uint8_t ID5, uint8_t ID6, uint8_t ID7,
+                 OWXScratchpadBase &pad, StructSlot *struct_slots, uint8_t struct_capacity,
+                 ArraySlot *array_slots, uint8_t array_capacity, const FeatureStorage &features);
+
+    // Low-level command dispatch; the receive buffer comes from the configuration's duty()
+    void dispatch(OneWireHub *hub, uint8_t *payload_buf, uint8_t max_payload);
+
+    // Optional low-level commands: the configuration routes the ones of its features to the
+    // serve_*() below and returns false for the rest (ignored like unknown commands)
+    virtual bool route_command(OneWireHub *hub, uint8_t low_cmd, uint8_t *payload_buf, uint8_t max_payload) = 0;
+    bool serve_sequenced(OneWireHub *hub, uint8_t *payload_buf, uint8_t max_payload);
+    bool serve_replay(OneWireHub *hub);
+    bool serve_partial_read(OneWireHub *hub, uint8_t low_cmd);
+    bool serve_variables(OneWireHub *hub);
+    bool serve_samples(OneWireHub *hub);
+    bool serve_handler(OneWireHub *hub, uint8_t low_cmd);
+    bool serve_async(OneWireHub *hub, uint8_t low_cmd);
+    bool serve_bulk(OneWireHub *hub, uint8_t low_cmd);
+    bool serve_alarm(OneWireHub *hub);
+    bool serve_stats(OneWireHub *hub);
+
+    // Decoders the configuration picks from in process_specific_payload_Command()
+    bool decode_scalar(uint8_t cmd_data_type, const uint8_t *payload, uint8_t len, OneWireHub *hub);
+    bool decode_struct(const uint8_t *payload, uint8_t len, OneWireHub *hub);
+    bool decode_batch(const uint8_t *payload, uint8_t len, OneWireHub *hub, uint16_t type_mask);
+    bool decode_array(uint8_t cmd_data_type, const uint8_t *payload, uint8_t len, OneWireHub *hub);
+
+    // Registers dest as the target of OW_CMD_STRUCT frames carrying struct ID id.
+    // A verified frame is copied straight into dest and queued as DATA_STRUCT. Until that
+    // notification is consumed (clearAvailable(), receive(), dispatchPending()) dest belongs to
+    // the application: the next frame for the ID is refused like a full queue.
+    template <typename T>
+    bool registerStruct(uint8_t id, T *dest) {
+        static_assert(std::is_trivially_copyable<T>::value, "registerStruct: struct must be trivially copyable");
+        return register_struct(id, dest, sizeof(T));
+    }
+
+    // Registers dest[capacity] (int16_t, uint16_t, int32_t or float) as the target of the matching
+    // OW_CMD_ARRAY_* frames carrying array ID id. Elements are decoded straight into dest and
+    // every frame is queued as DATA_ARRAY (ID, START, COUNT).
+    template <typename T>
+    bool registerArray(uint8_t id, T *dest, uint16_t capacity) {
+        return register_array(id, OWXArrayCommand<T>::value, dest, capacity > 256 ? 256 : capacity);
+    }
+
+public:
+    // writeScratchpad_*() are visible to OW_READ_SCRATCHPAD as soon as they return; inside a
+    // handler they are published together when the handler returns true and dropped (with
+    // anything else staged) when it returns false. To update several fields
+    // atomically from loop(), stageScratchpad() them and publishScratchpad() once.
+    void useScratchpad(OWXScratchpadBase &pad);
+    bool stageScratchpad(const uint8_t* data, uint8_t len, uint8_t addr = 0);
+    template <typename T>
+    bool stageScratchpad(const T &value, uint8_t addr = 0) {
+        static_assert(std::is_trivially_copyable<T>::value, "stageScratchpad: value must be trivially copyable");
+        return stageScratchpad(reinterpret_cast<const uint8_t *>(&value), sizeof(T), addr);
+    }
+    void publishScratchpad();
+    uint8_t scratchpadGeneration() const;   // bumped by every publish that changed a byte
+    void writeScratchpad_byte(const uint8_t* data, uint8_t len, uint8_t addr = 0);
     void wite_int16_to_scratchpad(int16_t value, uint8_t addr = 0);
     void writeScratchpad_int8(int8_t value, uint8_t addr = 0);
     void writeScratchpad_uint8(uint8_t value, uint8_t addr = 0);
@@ -166,15 +784,109 @@ public:
 
     // --- нові функції ---
     uint8_t getLastCommand() const;
-    void setCustomHandler(std::function<bool(uint8_t)> handler);
 
-    // availability API
+    // Binds a live variable (scalar or trivially copyable struct) to ID id; the master reads it
+    // with OW_LOW_CMD_READ_VARIABLES and gets a typed, CRC8-checked packet in the same transaction.
+    // The value is copied while the bus transaction runs: service the hub from loop() or guard
+    // multi-byte updates if hub.poll() runs from an interrupt.
+    template <typename T>
+    bool bindVariable(uint8_t id, const T *src) {
+        static_assert(std::is_trivially_copyable<T>::value, "bindVariable: type must be trivially copyable");
+        static_assert(OWXScalarCommand<T>::value != 0 || sizeof(T) + 1 <= OW_MAX_PAYLOAD,
+                      "bindVariable: struct + ID byte must fit in OW_MAX_PAYLOAD");
+        return bind_variable(id, OWXScalarCommand<T>::value ? OWXScalarCommand<T>::value : (uint8_t)OW_CMD_STRUCT,
+                             src, sizeof(T));
+    }
+    bool unbindVariable(uint8_t id);
+
+    // Installs the FIFO that pushSample() fills and OW_LOW_CMD_DRAIN_SAMPLES empties
+    void useSampleFifo(OWXSampleFifoBase &fifo);
+
+    // Queues one reading with its timestamp (millis() by default); false if the FIFO is full
+    // (counted as lost) or none is installed. Call from loop().
+    template <typename T>
+    bool pushSample(uint8_t channel, T value, uint32_t timestamp = millis()) {
+        static_assert(OWXScalarCommand<T>::value != 0 && sizeof(T) <= 4, "pushSample: value must be a scalar OW_CMD_* type");
+        return sampleFifo && sampleFifo->push(channel, OWXScalarCommand<T>::value, &value, sizeof(T), timestamp);
+    }
+    uint8_t samplesPending() const;
+
+    // handler commands: catch-all handler plus optional per-command handlers
+    // (one table for every instance with OW_FEATURE_SHARED_HANDLERS)
+    void setCustomHandler(OWXPlainHandlerFn handler);
+    void setCustomHandler(OWXHandlerFn handler, void *context);
+    bool addHandler(uint8_t cmd, OWXPlainHandlerFn handler);
+    bool addHandler(uint8_t cmd, OWXHandlerFn handler, void *context);
+    bool removeHandler(uint8_t cmd);
+
+    // split-phase handler commands: call from loop(); runs the accepted command, if any
+    bool processPending();
+    void setHandlerResult(uint8_t result);   // from inside a handler, reported by OW_HANDLER_STATUS
+    uint8_t handlerState() const;
+
+    // Emulator a handler runs for (duty() or processPending()), nullptr outside of them
+    static EmulatorBase *serving();
+
+    // availability API (oldest queued value)
     bool available() const;
     DataType availableType() const;
     void clearAvailable();
 
-    bool process_specific_payload_Command(uint8_t cmd_data_type, const uint8_t *payload, uint8_t len, OneWireHub *hub);
-    void send_packet(uint8_t cmd, uint8_t *data, uint8_t len, OneWireHub *hub);
+    // receive queue API. A DATA_STRUCT message only names the struct: once receive() returned,
+    // the next frame for it may overwrite the destination; read it in place with available()
+    // and clearAvailable() instead
+    bool receive(OWXMessage &msg);
+    uint8_t pending() const;
+
+    // Typed receive callbacks (see OWX_Receive.h): fn gets every received value of type T, the
+    // OW_CMD_* command follows from T at compile time; nullptr unsubscribes.
+    template <typename T>
+    bool onReceive(void (*fn)(T value), uint8_t mode = OW_RECEIVE_DEFERRED) {
+        static_assert(OWXScalarCommand<T>::value >= OW_CMD_UINT8 && OWXScalarCommand<T>::value <= OW_CMD_UINT32,
+                      "onReceive: value must be a scalar OW_CMD_* type (int8..uint32, float)");
+        return on_receive(OWXScalarCommand<T>::value, 0, OWXReceiver::forValue(fn, mode), sizeof(T));
+    }
+    // fn gets the struct registered under id after every frame for it; false if id is not
+    // registered with a struct of this size
+    template <typename T>
+    bool onReceive(uint8_t id, void (*fn)(const T &value), uint8_t mode = OW_RECEIVE_DEFERRED) {
+        static_assert(std::is_trivially_copyable<T>::value, "onReceive: struct must be trivially copyable");
+        return on_receive(OW_CMD_STRUCT, id, OWXReceiver::forStruct(fn, mode), sizeof(T));
+    }
+    // Call from loop(): runs the callbacks of queued values, oldest first, and stops at the first
+    // value nobody subscribed to (left for available() / receive()). Returns the values delivered.
+    uint8_t dispatchPending(uint8_t max_values = 0xFF);
+    void setDropPolicy(uint8_t policy);
+    uint32_t overflowCount() const;
+    void resetOverflowCount();
+
+    // data ready signalling for the conditional search 0xEC
+    void setAlarmMask(uint8_t mask);   // OW_ALARM_* sources that count, OW_ALARM_ALL by default
+    void raiseAlarm();                 // OW_ALARM_USER, call from loop()
+    uint8_t alarmFlags() const;        // active sources, masked
+    bool alarmed() const;              // asked by a hub with conditional search support
+
+    // Advertises overdrive in OW_LOW_CMD_CAPABILITIES; only if the hub is built to accept
+    // overdrive ROM commands (OneWireHub: OVERDRIVE_ENABLE) and the MCU keeps up with it
+    void setOverdrive(bool enabled);
+
+    // protocol statistics (also readable by the master with OW_LOW_CMD_READ_STATS)
+    const OWXStatsBlock &getStats() const;
+    void resetStats();
+
+    // binary trace (OW_TRACE=1): call from loop(), e.g. drainTrace(Serial), never from the bus path
+    template <class Out> uint8_t drainTrace(Out &out, uint8_t max_events = 0xFF) { return trace.drain(out, max_events); }
+    uint8_t tracePending() const;
+
+    // bulk (fragmented) transfer API
+    void setBulkBuffer(uint8_t *buffer, uint16_t capacity);
+    bool bulkAvailable() const;
+    uint16_t bulkLength() const;
+    void clearBulk();
+
+    // Decodes one verified payload; returns true if it should be ACKed
+    virtual bool process_specific_payload_Command(uint8_t cmd_data_type, const uint8_t *payload, uint8_t len, OneWireHub *hub) = 0;
+    void send_packet(uint8_t cmd, const uint8_t *data, uint8_t len, OneWireHub *hub);
 
 
     int8_t getInt8() const;
@@ -184,9 +896,197 @@ public:
     int32_t getInt32() const;
     uint32_t getUInt32() const;
     float getFloat() const;
+    uint8_t getStructId() const;
+    uint8_t getArrayId() const;
+};
+
 
-  
+/*
+    Compile-time configured emulator.
+
+        Features        OW_FEATURE_* bits of the optional subsystems, see above
+        ScratchpadSize  bytes of the built-in scratchpad
+        MaxPayload      largest OW_LOW_CMD_SEND_VARIABLE_ payload accepted (receive buffer on the stack)
+        EnabledTypes    OW_CMD_* data type commands to decode; empty = all of them.
+                        Decoders of types left out are not referenced and drop out at link time,
+                        frames carrying them get NACK OW_NACK_UNKNOWN_TYPE.
+
+    FeatureEmulator<0, 4, 4, OW_CMD_INT16, OW_CMD_FLOAT32> thermostat(0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07);
+
+    BasicEmulator<ScratchpadSize, MaxPayload, EnabledTypes...> is the same with every feature.
+    Calling the API of a feature left out fails to compile.
+*/
+template <uint16_t Features, uint8_t ScratchpadSize = OW_SCRATCHPAD_SIZE, uint8_t MaxPayload = OW_MAX_PAYLOAD, uint8_t... EnabledTypes>
+class FeatureEmulator : public EmulatorBase
+{
+    static_assert(MaxPayload >= 1 && MaxPayload <= OW_MAX_PAYLOAD, "FeatureEmulator: MaxPayload must be 1..OW_MAX_PAYLOAD");
+    static_assert((Features & ~(OW_FEATURES_ALL | OW_FEATURE_SHARED_HANDLERS)) == 0, "FeatureEmulator: Features must be OW_FEATURE_* bits");
+    static_assert(!(Features & OW_FEATURE_SHARED_HANDLERS) || (Features & OW_FEATURE_HANDLERS),
+                  "FeatureEmulator: OW_FEATURE_SHARED_HANDLERS needs OW_FEATURE_HANDLERS");
+    static_assert(!(Features & OW_FEATURE_ASYNC) || (Features & OW_FEATURE_HANDLERS),
+                  "FeatureEmulator: OW_FEATURE_ASYNC needs OW_FEATURE_HANDLERS");
+
+public:
+    static constexpr uint16_t typeMask = sizeof...(EnabledTypes) ? OWXTypeMask<EnabledTypes...>::value : OW_TYPES_ALL;
+
+    static constexpr bool enabled(uint8_t cmd) { return (typeMask & owx_type_bit(cmd)) != 0; }
+    static constexpr bool has(uint16_t feature) { return (Features & feature) != 0; }
+
+private:
+    static constexpr uint8_t structCapacity = enabled(OW_CMD_STRUCT) ? OW_MAX_STRUCTS : 0;
+    static constexpr uint8_t arrayCapacity = (typeMask & OW_TYPES_ARRAYS) ? OW_MAX_ARRAYS : 0;
+
+    template <uint16_t Feature, typename T>
+    using Optional = typename std::conditional<(Features & Feature) != 0, T, OWXNoStorage>::type;
+
+    OWXScratchpad<ScratchpadSize> builtinScratchpad;
+    StructSlot structStorage[structCapacity ? structCapacity : 1];
+    ArraySlot arrayStorage[arrayCapacity ? arrayCapacity : 1];
+    typename std::conditional<(Features & OW_FEATURE_SHARED_HANDLERS) != 0, OWXSharedHandlers,
+                              Optional<OW_FEATURE_HANDLERS, OWXHandlerTable>>::type handlerStorage;
+    Optional<OW_FEATURE_SEQUENCED, SeqCache> seqStorage;
+    Optional<OW_FEATURE_VARIABLES, VariableTable> variableStorage;
+    Optional<OW_FEATURE_ALARM, AlarmState> alarmStorage;
+    Optional<OW_FEATURE_BULK, BulkState> bulkStorage;
+    Optional<OW_FEATURE_STATS, OWXStats> statsStorage;
+    Optional<OW_FEATURE_CALLBACKS, OWXReceiverTable<structCapacity>> receiverStorage;
+
+public:
+    FeatureEmulator(uint8_t ID1, uint8_t ID2, uint8_t ID3, uint8_t ID4,
+                    uint8_t ID5, uint8_t ID6, uint8_t ID7)
+        : EmulatorBase(ID1, ID2, ID3, ID4, ID5, ID6, ID7, builtinScratchpad, structStorage, structCapacity,
+                       arrayStorage, arrayCapacity,
+                       FeatureStorage{ owx_storage(handlerStorage), owx_storage(seqStorage), owx_storage(variableStorage),
+                                       owx_storage(alarmStorage), owx_storage(bulkStorage), owx_storage(statsStorage),
+                                       owx_storage(receiverStorage) }) {}
+
+    void duty(OneWireHub *hub) override {
+        uint8_t payload_buf[MaxPayload];
+        dispatch(hub, payload_buf, MaxPayload);
+    }
+
+    template <typename T>
+    bool registerStruct(uint8_t id, T *dest) {
+        static_assert(enabled(OW_CMD_STRUCT), "registerStruct: OW_CMD_STRUCT is not enabled in this configuration");
+        static_assert(sizeof(T) + 1 <= MaxPayload, "registerStruct: struct + ID byte must fit in MaxPayload");
+        return EmulatorBase::registerStruct(id, dest);
+    }
+
+    template <typename T>
+    bool registerArray(uint8_t id, T *dest, uint16_t capacity) {
+        static_assert(enabled(OWXArrayCommand<T>::value), "registerArray: this OW_CMD_ARRAY_* type is not enabled in this configuration");
+        return EmulatorBase::registerArray(id, dest, capacity);
+    }
+
+    template <typename T>
+    bool onReceive(void (*fn)(T value), uint8_t mode = OW_RECEIVE_DEFERRED) {
+        static_assert(has(OW_FEATURE_CALLBACKS), "onReceive: OW_FEATURE_CALLBACKS is not enabled in this configuration");
+        static_assert(enabled(OWXScalarCommand<T>::value), "onReceive: this OW_CMD_* type is not enabled in this configuration");
+        return EmulatorBase::onReceive(fn, mode);
+    }
+
+    template <typename T>
+    bool onReceive(uint8_t id, void (*fn)(const T &value), uint8_t mode = OW_RECEIVE_DEFERRED) {
+        static_assert(has(OW_FEATURE_CALLBACKS), "onReceive: OW_FEATURE_CALLBACKS is not enabled in this configuration");
+        static_assert(enabled(OW_CMD_STRUCT), "onReceive: OW_CMD_STRUCT is not enabled in this configuration");
+        return EmulatorBase::onReceive(id, fn, mode);
+    }
+
+    uint8_t dispatchPending(uint8_t max_values = 0xFF) {
+        static_assert(has(OW_FEATURE_CALLBACKS), "dispatchPending: OW_FEATURE_CALLBACKS is not enabled in this configuration");
+        return EmulatorBase::dispatchPending(max_values);
+    }
+
+    // --- API of optional features ---
+    void setCustomHandler(OWXPlainHandlerFn handler) {
+        static_assert(has(OW_FEATURE_HANDLERS), "setCustomHandler: OW_FEATURE_HANDLERS is not enabled in this configuration");
+        EmulatorBase::setCustomHandler(handler);
+    }
+    void setCustomHandler(OWXHandlerFn handler, void *context) {
+        static_assert(has(OW_FEATURE_HANDLERS), "setCustomHandler: OW_FEATURE_HANDLERS is not enabled in this configuration");
+        EmulatorBase::setCustomHandler(handler, context);
+    }
+    bool addHandler(uint8_t cmd, OWXPlainHandlerFn handler) {
+        static_assert(has(OW_FEATURE_HANDLERS), "addHandler: OW_FEATURE_HANDLERS is not enabled in this configuration");
+        return EmulatorBase::addHandler(cmd, handler);
+    }
+    bool addHandler(uint8_t cmd, OWXHandlerFn handler, void *context) {
+        static_assert(has(OW_FEATURE_HANDLERS), "addHandler: OW_FEATURE_HANDLERS is not enabled in this configuration");
+        return EmulatorBase::addHandler(cmd, handler, context);
+    }
+    bool processPending() {
+        static_assert(has(OW_FEATURE_ASYNC), "processPending: OW_FEATURE_ASYNC is not enabled in this configuration");
+        return EmulatorBase::processPending();
+    }
+
+    template <typename T>
+    bool bindVariable(uint8_t id, const T *src) {
+        static_assert(has(OW_FEATURE_VARIABLES), "bindVariable: OW_FEATURE_VARIABLES is not enabled in this configuration");
+        return EmulatorBase::bindVariable(id, src);
+    }
+
+    void useSampleFifo(OWXSampleFifoBase &fifo) {
+        static_assert(has(OW_FEATURE_SAMPLES), "useSampleFifo: OW_FEATURE_SAMPLES is not enabled in this configuration");
+        EmulatorBase::useSampleFifo(fifo);
+    }
+
+    void setAlarmMask(uint8_t mask) {
+        static_assert(has(OW_FEATURE_ALARM), "setAlarmMask: OW_FEATURE_ALARM is not enabled in this configuration");
+        EmulatorBase::setAlarmMask(mask);
+    }
+    void raiseAlarm() {
+        static_assert(has(OW_FEATURE_ALARM), "raiseAlarm: OW_FEATURE_ALARM is not enabled in this configuration");
+        EmulatorBase::raiseAlarm();
+    }
+
+    void setBulkBuffer(uint8_t *buffer, uint16_t capacity) {
+        static_assert(has(OW_FEATURE_BULK), "setBulkBuffer: OW_FEATURE_BULK is not enabled in this configuration");
+        EmulatorBase::setBulkBuffer(buffer, capacity);
+    }
+
+    bool process_specific_payload_Command(uint8_t cmd_data_type, const uint8_t *payload, uint8_t len, OneWireHub *hub) override {
+        if (!enabled(cmd_data_type)) return false;
+
+        // Constant conditions: disabled decoders are never referenced
+        if (cmd_data_type == OW_CMD_STRUCT) return enabled(OW_CMD_STRUCT) && decode_struct(payload, len, hub);
+        if (cmd_data_type == OW_CMD_BATCH) return enabled(OW_CMD_BATCH) && decode_batch(payload, len, hub, typeMask);
+        if (owx_is_array_cmd(cmd_data_type)) return (typeMask & OW_TYPES_ARRAYS) && decode_array(cmd_data_type, payload, len, hub);
+        return decode_scalar(cmd_data_type, payload, len, hub);
+    }
+
+protected:
+    // Constant conditions again: the commands of features left out are never referenced
+    bool route_command(OneWireHub *hub, uint8_t low_cmd, uint8_t *payload_buf, uint8_t max_payload) override {
+        switch (low_cmd) {
+            case OW_LOW_CMD_SEQUENCED:       return has(OW_FEATURE_SEQUENCED) && serve_sequenced(hub, payload_buf, max_payload);
+            case OW_LOW_CMD_REPLAY:          return has(OW_FEATURE_SEQUENCED) && serve_replay(hub);
+            case OW_READ_SCRATCHPAD_RANGE:
+            case OW_READ_SCRATCHPAD_CHANGED: return has(OW_FEATURE_PARTIAL_READ) && serve_partial_read(hub, low_cmd);
+            case OW_LOW_CMD_READ_VARIABLES:  return has(OW_FEATURE_VARIABLES) && serve_variables(hub);
+            case OW_LOW_CMD_DRAIN_SAMPLES:   return has(OW_FEATURE_SAMPLES) && serve_samples(hub);
+            case OW_HANDLER_COMMAND:         return has(OW_FEATURE_HANDLERS) && serve_handler(hub, low_cmd);
+            case OW_HANDLER_COMMAND_ASYNC:
+            case OW_HANDLER_STATUS:          return has(OW_FEATURE_ASYNC) && serve_async(hub, low_cmd);
+            case OW_LOW_CMD_BULK_BEGIN:
+            case OW_LOW_CMD_BULK_CHUNK:
+            case OW_LOW_CMD_BULK_STATUS:
+            case OW_LOW_CMD_BULK_END:        return has(OW_FEATURE_BULK) && serve_bulk(hub, low_cmd);
+            case OW_LOW_CMD_ALARM:           return has(OW_FEATURE_ALARM) && serve_alarm(hub);
+            case OW_LOW_CMD_READ_STATS:      return has(OW_FEATURE_STATS) && serve_stats(hub);
+            default:                         return false;
+        }
+    }
 };
 
+template <uint16_t Features, uint8_t ScratchpadSize, uint8_t MaxPayload, uint8_t... EnabledTypes>
+constexpr uint16_t FeatureEmulator<Features, ScratchpadSize, MaxPayload, EnabledTypes...>::typeMask;
+
+// Every optional feature: BasicEmulator<4, 4, OW_CMD_INT16, OW_CMD_FLOAT32> thermostat(...);
+template <uint8_t ScratchpadSize = OW_SCRATCHPAD_SIZE, uint8_t MaxPayload = OW_MAX_PAYLOAD, uint8_t... EnabledTypes>
+using BasicEmulator = FeatureEmulator<OW_FEATURES_ALL, ScratchpadSize, MaxPayload, EnabledTypes...>;
+
+// Full-featured emulator: 9 byte scratchpad, 32 byte payloads, every data type
+typedef BasicEmulator<> Emulator;
+
 
-//
+//
\ No newline at end of file
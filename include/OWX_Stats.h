@@ -0,0 +1,123 @@
+/*
+    OWX protocol statistics
+
+    Counters kept by the bus path and readable by the master with OW_LOW_CMD_READ_STATS, so
+    bus quality and latency problems show up without a serial console:
+
+        - error / event counters (CRC mismatches, oversize payloads, recv timeouts, ...)
+        - one counter per low-level command
+        - histogram of duty() service time in CPU cycles, power-of-two buckets
+
+    All counters are uint16_t and wrap. The block is sent as it sits in RAM, LSB first
+    (every supported target is little-endian). Build with -D OW_STATS=0 to remove it.
+*/
+#pragma once
+#include <stdint.h>
+#include <string.h>
+
+#if defined(ARDUINO)
+#include <Arduino.h>
+#endif
+
+#ifndef OW_STATS
+#define OW_STATS 1
+#endif
+
+// Cycle counter used for the service time histogram. Cores that don't define F_CPU fall back to
+// microseconds (the buckets then read as µs); define OWX_CYCLE_COUNT() to supply a real counter.
+#ifndef OWX_CYCLE_COUNT
+#if defined(ESP8266) || defined(ESP32)
+#define OWX_CYCLE_COUNT() ESP.getCycleCount()
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define OWX_CYCLE_COUNT() ((uint32_t)__rdtsc())
+#elif defined(F_CPU)
+#define OWX_CYCLE_COUNT() ((uint32_t)(micros() * (F_CPU / 1000000UL)))
+#else
+#define OWX_CYCLE_COUNT() ((uint32_t)micros())
+#endif
+#endif
+
+#ifndef OW_STATS_HIST_BUCKETS
+#define OW_STATS_HIST_BUCKETS 8
+#endif
+#ifndef OW_STATS_HIST_SHIFT
+#define OW_STATS_HIST_SHIFT 10   // bucket 0: < 1024 cycles, bucket i: < 1024 << i, last: everything above
+#endif
+
+// Event counters
+enum OWXStatEvent : uint8_t {
+    OWX_STAT_FRAMES_OK = 0,     // payload frames accepted
+    OWX_STAT_CRC_ERRORS,        // CRC8 / CRC16 mismatches
+    OWX_STAT_OVERSIZE,          // payload length 0 or longer than the configuration accepts
+    OWX_STAT_TIMEOUTS,          // recv failed mid-transaction (reset / timeslot timeout)
+    OWX_STAT_UNHANDLED,         // unknown command, data type or handler command nobody handled
+    OWX_STAT_ACKS,              // ACK / ACCEPTED replies sent
+    OWX_STAT_NACKS,             // NACK / BUSY replies sent
+    OWX_STAT_QUEUE_OVERFLOWS,   // values refused or dropped because the receive queue was full
+    OWX_STAT_REPLAYS,           // cached replies sent for a repeated sequenced command or REPLAY
+    OWX_STAT_EVENT_COUNT
+};
+
+// Per low-level command counters
+enum OWXStatCommand : uint8_t {
+    OWX_STAT_CMD_SEND_VARIABLE = 0,
+    OWX_STAT_CMD_READ_SCRATCHPAD,
+    OWX_STAT_CMD_READ_SCRATCHPAD_RANGE,
+    OWX_STAT_CMD_READ_SCRATCHPAD_CHANGED,
+    OWX_STAT_CMD_READ_VARIABLES,
+    OWX_STAT_CMD_DRAIN_SAMPLES,
+    OWX_STAT_CMD_HANDLER,
+    OWX_STAT_CMD_HANDLER_ASYNC,
+    OWX_STAT_CMD_HANDLER_STATUS,
+    OWX_STAT_CMD_BULK,
+    OWX_STAT_CMD_REPLAY,
+    OWX_STAT_CMD_ALARM,
+    OWX_STAT_CMD_CAPABILITIES,
+    OWX_STAT_CMD_READ_STATS,
+    OWX_STAT_CMD_UNKNOWN,
+    OWX_STAT_CMD_COUNT
+};
+
+struct OWXStatsBlock {
+    uint16_t events[OWX_STAT_EVENT_COUNT];
+    uint16_t commands[OWX_STAT_CMD_COUNT];
+    uint16_t service_cycles[OW_STATS_HIST_BUCKETS];
+};
+
+class OWXStats
+{
+#if OW_STATS
+private:
+    OWXStatsBlock block;
+
+public:
+    OWXStats() { reset(); }
+
+    void count(OWXStatEvent event) { block.events[event]++; }
+    void command(OWXStatCommand cmd) { block.commands[cmd]++; }
+
+    // Files one duty() service time into its power-of-two bucket
+    void service_time(uint32_t cycles) {
+        uint32_t scaled = cycles >> OW_STATS_HIST_SHIFT;
+        uint8_t bucket = scaled ? (uint8_t)(32 - __builtin_clz(scaled)) : 0;
+        if (bucket >= OW_STATS_HIST_BUCKETS) bucket = OW_STATS_HIST_BUCKETS - 1;
+        block.service_cycles[bucket]++;
+    }
+
+    void reset() { memset(&block, 0, sizeof(block)); }
+    const OWXStatsBlock &data() const { return block; }
+    static constexpr bool enabled() { return true; }
+#else
+private:
+    static OWXStatsBlock &empty() { static OWXStatsBlock zero = {}; return zero; }
+
+public:
+    void count(OWXStatEvent) {}
+    void command(OWXStatCommand) {}
+    void service_time(uint32_t) {}
+    void reset() {}
+    const OWXStatsBlock &data() const { return empty(); }
+    static constexpr bool enabled() { return false; }
+#endif
+};
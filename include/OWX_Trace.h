@@ -0,0 +1,148 @@
+/*
+    OWX binary trace
+
+    Replaces Serial prints on the bus path. duty() only stores a compact event in a RAM ring
+    (no UART, no formatting); loop() calls Emulator::drainTrace(Serial) to send the events out
+    of bus time. extras/trace/owx_trace_decode turns the captured bytes back into text.
+
+    Disabled by default. Enable with e.g.
+        build_flags = -D OW_TRACE=1 -D OW_TRACE_SIZE=32
+    With OW_TRACE=0 the OWX_TRACE() macro expands to nothing: no code, no arguments evaluated.
+
+    Record on the wire (drainTrace), 9 bytes, LSB first:
+        [ 0xA5 | EVENT | CMD | LEN | CYCLES (4) | CRC8 ]
+    CYCLES is OWX_CYCLE_COUNT() when the event was recorded, CRC8 covers EVENT..CYCLES.
+    Events lost because the ring was full are reported as one OWX_TRACE_LOST record
+    (LEN = lost count, saturated at 255) once the buffered events have been drained.
+*/
+#pragma once
+#include <stdint.h>
+#include <OWX_CRC.h>
+#include <OWX_Queue.h>
+#include <OWX_Stats.h>   // OWX_CYCLE_COUNT()
+
+#ifndef OW_TRACE
+#define OW_TRACE 0
+#endif
+
+#ifndef OW_TRACE_SIZE
+#define OW_TRACE_SIZE 16   // events buffered between duty() and drainTrace(), power of two
+#endif
+
+#define OWX_TRACE_SYNC        0xA5
+#define OWX_TRACE_RECORD_SIZE 9
+
+enum OWXTraceEventId : uint8_t {
+    OWX_TRACE_LOW_CMD = 1,      // CMD = low-level command byte received
+    OWX_TRACE_FRAME_OK,         // CMD = OW_CMD_* data type, LEN = payload length
+    OWX_TRACE_CRC_ERROR,        // CMD = command of the rejected frame
+    OWX_TRACE_OVERSIZE,         // CMD = data type, LEN = announced length
+    OWX_TRACE_TIMEOUT,          // recv failed, CMD = command being received
+    OWX_TRACE_UNHANDLED,        // CMD = unknown command / data type / handler command
+    OWX_TRACE_REPLY,            // CMD = reply byte (ACK, NACK, ACCEPTED, BUSY), LEN = NACK reason
+    OWX_TRACE_SCRATCHPAD_READ,  // LEN = bytes sent
+    OWX_TRACE_HANDLER,          // CMD = handler command, LEN = 1 if handled
+    OWX_TRACE_BULK,             // CMD = bulk low-level command (CRC_ERROR on a chunk: LEN = SEQ)
+    OWX_TRACE_QUEUE_OVERFLOW,   // CMD = data type that did not fit the receive queue
+    OWX_TRACE_VARIABLE_READ,    // CMD = variable ID, LEN = value bytes (0: unknown ID)
+    OWX_TRACE_SAMPLE_DRAIN,     // CMD = records sent, LEN = records acknowledged and dropped
+    OWX_TRACE_LOST,             // LEN = events dropped because the ring was full
+    OWX_TRACE_REPLAY,           // CMD = SEQ, LEN = cached reply byte sent instead of executing
+    OWX_TRACE_ALARM             // CMD = active OW_ALARM_* flags sent, LEN = CLEAR_MASK
+};
+
+struct OWXTraceEvent {
+    uint32_t cycles;
+    uint8_t event;
+    uint8_t cmd;
+    uint8_t len;
+};
+
+// Packs one event into its 9 byte wire record
+inline void owx_trace_encode(const OWXTraceEvent &ev, uint8_t *out) {
+    out[0] = OWX_TRACE_SYNC;
+    out[1] = ev.event;
+    out[2] = ev.cmd;
+    out[3] = ev.len;
+    out[4] = (uint8_t)ev.cycles;
+    out[5] = (uint8_t)(ev.cycles >> 8);
+    out[6] = (uint8_t)(ev.cycles >> 16);
+    out[7] = (uint8_t)(ev.cycles >> 24);
+    out[8] = OWXCrc8::compute(&out[1], 7);
+}
+
+// Unpacks a wire record, false if sync or CRC8 don't match
+inline bool owx_trace_decode(const uint8_t *in, OWXTraceEvent &ev) {
+    if (in[0] != OWX_TRACE_SYNC || OWXCrc8::compute(&in[1], 7) != in[8]) return false;
+    ev.event = in[1];
+    ev.cmd = in[2];
+    ev.len = in[3];
+    ev.cycles = (uint32_t)in[4] | ((uint32_t)in[5] << 8) | ((uint32_t)in[6] << 16) | ((uint32_t)in[7] << 24);
+    return true;
+}
+
+class OWXTrace
+{
+#if OW_TRACE
+private:
+    OWXSpscQueue<OWXTraceEvent, OW_TRACE_SIZE> ring;
+    volatile uint16_t lost = 0;
+
+public:
+    // Bus path: never blocks, drops the event if the ring is full
+    void record(uint8_t event, uint8_t cmd, uint8_t len) {
+        OWXTraceEvent *slot = ring.reserve();
+        if (slot == nullptr) {
+            lost = lost + 1;
+            return;
+        }
+        slot->cycles = OWX_CYCLE_COUNT();
+        slot->event = event;
+        slot->cmd = cmd;
+        slot->len = len;
+        ring.commit();
+    }
+
+    // Writes up to max_events records to out (anything with write(const uint8_t *, size_t))
+    template <class Out>
+    uint8_t drain(Out &out, uint8_t max_events) {
+        uint8_t record[OWX_TRACE_RECORD_SIZE];
+        uint8_t n = 0;
+        OWXTraceEvent ev;
+
+        while (n < max_events && ring.pop(ev)) {
+            owx_trace_encode(ev, record);
+            out.write(record, OWX_TRACE_RECORD_SIZE);
+            n++;
+        }
+        // Dropped events came after everything that was in the ring
+        if (lost && n < max_events && ring.empty()) {
+            ev.cycles = OWX_CYCLE_COUNT();
+            ev.event = OWX_TRACE_LOST;
+            ev.cmd = 0;
+            ev.len = lost > 0xFF ? 0xFF : (uint8_t)lost;
+            lost = 0;
+            owx_trace_encode(ev, record);
+            out.write(record, OWX_TRACE_RECORD_SIZE);
+            n++;
+        }
+        return n;
+    }
+
+    uint8_t pending() const { return ring.size(); }
+    static constexpr bool enabled() { return true; }
+#else
+public:
+    void record(uint8_t, uint8_t, uint8_t) {}
+    template <class Out> uint8_t drain(Out &, uint8_t) { return 0; }
+    uint8_t pending() const { return 0; }
+    static constexpr bool enabled() { return false; }
+#endif
+};
+
+// Trace point on the bus path, compiled out with OW_TRACE=0
+#if OW_TRACE
+#define OWX_TRACE(event, cmd, len) trace.record((event), (uint8_t)(cmd), (uint8_t)(len))
+#else
+#define OWX_TRACE(event, cmd, len) ((void)0)
+#endif
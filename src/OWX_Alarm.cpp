@@ -0,0 +1,63 @@
+#include <OWX_Slave_Emulator.h>
+#include <Arduino.h>
+
+// Latched source i is OW_ALARM_HANDLER << i: HANDLER, SCRATCHPAD, USER
+
+// loop() side: one more raise than the master has cleared, at most 255 ahead so the count
+// can't wrap around to the cleared one
+void EmulatorBase::raise_alarm(uint8_t source) {
+    if (alarm == nullptr) return;
+    for (uint8_t i = 0; i < 3; i++) {
+        if (source != (OW_ALARM_HANDLER << i)) continue;
+        const uint8_t raised = alarm->raised[i];
+        if ((uint8_t)(raised - alarm->cleared[i]) != 0xFF) alarm->raised[i] = raised + 1;
+    }
+}
+
+// duty() side, before the reply is built: the raises it reports
+EmulatorBase::AlarmMark EmulatorBase::mark_alarm() const {
+    AlarmMark seen = {};
+    if (alarm == nullptr) return seen;
+    for (uint8_t i = 0; i < 3; i++) seen.raised[i] = alarm->raised[i];
+    return seen;
+}
+
+// duty() side, after the reply: catches up with the raises it reported, later ones stay active
+void EmulatorBase::clear_alarm(uint8_t sources, const AlarmMark &seen) {
+    if (alarm == nullptr) return;
+    for (uint8_t i = 0; i < 3; i++) {
+        if (sources & (OW_ALARM_HANDLER << i)) alarm->cleared[i] = seen.raised[i];
+    }
+}
+
+void EmulatorBase::setAlarmMask(uint8_t mask) { if (alarm) alarm->mask = mask; }
+void EmulatorBase::raiseAlarm() { raise_alarm(OW_ALARM_USER); }
+
+// Always 0 without OW_FEATURE_ALARM: the slave never answers the conditional search
+uint8_t EmulatorBase::alarmFlags() const {
+    if (alarm == nullptr) return 0;
+    uint8_t flags = (sampleFifo && sampleFifo->size()) ? OW_ALARM_SAMPLES : 0;
+    for (uint8_t i = 0; i < 3; i++) {
+        if (alarm->raised[i] != alarm->cleared[i]) flags |= OW_ALARM_HANDLER << i;
+    }
+    return flags & alarm->mask;
+}
+
+bool EmulatorBase::alarmed() const { return alarmFlags() != 0; }
+
+// ALARM: CLEAR_MASK → FLAGS + CRC8, flags as they were before the clear
+void EmulatorBase::send_alarm(OneWireHub *hub) {
+    uint8_t clear_mask;
+    if (hub->recv(&clear_mask, 1)) {
+        stat(OWX_STAT_TIMEOUTS);
+        return;
+    }
+
+    const AlarmMark seen = mark_alarm();
+    uint8_t reply[2];
+    reply[0] = alarmFlags();
+    reply[1] = OWXCrc8::compute(reply, 1);
+    clear_alarm(clear_mask, seen);
+    OWX_TRACE(OWX_TRACE_ALARM, reply[0], clear_mask);
+    hub->send(reply, 2);
+}
@@ -0,0 +1,82 @@
+#include <OWX_Slave_Emulator.h>
+#include <Arduino.h>
+
+// Adds or replaces the destination for array ID id
+bool EmulatorBase::register_array(uint8_t id, uint8_t cmd, void *dest, uint16_t capacity) {
+    for (uint8_t i = 0; i < arrayCount; i++) {
+        if (arraySlots[i].id == id) {
+            arraySlots[i].cmd = cmd;
+            arraySlots[i].capacity = capacity;
+            arraySlots[i].dest = dest;
+            return true;
+        }
+    }
+    if (arrayCount >= arrayCapacity) return false;
+
+    arraySlots[arrayCount].id = id;
+    arraySlots[arrayCount].cmd = cmd;
+    arraySlots[arrayCount].capacity = capacity;
+    arraySlots[arrayCount].dest = dest;
+    arrayCount++;
+    return true;
+}
+
+// Decodes the elements of an OW_CMD_ARRAY_* payload (ID + ENC + START + COUNT + data)
+// straight into the registered buffer
+bool EmulatorBase::decode_array(uint8_t cmd_data_type, const uint8_t *payload, uint8_t len, OneWireHub *hub) {
+    const ArraySlot *slot = nullptr;
+    if (len >= 4) {
+        for (uint8_t i = 0; i < arrayCount; i++) {
+            if (arraySlots[i].id == payload[0]) slot = &arraySlots[i];
+        }
+    }
+
+    const uint8_t encoding = len >= 4 ? payload[1] : 0;
+    const uint8_t start = len >= 4 ? payload[2] : 0;
+    const uint8_t count = len >= 4 ? payload[3] : 0;
+    if (slot == nullptr || slot->cmd != cmd_data_type) return reject(hub, cmd_data_type, OW_NACK_UNKNOWN_ID);
+    if (count == 0 || start + count > slot->capacity) return reject(hub, cmd_data_type, OW_NACK_LENGTH);
+
+    // Reserve the notification first so a full queue leaves the buffer untouched
+    OWXMessage *msg = rxQueue.reserve();
+    if (msg == nullptr) {
+        rxOverflows = rxOverflows + 1;
+        stat(OWX_STAT_QUEUE_OVERFLOWS);
+        OWX_TRACE(OWX_TRACE_QUEUE_OVERFLOW, cmd_data_type, len);
+        if (rxDropPolicy == OW_QUEUE_DROP_NEWEST) return true;
+        return reject(hub, cmd_data_type, OW_NACK_BUSY);
+    }
+
+    const uint8_t *data = payload + 4;
+    const uint8_t data_len = len - 4;
+    bool ok = false;
+    switch (cmd_data_type) {
+        case OW_CMD_ARRAY_INT16:
+            ok = owx_array_decode(data, data_len, encoding, static_cast<int16_t *>(slot->dest) + start, count);
+            break;
+        case OW_CMD_ARRAY_UINT16:
+            ok = owx_array_decode(data, data_len, encoding, static_cast<uint16_t *>(slot->dest) + start, count);
+            break;
+        case OW_CMD_ARRAY_INT32:
+            ok = owx_array_decode(data, data_len, encoding, static_cast<int32_t *>(slot->dest) + start, count);
+            break;
+        case OW_CMD_ARRAY_FLOAT32:
+            ok = owx_array_decode(data, data_len, encoding, static_cast<float *>(slot->dest) + start, count);
+            break;
+    }
+    if (!ok) {
+        // Element count doesn't match the data or unknown encoding: reserved slot is not committed
+        return reject(hub, cmd_data_type, encoding > OW_ARRAY_DELTA_VARINT ? OW_NACK_UNKNOWN_TYPE : OW_NACK_LENGTH);
+    }
+
+    msg->type = DATA_ARRAY;
+    msg->command = cmd_data_type;
+    msg->len = count;
+    msg->value.u32 = 0;
+    msg->value.raw[0] = slot->id;
+    msg->value.raw[1] = start;
+    msg->value.raw[2] = count;
+    msg->timestamp = micros();
+    rxQueue.commit();
+    return true;
+}
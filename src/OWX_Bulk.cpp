@@ -0,0 +1,209 @@
+#include <OWX_Slave_Emulator.h>
+#include <Arduino.h>
+
+// Installs the caller-provided buffer large transfers are reassembled into
+void EmulatorBase::setBulkBuffer(uint8_t *buffer, uint16_t capacity) {
+    if (bulk == nullptr) return;
+    bulk->buf = buffer;
+    bulk->capacity = capacity;
+    clearBulk();
+}
+
+bool EmulatorBase::bulkAvailable() const { return bulk && bulk->complete; }
+uint16_t EmulatorBase::bulkLength() const { return bulkAvailable() ? bulk->total : 0; }
+
+// Drops any transfer in progress and frees the buffer for the next one
+void EmulatorBase::clearBulk() {
+    if (bulk == nullptr) return;
+    bulk->active = false;
+    bulk->complete = false;
+    bulk->total = 0;
+    bulk->expectedCrc = 0;
+    bulk->crcLen = 0;
+    bulk->crc.reset();
+    memset(bulk->map, 0, sizeof(bulk->map));
+}
+
+uint16_t EmulatorBase::bulk_chunk_count() const {
+    return (bulk->total + OW_BULK_CHUNK_SIZE - 1) / OW_BULK_CHUNK_SIZE;
+}
+
+// Handles bulk commands back to back until the master stops sending them or resets the bus
+void EmulatorBase::bulk_session(OneWireHub *hub, uint8_t low_cmd) {
+    while (true) {
+        OWX_TRACE(OWX_TRACE_BULK, low_cmd, 0);
+        switch (low_cmd) {
+            case OW_LOW_CMD_BULK_BEGIN:
+                if (!bulk_begin(hub)) return;
+                break;
+
+            case OW_LOW_CMD_BULK_CHUNK:
+                if (!bulk_chunk(hub)) return;
+                break;
+
+            case OW_LOW_CMD_BULK_STATUS:
+                if (!bulk_status(hub)) return;
+                break;
+
+            case OW_LOW_CMD_BULK_END:
+                // END always closes the session
+                bulk_end(hub);
+                return;
+
+            default:
+                // Not a bulk command: ignored like any unknown low-level command
+                return;
+        }
+
+        // Reset after the last command is the normal way out, not a timeout
+        if (hub->recv(&low_cmd, 1)) return;
+    }
+}
+
+// BEGIN: TOTAL_LEN + CRC16 + CRC8 → ACK / NACK
+bool EmulatorBase::bulk_begin(OneWireHub *hub) {
+    uint8_t header[4];
+    uint8_t recv_crc;
+
+    if (hub->recv(header, 4)) return false;
+    if (hub->recv(&recv_crc, 1)) return false;
+
+    if (OWXCrc8::compute(header, 4) != recv_crc) {
+        stat(OWX_STAT_CRC_ERRORS);
+        OWX_TRACE(OWX_TRACE_CRC_ERROR, OW_LOW_CMD_BULK_BEGIN, 4);
+        hub->raiseDeviceError(OW_LOW_CMD_BULK_BEGIN);
+        return false;
+    }
+
+    uint16_t total = (uint16_t)(header[0] | (header[1] << 8));
+    uint8_t reply = OW_CMD_ACK;
+
+    // Refuse while the application still owns a completed transfer
+    if (bulk->complete || bulk->buf == nullptr || total == 0 || total > bulk->capacity ||
+        total > (uint32_t)OW_BULK_MAX_CHUNKS * OW_BULK_CHUNK_SIZE) {
+        hub->raiseDeviceError(OW_LOW_CMD_BULK_BEGIN);
+        reply = OW_CMD_NACK;
+    } else {
+        clearBulk();
+        bulk->total = total;
+        bulk->expectedCrc = (uint16_t)(header[2] | (header[3] << 8));
+        bulk->active = true;
+    }
+
+    send_reply(hub, reply);
+    return reply == OW_CMD_ACK;
+}
+
+// CHUNK: SEQ + LEN + PAYLOAD + CRC8, received straight into the bulk buffer, no reply
+bool EmulatorBase::bulk_chunk(OneWireHub *hub) {
+    uint8_t header[2];
+    if (hub->recv(header, 2)) return false;
+
+    uint8_t seq = header[0];
+    uint8_t len = header[1];
+    uint32_t offset = (uint32_t)seq * OW_BULK_CHUNK_SIZE;
+    uint32_t expected_len = bulk->total - offset;
+    if (expected_len > OW_BULK_CHUNK_SIZE) expected_len = OW_BULK_CHUNK_SIZE;
+
+    if (!bulk->active || offset >= bulk->total || len != expected_len) {
+        hub->raiseDeviceError(OW_LOW_CMD_BULK_CHUNK);
+        return false;   // framing lost, wait for the next reset
+    }
+
+    // A chunk we already hold is read into scratch space so a corrupted resend can't damage it
+    bool have = bulk->map[seq >> 3] & (1 << (seq & 7));
+    uint8_t scratch[OW_BULK_CHUNK_SIZE];
+    uint8_t *dest = have ? scratch : &bulk->buf[offset];
+
+    OWXCrc8 crc;
+    crc.update(header, 2);
+    for (uint8_t i = 0; i < len; i++) {
+        if (hub->recv(&dest[i], 1)) return false;
+        crc.update(dest[i]);
+        bulk_fold(OW_BULK_FOLD_PER_BYTE);
+    }
+
+    uint8_t recv_crc;
+    if (hub->recv(&recv_crc, 1)) return false;
+
+    if (crc.value() != recv_crc) {
+        stat(OWX_STAT_CRC_ERRORS);
+        OWX_TRACE(OWX_TRACE_CRC_ERROR, OW_LOW_CMD_BULK_CHUNK, seq);
+        hub->raiseDeviceError(OW_LOW_CMD_BULK_CHUNK);
+        return true;    // chunk stays missing in the bitmap, the master resends it
+    }
+    if (have) return true;
+
+    bulk->map[seq >> 3] |= (1 << (seq & 7));
+    return true;
+}
+
+// Folds up to max_bytes of the received in-order prefix into the transfer CRC16.
+// Called in small steps between bus operations: folding a whole window of out-of-order
+// chunks at once would hold the bus far longer than a byte gap.
+void EmulatorBase::bulk_fold(uint8_t max_bytes) {
+    while (max_bytes && bulk->crcLen < bulk->total) {
+        uint8_t next = (uint8_t)(bulk->crcLen / OW_BULK_CHUNK_SIZE);
+        if (!(bulk->map[next >> 3] & (1 << (next & 7)))) return;
+
+        uint16_t chunk_end = (uint16_t)(next + 1) * OW_BULK_CHUNK_SIZE;
+        if (chunk_end > bulk->total) chunk_end = bulk->total;
+        uint16_t n = chunk_end - bulk->crcLen;
+        if (n > max_bytes) n = max_bytes;
+        bulk->crc.update(&bulk->buf[bulk->crcLen], n);
+        bulk->crcLen += n;
+        max_bytes -= n;
+    }
+}
+
+// STATUS: FIRST_SEQ + COUNT → FIRST_SEQ + COUNT + BITMAP + CRC8 (selective ACK)
+bool EmulatorBase::bulk_status(OneWireHub *hub) {
+    uint8_t request[2];
+    if (hub->recv(request, 2)) return false;
+
+    bulk_fold(OW_BULK_FOLD_PER_REPLY);
+
+    uint8_t first = request[0];
+    uint8_t count = request[1] > OW_BULK_STATUS_MAX ? OW_BULK_STATUS_MAX : request[1];
+
+    uint8_t reply[2 + OW_BULK_STATUS_MAX / 8 + 1];
+    uint8_t map_len = (count + 7) / 8;
+    memset(reply, 0, sizeof(reply));
+    reply[0] = first;
+    reply[1] = count;
+
+    for (uint8_t i = 0; i < count; i++) {
+        uint16_t seq = first + i;
+        if (seq < OW_BULK_MAX_CHUNKS && (bulk->map[seq >> 3] & (1 << (seq & 7))))
+            reply[2 + (i >> 3)] |= (1 << (i & 7));
+    }
+    reply[2 + map_len] = OWXCrc8::compute(reply, 2 + map_len);
+
+    return !hub->send(reply, 3 + map_len);
+}
+
+// END: ACK when every chunk arrived and the CRC16 of the whole transfer matches,
+// BUSY while the CRC16 still has to catch up with the received chunks
+void EmulatorBase::bulk_end(OneWireHub *hub) {
+    uint8_t reply = OW_CMD_NACK;
+
+    bulk_fold(OW_BULK_FOLD_PER_REPLY);
+    if (bulk->active && bulk->crcLen < bulk->total) {
+        uint8_t next = (uint8_t)(bulk->crcLen / OW_BULK_CHUNK_SIZE);
+        if (bulk->map[next >> 3] & (1 << (next & 7))) reply = OW_CMD_BUSY;
+    } else if (bulk->active) {
+        if (bulk->crc.value() == bulk->expectedCrc) {
+            bulk->active = false;
+            bulk->complete = true;
+            reply = OW_CMD_ACK;
+        } else {
+            // All chunks passed CRC8 but the transfer doesn't match: start over
+            stat(OWX_STAT_CRC_ERRORS);
+            OWX_TRACE(OWX_TRACE_CRC_ERROR, OW_LOW_CMD_BULK_END, 0);
+            hub->raiseDeviceError(OW_LOW_CMD_BULK_END);
+            clearBulk();
+        }
+    }
+
+    send_reply(hub, reply);
+}
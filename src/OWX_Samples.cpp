@@ -0,0 +1,69 @@
+#include <OWX_Slave_Emulator.h>
+#include <Arduino.h>
+
+void EmulatorBase::useSampleFifo(OWXSampleFifoBase &fifo) {
+    sampleFifo = &fifo;
+}
+
+uint8_t EmulatorBase::samplesPending() const { return sampleFifo ? sampleFifo->size() : 0; }
+
+// DRAIN_SAMPLES: MAX + ACK_SEQ + CRC8 → header + up to MAX records + CRC8
+void EmulatorBase::send_samples(OneWireHub *hub) {
+    uint8_t request[3];
+    uint8_t recv_crc;
+
+    if (hub->recv(request, 3) || hub->recv(&recv_crc, 1)) {
+        stat(OWX_STAT_TIMEOUTS);
+        return;
+    }
+    // A corrupted ACK_SEQ would drop records the master never got
+    if (OWXCrc8::compute(request, 3) != recv_crc) {
+        stat(OWX_STAT_CRC_ERRORS);
+        OWX_TRACE(OWX_TRACE_CRC_ERROR, OW_LOW_CMD_DRAIN_SAMPLES, 3);
+        hub->raiseDeviceError(OW_LOW_CMD_DRAIN_SAMPLES);
+        return;
+    }
+    if (sampleFifo == nullptr) {
+        stat(OWX_STAT_UNHANDLED);
+        OWX_TRACE(OWX_TRACE_UNHANDLED, OW_LOW_CMD_DRAIN_SAMPLES, 0);
+        hub->raiseDeviceError(OW_LOW_CMD_DRAIN_SAMPLES);
+        return;
+    }
+
+    const uint8_t acked = sampleFifo->acknowledge((uint16_t)(request[1] | (request[2] << 8)));
+    (void)acked;   // traced only
+
+    uint8_t count = sampleFifo->size();
+    if (count > request[0]) count = request[0];
+    if (count > OW_SAMPLE_DRAIN_MAX) count = OW_SAMPLE_DRAIN_MAX;
+    const uint8_t left = sampleFifo->size() - count;
+
+    const uint16_t first = sampleFifo->firstSeq();
+    const uint16_t lost = sampleFifo->lost();
+    const uint16_t overflows = sampleFifo->overflows();
+    const uint32_t now = millis();
+    uint8_t header[12] = {
+        count,
+        (uint8_t)first, (uint8_t)(first >> 8),
+        left,
+        (uint8_t)lost, (uint8_t)(lost >> 8),
+        (uint8_t)overflows, (uint8_t)(overflows >> 8),
+        (uint8_t)now, (uint8_t)(now >> 8), (uint8_t)(now >> 16), (uint8_t)(now >> 24)
+    };
+
+    OWX_TRACE(OWX_TRACE_SAMPLE_DRAIN, count, acked);
+    OWXCrc8 crc;
+    crc.update(header, sizeof(header));
+    if (hub->send(header, sizeof(header))) return;
+
+    // Records stay in the FIFO until the next request acknowledges them
+    uint8_t record[OWX_SAMPLE_RECORD_SIZE];
+    for (uint8_t i = 0; i < count; i++) {
+        sampleFifo->encode(i, record);
+        crc.update(record, OWX_SAMPLE_RECORD_SIZE);
+        if (hub->send(record, OWX_SAMPLE_RECORD_SIZE)) return;
+    }
+
+    const uint8_t crc_byte = crc.value();
+    hub->send(&crc_byte, 1);
+}
@@ -1,321 +1,978 @@
 #include <OWX_Slave_Emulator.h>
 #include <Arduino.h>
 
+OWXEngine EmulatorBase::engine;
+
 // Constructor initializes device ROM, scratchpad state and internal buffers
-Emulator::Emulator(uint8_t ID1, uint8_t ID2, uint8_t ID3, uint8_t ID4,
-                   uint8_t ID5, uint8_t ID6, uint8_t ID7)
+EmulatorBase::EmulatorBase(uint8_t ID1, uint8_t ID2, uint8_t ID3, uint8_t ID4,
+                           uint8_t ID5, uint8_t ID6, uint8_t ID7,
+                           OWXScratchpadBase &pad, StructSlot *struct_slots, uint8_t struct_capacity,
+                           ArraySlot *array_slots, uint8_t array_capacity, const FeatureStorage &features)
     : OneWireItem(ID1, ID2, ID3, ID4, ID5, ID6, ID7)
 {
-    // Scratchpad is not pre-filled; default length = 9 bytes
-    scratchpadLen = 9;
+    // Scratchpad starts zeroed; the built-in one is sized by the FeatureEmulator configuration
+    scratchpad = &pad;
+    handlerRunning = false;
 
     lastCommand = 0x00;
-    rawBufferLen = 0;
-
-    int32_value = 0;
-    float_value = 0.0f;
-
-    customHandler = nullptr;
-    dataAvailable = false;
-    lastDataType = Emulator::DATA_NONE;
-}
-
-// Local CRC8 calculation used for packet verification
-uint8_t crc8_local(const uint8_t *data, size_t len, uint8_t crc_init = 0) {
-    uint8_t crc = crc_init;
-    while (len--) {
-        uint8_t in = *data++;
-        for (uint8_t i = 0; i < 8; ++i) {
-            uint8_t mix = (crc ^ in) & 0x01;
-            crc >>= 1;
-            if (mix) crc ^= 0x8C;   // Dallas/Maxim CRC polynomial
-            in >>= 1;
-        }
-    }
-    return crc;
-}
 
-// Sends a generic packet: CMD + LEN + PAYLOAD + CRC
-void Emulator::send_packet(uint8_t cmd, uint8_t* data, uint8_t len, OneWireHub *hub){
-    // Prepare CRC source buffer
-    uint8_t crc_buf[2 + len];
-    crc_buf[0] = cmd;
-    crc_buf[1] = len;
+    structSlots = struct_slots;
+    structCapacity = struct_capacity;
+    structCount = 0;
 
-    for(uint8_t i = 0; i < len; i++)
-        crc_buf[2 + i] = data[i];
+    arraySlots = array_slots;
+    arrayCapacity = array_capacity;
+    arrayCount = 0;
 
-    uint8_t crc = crc8_local(crc_buf, 2 + len);
+    sampleFifo = nullptr;
 
-    // OneWire custom low-level header
-    uint8_t header = OW_LOW_CMD_SEND_VARIABLE_;
-    hub->send(&header, 1);
+    overdriveCapable = false;
 
-    // Send CMD and length
-    hub->send(&cmd, 1);
-    hub->send(&len, 1);  // Length is always one byte
+    // Optional subsystems initialise themselves; nothing of a feature left out is referenced here
+    handlers = features.handlers;
+    seq = features.seq;
+    variables = features.variables;
+    alarm = features.alarm;
+    bulk = features.bulk;
+    stats = features.stats;
+    receivers = features.receivers;
 
-    // Send payload
-    for(uint8_t i = 0; i < len; i++)
-        hub->send(&data[i], 1);
+    asyncState = OW_ASYNC_IDLE;
+    asyncCommand = 0;
+    asyncResult = 0;
 
-    // Send CRC
-    hub->send(&crc, 1);
+    rxDropPolicy = OW_QUEUE_REJECT;
+    rxOverflows = 0;
 }
 
-// Writes multiple bytes into the scratchpad at a specific offset
-void Emulator::writeScratchpad_byte(uint8_t* data, uint8_t len, uint8_t addr) {
-    // Bounds check: do not overflow scratchpad
-    if(len > OW_SCRATCHPAD_SIZE) return;
+// Sends a generic packet: CMD + LEN + PAYLOAD + CRC
+// The CRC is computed in place over the caller's buffer and the frame goes out in three send() calls
+void EmulatorBase::send_packet(uint8_t cmd, const uint8_t* data, uint8_t len, OneWireHub *hub){
+    // OneWire custom low-level header + CMD + length (length is always one byte)
+    const uint8_t header[3] = { OW_LOW_CMD_SEND_VARIABLE_, cmd, len };
+
+    // CRC covers CMD + LEN + PAYLOAD
+    OWXCrc8 crc;
+    crc.update(&header[1], 2);
+    crc.update(data, len);
+    const uint8_t crc_byte = crc.value();
+
+    if (hub->send(header, 3)) return;
+    if (len && hub->send(data, len)) return;
+    hub->send(&crc_byte, 1);
+}
+
+// Replaces the built-in scratchpad, e.g. with an OWXScratchpad<N, true> of another size
+void EmulatorBase::useScratchpad(OWXScratchpadBase &pad) {
+    scratchpad = &pad;
+}
+
+// Atomically makes all staged scratchpad writes visible to the master
+void EmulatorBase::publishScratchpad() {
+    const uint8_t gen = scratchpad->generation();
+    scratchpad->publish();
+    // Something the master hasn't seen yet: take part in the next conditional search
+    if(scratchpad->generation() != gen) raise_alarm(OW_ALARM_SCRATCHPAD);
+}
 
-    uint8_t max_aviable_len = OW_SCRATCHPAD_SIZE - addr;
-    if(len > max_aviable_len) return;
+uint8_t EmulatorBase::scratchpadGeneration() const { return scratchpad->generation(); }
 
-    // Write byte-by-byte
-    for(uint8_t i = 0; i < len; i++)
-        scratchpad[addr + i] = data[i];
+// Stages multiple bytes into the scratchpad; the master sees them after publishScratchpad()
+bool EmulatorBase::stageScratchpad(const uint8_t* data, uint8_t len, uint8_t addr) {
+    // Bounds check inside: do not overflow scratchpad
+    return scratchpad->stage(data, len, addr);
 }
 
+// Writes multiple bytes into the scratchpad at a specific offset
+void EmulatorBase::writeScratchpad_byte(const uint8_t* data, uint8_t len, uint8_t addr) {
+    if(!scratchpad->stage(data, len, addr)) return;
+    // A handler's writes go out together when it returns
+    if(!handlerRunning) publishScratchpad();
+}
 
 // Writes an int8_t value into the scratchpad at a specific offset
-void Emulator::writeScratchpad_int8(int8_t value, uint8_t addr) {
+void EmulatorBase::writeScratchpad_int8(int8_t value, uint8_t addr) {
     writeScratchpad_byte(reinterpret_cast<uint8_t*>(&value), sizeof(int8_t), addr);
 }
 
 // Writes a uint8_t value into the scratchpad at a specific offset
-void Emulator::writeScratchpad_uint8(uint8_t value, uint8_t addr) {
+void EmulatorBase::writeScratchpad_uint8(uint8_t value, uint8_t addr) {
     writeScratchpad_byte(&value, sizeof(uint8_t), addr);
 }
 
 // Writes an int16_t value into the scratchpad at a specific offset
-void Emulator::writeScratchpad_int16(int16_t value, uint8_t addr) {
+void EmulatorBase::writeScratchpad_int16(int16_t value, uint8_t addr) {
     writeScratchpad_byte(reinterpret_cast<uint8_t*>(&value), sizeof(int16_t), addr);
 }
 
 // Writes a uint16_t value into the scratchpad at a specific offset
-void Emulator::writeScratchpad_uint16(uint16_t value, uint8_t addr) {
+void EmulatorBase::writeScratchpad_uint16(uint16_t value, uint8_t addr) {
     writeScratchpad_byte(reinterpret_cast<uint8_t*>(&value), sizeof(uint16_t), addr);
 }
 
 // Writes an int32_t value into the scratchpad at a specific offset
-void Emulator::writeScratchpad_int32(int32_t value, uint8_t addr) {
+void EmulatorBase::writeScratchpad_int32(int32_t value, uint8_t addr) {
     writeScratchpad_byte(reinterpret_cast<uint8_t*>(&value), sizeof(int32_t), addr);
 }
 
 // Writes a uint32_t value into the scratchpad at a specific offset
-void Emulator::writeScratchpad_uint32(uint32_t value, uint8_t addr) {
+void EmulatorBase::writeScratchpad_uint32(uint32_t value, uint8_t addr) {
     writeScratchpad_byte(reinterpret_cast<uint8_t*>(&value), sizeof(uint32_t), addr);
 }
 
 // Writes a float value into the scratchpad at a specific offset
-void Emulator::writeScratchpad_float(float value, uint8_t addr) {
+void EmulatorBase::writeScratchpad_float(float value, uint8_t addr) {
     writeScratchpad_byte(reinterpret_cast<uint8_t*>(&value), sizeof(float), addr);
 }
 
 // Reads a structured payload: CMD + LEN + PAYLOAD + CRC
-void Emulator::read_variable_payload(OneWireHub *hub){
+void EmulatorBase::read_variable_payload(OneWireHub *hub, uint8_t *payload_buf, uint8_t max_payload){
     uint8_t packet_header[2];
+    OWXCrc8 crc;
     
     // Read CMD + LEN
-    if (hub->recv(packet_header, 2)) 
+    if (hub->recv(packet_header, 2)) {
+        stat(OWX_STAT_TIMEOUTS);
+        OWX_TRACE(OWX_TRACE_TIMEOUT, OW_LOW_CMD_SEND_VARIABLE_, 0);
         return;
+    }
+    crc.update(packet_header, 2);
 
     uint8_t payload_len = packet_header[1];
-    if (payload_len == 0) return;
 
-    // Validate length against max allowed
-    if (payload_len > OW_MAX_PAYLOAD) {
+    // Validate length against max allowed; the rest of the frame is read so the NACK comes after the master's CRC8
+    if (payload_len == 0 || payload_len > max_payload) {
+        stat(OWX_STAT_OVERSIZE);
+        OWX_TRACE(OWX_TRACE_OVERSIZE, packet_header[0], payload_len);
         hub->raiseDeviceError(packet_header[0]);
+        uint8_t skipped;
+        for (uint16_t i = 0; i <= payload_len; i++) {
+            if (hub->recv(&skipped, 1)) {
+                stat(OWX_STAT_TIMEOUTS);
+                return;
+            }
+        }
+        send_nack(hub, OW_NACK_LENGTH);
         return;
     }
 
-    // Read payload into a fixed-size buffer
-    uint8_t payload_buf[OW_MAX_PAYLOAD];
-    if (hub->recv(payload_buf, payload_len)) {
-        hub->raiseDeviceError(packet_header[0]);
-        return;
+    // Read payload into the configuration's buffer, folding the CRC in while the next byte is on the wire
+    for (uint8_t i = 0; i < payload_len; i++) {
+        if (hub->recv(&payload_buf[i], 1)) {
+            stat(OWX_STAT_TIMEOUTS);
+            OWX_TRACE(OWX_TRACE_TIMEOUT, packet_header[0], i);
+            hub->raiseDeviceError(packet_header[0]);
+            return;
+        }
+        crc.update(payload_buf[i]);
     }
 
     // Read CRC byte
     uint8_t recv_crc;
     if (hub->recv(&recv_crc, 1)){
+        stat(OWX_STAT_TIMEOUTS);
+        OWX_TRACE(OWX_TRACE_TIMEOUT, packet_header[0], payload_len);
         hub->raiseDeviceError(packet_header[0]);
         return; 
     }
 
-    // Recalculate CRC from received data
-    uint8_t calc_crc = crc8_local(packet_header, 2);
-    calc_crc = crc8_local(payload_buf, payload_len, calc_crc);
-
-    if (calc_crc != recv_crc) {
-        // CRC mismatch → corruption detected
+    if (crc.value() != recv_crc) {
+        // CRC mismatch → corruption detected, the master resends
+        stat(OWX_STAT_CRC_ERRORS);
+        OWX_TRACE(OWX_TRACE_CRC_ERROR, packet_header[0], payload_len);
         hub->raiseDeviceError(packet_header[0]);
+        send_nack(hub, OW_NACK_CRC);
         return;
     }
 
+    // Retry of a frame that was already stored: answer from the cache, don't queue it twice
+    if (replay_duplicate(hub, OW_LOW_CMD_SEND_VARIABLE_, recv_crc)) return;
+
     // Store last command ID
     lastCommand = packet_header[0];
 
-    // Dispatch to command-specific handler
+    // Dispatch to command-specific handler; decoders that refuse the frame set engine.nackReason
+    engine.nackReason = OW_NACK_UNKNOWN_TYPE;
     bool handled = process_specific_payload_Command(packet_header[0], payload_buf, payload_len, hub);
 
     // Acknowledge correctly handled commands
     if(handled){
-        uint8_t ack = OW_CMD_ACK;
-        hub->send(&ack, 1);
+        stat(OWX_STAT_FRAMES_OK);
+        OWX_TRACE(OWX_TRACE_FRAME_OK, packet_header[0], payload_len);
+        remember_reply(OW_LOW_CMD_SEND_VARIABLE_, recv_crc, OW_CMD_ACK, 0);
+        send_reply(hub, OW_CMD_ACK);
+    } else {
+        stat(OWX_STAT_UNHANDLED);
+        OWX_TRACE(OWX_TRACE_UNHANDLED, packet_header[0], payload_len);
+        send_nack(hub, engine.nackReason);
+    }
+}
+
+// Sends a one-byte reply (ACK, NACK, ...) and counts it
+void EmulatorBase::send_reply(OneWireHub *hub, uint8_t reply){
+    stat(reply == OW_CMD_ACK || reply == OW_CMD_ACCEPTED ? OWX_STAT_ACKS : OWX_STAT_NACKS);
+    OWX_TRACE(OWX_TRACE_REPLY, reply, 1);
+    hub->send(&reply, 1);
+}
+
+// Sends NACK + OW_NACK_* reason
+void EmulatorBase::send_nack(OneWireHub *hub, uint8_t reason){
+    const uint8_t reply[2] = { OW_CMD_NACK, reason };
+    stat(OWX_STAT_NACKS);
+    OWX_TRACE(OWX_TRACE_REPLY, OW_CMD_NACK, reason);
+    hub->send(reply, 2);
+}
+
+// Refuses a frame from inside a decoder: device error plus the reason its NACK carries
+bool EmulatorBase::reject(OneWireHub *hub, uint8_t cmd, uint8_t reason){
+    hub->raiseDeviceError(cmd);
+    engine.nackReason = reason;
+    return false;
+}
+
+// Value that can't be stored now (queue full, struct not consumed yet): NACK BUSY so the master
+// retries, or with OW_QUEUE_DROP_NEWEST accept the frame and discard the value
+bool EmulatorBase::refuse_value(OneWireHub *hub, uint8_t cmd, uint8_t len){
+    (void)len;   // traced only
+    rxOverflows = rxOverflows + 1;
+    stat(OWX_STAT_QUEUE_OVERFLOWS);
+    OWX_TRACE(OWX_TRACE_QUEUE_OVERFLOW, cmd, len);
+    if(rxDropPolicy == OW_QUEUE_DROP_NEWEST) return true;
+    return reject(hub, cmd, OW_NACK_BUSY);
+}
+
+// True if this sequenced command was already executed; its cached reply has been sent again
+bool EmulatorBase::replay_duplicate(OneWireHub *hub, uint8_t low_cmd, uint8_t fingerprint){
+    if (!engine.seqActive || !seq->valid || engine.seqCurrent != seq->last || low_cmd != seq->lastCmd || fingerprint != seq->lastFp)
+        return false;
+    send_cached_reply(hub, engine.seqCurrent);
+    return true;
+}
+
+// Keeps the reply of an executed sequenced command; reason 0 = no reason byte
+void EmulatorBase::remember_reply(uint8_t low_cmd, uint8_t fingerprint, uint8_t reply, uint8_t reason){
+    if (!engine.seqActive) return;
+    seq->valid = true;
+    seq->last = engine.seqCurrent;
+    seq->lastCmd = low_cmd;
+    seq->lastFp = fingerprint;
+    seq->reply[0] = reply;
+    seq->reply[1] = reason;
+    seq->replyLen = reason ? 2 : 1;
+}
+
+// REPLAY: [ SEQ ] → cached reply, or NACK NOT_EXECUTED if SEQ never ran (or was overwritten)
+void EmulatorBase::send_cached_reply(OneWireHub *hub, uint8_t seq_nr){
+    if (!seq->valid || seq_nr != seq->last) {
+        send_nack(hub, OW_NACK_NOT_EXECUTED);
+        return;
+    }
+    stat(OWX_STAT_REPLAYS);
+    OWX_TRACE(OWX_TRACE_REPLAY, seq_nr, seq->reply[0]);
+    hub->send(seq->reply, seq->replyLen);
+}
+
+// Receives a handler command byte and dispatches it to the user handler
+void EmulatorBase::parse_handler_command(OneWireHub *hub, uint8_t low_cmd){
+    uint8_t handler_command;
+
+    if(hub->recv(&handler_command, 1)) {
+        stat(OWX_STAT_TIMEOUTS);
+        OWX_TRACE(OWX_TRACE_TIMEOUT, OW_HANDLER_COMMAND, 0);
+        return;
+    }
+
+    // A retried handler command must not run twice
+    if(replay_duplicate(hub, low_cmd, handler_command)) return;
+
+    // Per-command handler if registered, catch-all otherwise
+    const OWXHandler *handler = find_handler(handler_command);
+    const bool outer_handler = handlerRunning;
+    handlerRunning = true;
+    const bool handled = handler && (*handler)(handler_command);
+    handlerRunning = outer_handler;
+    OWX_TRACE(OWX_TRACE_HANDLER, handler_command, handled);
+    if(handled){
+        // Whatever the handler wrote is what the master reads next
+        publishScratchpad();
+        remember_reply(low_cmd, handler_command, OW_CMD_ACK, 0);
+        send_reply(hub, OW_CMD_ACK);
+    } else {
+        stat(OWX_STAT_UNHANDLED);
+        // Half of a failed update must not go out with the next publish
+        scratchpad->discard();
+        // A handler that ran and failed counts as executed
+        if(handler) remember_reply(low_cmd, handler_command, OW_CMD_NACK, OW_NACK_UNHANDLED);
+        send_nack(hub, OW_NACK_UNHANDLED);
     }
 }
-void parse_handler_command(OneWireHub *hub){
+
+// Accepts a handler command for later execution from loop(); the bus is released right away
+void EmulatorBase::parse_async_handler_command(OneWireHub *hub, uint8_t low_cmd){
     uint8_t handler_command;
 
-    if(hub->recv(&handler_command, 1)) return;
+    if(hub->recv(&handler_command, 1)) {
+        stat(OWX_STAT_TIMEOUTS);
+        OWX_TRACE(OWX_TRACE_TIMEOUT, OW_HANDLER_COMMAND_ASYNC, 0);
+        return;
+    }
+
+    // ACCEPTED already: queueing it again would run the handler twice
+    if(replay_duplicate(hub, low_cmd, handler_command)) return;
+
+    OWX_TRACE(OWX_TRACE_HANDLER, handler_command, 0);
+    uint8_t state = asyncState.load(std::memory_order_acquire);
+    uint8_t reply = OW_CMD_BUSY;
+
+    if(state != OW_ASYNC_PENDING && state != OW_ASYNC_RUNNING){
+        asyncCommand = handler_command;
+        asyncResult = 0;
+        asyncState.store(OW_ASYNC_PENDING, std::memory_order_release);
+        reply = OW_CMD_ACCEPTED;
+        remember_reply(low_cmd, handler_command, OW_CMD_ACCEPTED, 0);
+    }
+    send_reply(hub, reply);
+}
+
+// Reports STATE + CMD + RESULT + CRC8 of the last split-phase handler command
+void EmulatorBase::send_handler_status(OneWireHub *hub){
+    const AlarmMark seen = mark_alarm();
+    uint8_t status[4];
+    status[0] = asyncState.load(std::memory_order_acquire);
+    status[1] = asyncCommand;
+    status[2] = asyncResult;
+    status[3] = OWXCrc8::compute(status, 3);
+    // The master now knows the outcome
+    if(status[0] == OW_ASYNC_DONE || status[0] == OW_ASYNC_FAILED) clear_alarm(OW_ALARM_HANDLER, seen);
+    hub->send(status, 4);
+}
+
+// Runs the accepted split-phase handler command; returns true if one was executed
+bool EmulatorBase::processPending(){
+    if(asyncState.load(std::memory_order_acquire) != OW_ASYNC_PENDING) return false;
+    asyncState.store(OW_ASYNC_RUNNING, std::memory_order_release);
+
+    EmulatorBase *outer = engine.device;
+    engine.device = this;
+    const OWXHandler *handler = find_handler(asyncCommand);
+    const bool outer_handler = handlerRunning;
+    handlerRunning = true;
+    bool ok = handler && (*handler)(asyncCommand);
+    handlerRunning = outer_handler;
+    engine.device = outer;
+    if(ok) publishScratchpad();
+    else scratchpad->discard();
+
+    asyncState.store(ok ? OW_ASYNC_DONE : OW_ASYNC_FAILED, std::memory_order_release);
+    raise_alarm(OW_ALARM_HANDLER);
+    return true;
+}
+
+void EmulatorBase::setHandlerResult(uint8_t result) { asyncResult = result; }
+uint8_t EmulatorBase::handlerState() const { return asyncState.load(std::memory_order_acquire); }
+EmulatorBase *EmulatorBase::serving() { return engine.device; }
+
+// FULL: one published snapshot, optional CRC8 already appended at publish time. A publish
+// after the mark raises the alarm again, one during the send is not cleared with it.
+void EmulatorBase::send_scratchpad(OneWireHub *hub){
+    OWX_TRACE(OWX_TRACE_SCRATCHPAD_READ, OW_READ_SCRATCHPAD, scratchpad->read_length());
+    const AlarmMark seen = mark_alarm();
+    hub->send(scratchpad->read_image(), scratchpad->read_length());
+    clear_alarm(OW_ALARM_SCRATCHPAD, seen);
+}
+
+// RANGE: OFFSET + LEN → DATA + CRC8 from the published image
+void EmulatorBase::send_scratchpad_range(OneWireHub *hub){
+    uint8_t request[2];
+    if(hub->recv(request, 2)) {
+        stat(OWX_STAT_TIMEOUTS);
+        return;
+    }
 
-    if(customHandler){
-        bool result = customHandler(handler_command);  // ✅ ОЦЕ ПРАВИЛЬНО
+    const uint8_t offset = request[0];
+    const uint8_t len = request[1];
+    if(len == 0 || offset >= scratchpad->length() || len > scratchpad->length() - offset) {
+        stat(OWX_STAT_OVERSIZE);
+        OWX_TRACE(OWX_TRACE_OVERSIZE, OW_READ_SCRATCHPAD_RANGE, len);
+        hub->raiseDeviceError(OW_READ_SCRATCHPAD_RANGE);
+        return;
+    }
+
+    const uint8_t *image = scratchpad->read_image();
+    OWXCrc8 crc;
+    crc.update(request, 2);
+    crc.update(&image[offset], len);
+    const uint8_t crc_byte = crc.value();
 
-        if(result){
-            uint8_t ack = OW_CMD_ACK;
-            hub->send(&ack, 1);
+    OWX_TRACE(OWX_TRACE_SCRATCHPAD_READ, OW_READ_SCRATCHPAD_RANGE, len);
+    if(hub->send(&image[offset], len)) return;
+    hub->send(&crc_byte, 1);
+}
+
+// CHANGED: LAST_GEN → UNCHANGED, or GEN + COUNT + regions + CRC8
+void EmulatorBase::send_scratchpad_changes(OneWireHub *hub){
+    uint8_t acked_gen;
+    if(hub->recv(&acked_gen, 1)) {
+        stat(OWX_STAT_TIMEOUTS);
+        return;
+    }
+
+    const uint8_t *image = scratchpad->read_image();
+    const uint8_t *map = scratchpad->take_changes(acked_gen);
+    if(map == nullptr) {
+        OWX_TRACE(OWX_TRACE_SCRATCHPAD_READ, OW_READ_SCRATCHPAD_CHANGED, 0);
+        const uint8_t unchanged = OW_SCRATCHPAD_UNCHANGED;
+        hub->send(&unchanged, 1);
+        return;
+    }
+
+    // Runs of changed bytes; gaps of up to 2 bytes are sent along, a region header costs the same
+    uint8_t region_start[OW_SCRATCHPAD_MAX_REGIONS];
+    uint8_t region_len[OW_SCRATCHPAD_MAX_REGIONS];
+    uint8_t count = 0;
+    const uint8_t size = scratchpad->length();
+    for(uint8_t i = 0; i < size; i++) {
+        if(!(map[i >> 3] & (1 << (i & 7)))) continue;
+        if(count && i - (region_start[count - 1] + region_len[count - 1]) <= 2) {
+            region_len[count - 1] = i - region_start[count - 1] + 1;
+        } else if(count < OW_SCRATCHPAD_MAX_REGIONS) {
+            region_start[count] = i;
+            region_len[count] = 1;
+            count++;
+        } else {
+            // Out of region slots: stretch the last one to the end of the changes
+            region_len[count - 1] = i - region_start[count - 1] + 1;
         }
     }
-    
+
+    uint8_t header[3] = { OW_SCRATCHPAD_CHANGED, scratchpad->generation(), count };
+    OWXCrc8 crc;
+    crc.update(&header[1], 2);
+    if(hub->send(header, 3)) return;
+
+    uint16_t sent = 0;
+    for(uint8_t r = 0; r < count; r++) {
+        uint8_t region[2] = { region_start[r], region_len[r] };
+        crc.update(region, 2);
+        crc.update(&image[region[0]], region[1]);
+        if(hub->send(region, 2)) return;
+        if(hub->send(&image[region[0]], region[1])) return;
+        sent += region[1];
+    }
+
+    const uint8_t crc_byte = crc.value();
+    OWX_TRACE(OWX_TRACE_SCRATCHPAD_READ, OW_READ_SCRATCHPAD_CHANGED, sent > 0xFF ? 0xFF : sent);
+    hub->send(&crc_byte, 1);
 }
+
+// Sends STATS_LEN + stats block + CRC8; FLAGS bit 0 clears the counters after the read
+void EmulatorBase::send_stats(OneWireHub *hub){
+    uint8_t flags;
+    if(hub->recv(&flags, 1)) {
+        stat(OWX_STAT_TIMEOUTS);
+        return;
+    }
+
+    const uint8_t *block = reinterpret_cast<const uint8_t *>(&stats->data());
+    const uint8_t len = OWXStats::enabled() ? sizeof(OWXStatsBlock) : 0;
+
+    OWXCrc8 crc;
+    crc.update(len);
+    crc.update(block, len);
+    const uint8_t crc_byte = crc.value();
+
+    if(hub->send(&len, 1)) return;
+    if(len && hub->send(block, len)) return;
+    if(hub->send(&crc_byte, 1)) return;
+
+    if(flags & OW_STATS_FLAG_CLEAR) stats->reset();
+}
+
+// All zero in a configuration without OW_FEATURE_STATS
+const OWXStatsBlock &EmulatorBase::getStats() const {
+    static const OWXStatsBlock none = {};
+    return stats ? stats->data() : none;
+}
+void EmulatorBase::resetStats() { if(stats) stats->reset(); }
+
+// Trace events waiting for drainTrace()
+uint8_t EmulatorBase::tracePending() const { return trace.pending(); }
+
+void EmulatorBase::setOverdrive(bool enabled) { overdriveCapable = enabled; }
+
+// CAPABILITIES: what this configuration supports and how long the master waits for a reply
+void EmulatorBase::send_capabilities(OneWireHub *hub, uint8_t max_payload){
+    // Only what this configuration was built with
+    uint16_t features = 0;
+    if(seq) features |= OW_CAP_SEQUENCED;
+    if(alarm) features |= OW_CAP_ALARM;
+    if(stats && OW_STATS) features |= OW_CAP_STATS;
+    if(overdriveCapable) features |= OW_CAP_OVERDRIVE;
+    if(bulk && bulk->buf) features |= OW_CAP_BULK;
+    if(sampleFifo) features |= OW_CAP_SAMPLES;
+
+    uint8_t reply[7] = {
+        OW_PROTOCOL_VERSION,
+        (uint8_t)features, (uint8_t)(features >> 8),
+        max_payload,
+        scratchpad->read_length(),
+        OW_TURNAROUND_US,
+        0
+    };
+    reply[6] = OWXCrc8::compute(reply, 6);
+    hub->send(reply, 7);
+}
+
+// Serves one transaction as the engine's current device
+void EmulatorBase::dispatch(OneWireHub *hub, uint8_t *payload_buf, uint8_t max_payload){
+    // duty() may interrupt a processPending() of another instance: put its device back after
+    EmulatorBase *outer = engine.device;
+    engine.device = this;
+    dispatch_command(hub, payload_buf, max_payload);
+    engine.device = outer;
+}
+
 // Main low-level dispatcher for incoming OneWire commands
-void Emulator::duty(OneWireHub *hub){
+void EmulatorBase::dispatch_command(OneWireHub *hub, uint8_t *payload_buf, uint8_t max_payload){
+    const uint32_t start = OWX_CYCLE_COUNT();
     uint8_t low_cmd;
 
     // Receive low-level 1-byte command
     if(hub->recv(&low_cmd, 1)) return;
+    OWX_TRACE(OWX_TRACE_LOW_CMD, low_cmd, 0);
 
+    engine.seqActive = false;
+    execute_command(hub, low_cmd, payload_buf, max_payload);
+
+    // Keep a stats read out of the histogram it just sent
+    if(stats && low_cmd != OW_LOW_CMD_READ_STATS) stats->service_time(OWX_CYCLE_COUNT() - start);
+}
+
+// Runs one low-level command; the ones of optional features go through route_command()
+void EmulatorBase::execute_command(OneWireHub *hub, uint8_t low_cmd, uint8_t *payload_buf, uint8_t max_payload){
     switch(low_cmd){
         case OW_READ_SCRATCHPAD:
             // Send all scratchpad bytes
-            Serial.println(F("OW_READ_SCRATCHPAD command received"));
-            for(uint8_t i = 0; i < scratchpadLen; i++)
-                hub->send(&scratchpad[i], 1);
-        break;
-        
+            stat(OWX_STAT_CMD_READ_SCRATCHPAD);
+            send_scratchpad(hub);
+            break;
+
         case OW_LOW_CMD_SEND_VARIABLE_:
             // Higher-level packet incoming
-            read_variable_payload(hub);
+            stat(OWX_STAT_CMD_SEND_VARIABLE);
+            read_variable_payload(hub, payload_buf, max_payload);
             break;
-        case OW_HANDLER_COMMAND: 
-            // Custom handler command
-            parse_handler_command(hub);
+
+        case OW_LOW_CMD_CAPABILITIES:
+            stat(OWX_STAT_CMD_CAPABILITIES);
+            send_capabilities(hub, max_payload);
             break;
-            
 
         default:
-            // Unknown low-level command (ignored)
+            if(route_command(hub, low_cmd, payload_buf, max_payload)) break;
+            // Unknown low-level command, or one of a feature this configuration leaves out (ignored)
+            stat(OWX_STAT_CMD_UNKNOWN);
+            stat(OWX_STAT_UNHANDLED);
+            OWX_TRACE(OWX_TRACE_UNHANDLED, low_cmd, 0);
             break;
     }
 }
 
-// Handles payload and decodes values according to data type
-bool Emulator::process_specific_payload_Command(
+// --- Optional low-level commands, referenced only by configurations that route them ---
+
+// Sequenced command: SEQ, then the command itself
+bool EmulatorBase::serve_sequenced(OneWireHub *hub, uint8_t *payload_buf, uint8_t max_payload){
+    uint8_t low_cmd;
+    if(hub->recv(&engine.seqCurrent, 1) || hub->recv(&low_cmd, 1)) {
+        stat(OWX_STAT_TIMEOUTS);
+        OWX_TRACE(OWX_TRACE_TIMEOUT, OW_LOW_CMD_SEQUENCED, 0);
+        return true;
+    }
+    OWX_TRACE(OWX_TRACE_LOW_CMD, low_cmd, engine.seqCurrent);
+    // No nesting: a second prefix is an unknown command
+    if(low_cmd == OW_LOW_CMD_SEQUENCED) return false;
+    engine.seqActive = true;
+    execute_command(hub, low_cmd, payload_buf, max_payload);
+    return true;
+}
+
+// Reply of a sequenced command whose answer the master didn't get
+bool EmulatorBase::serve_replay(OneWireHub *hub){
+    stat(OWX_STAT_CMD_REPLAY);
+    uint8_t seq_nr;
+    if(hub->recv(&seq_nr, 1)) {
+        stat(OWX_STAT_TIMEOUTS);
+        return true;
+    }
+    send_cached_reply(hub, seq_nr);
+    return true;
+}
+
+bool EmulatorBase::serve_partial_read(OneWireHub *hub, uint8_t low_cmd){
+    if(low_cmd == OW_READ_SCRATCHPAD_RANGE) {
+        stat(OWX_STAT_CMD_READ_SCRATCHPAD_RANGE);
+        send_scratchpad_range(hub);
+        return true;
+    }
+    // Only what changed since the master's last poll, one byte if nothing did
+    stat(OWX_STAT_CMD_READ_SCRATCHPAD_CHANGED);
+    const AlarmMark seen = mark_alarm();
+    send_scratchpad_changes(hub);
+    clear_alarm(OW_ALARM_SCRATCHPAD, seen);
+    return true;
+}
+
+// Live values by ID, answered in this transaction
+bool EmulatorBase::serve_variables(OneWireHub *hub){
+    stat(OWX_STAT_CMD_READ_VARIABLES);
+    send_variables(hub);
+    return true;
+}
+
+bool EmulatorBase::serve_samples(OneWireHub *hub){
+    stat(OWX_STAT_CMD_DRAIN_SAMPLES);
+    send_samples(hub);
+    return true;
+}
+
+// Custom handler command
+bool EmulatorBase::serve_handler(OneWireHub *hub, uint8_t low_cmd){
+    stat(OWX_STAT_CMD_HANDLER);
+    parse_handler_command(hub, low_cmd);
+    return true;
+}
+
+// Split-phase handler command, executed by processPending(), and its status
+bool EmulatorBase::serve_async(OneWireHub *hub, uint8_t low_cmd){
+    if(low_cmd == OW_HANDLER_STATUS) {
+        stat(OWX_STAT_CMD_HANDLER_STATUS);
+        send_handler_status(hub);
+        return true;
+    }
+    stat(OWX_STAT_CMD_HANDLER_ASYNC);
+    parse_async_handler_command(hub, low_cmd);
+    return true;
+}
+
+// Fragmented transfer, may span several commands in this transaction
+bool EmulatorBase::serve_bulk(OneWireHub *hub, uint8_t low_cmd){
+    stat(OWX_STAT_CMD_BULK);
+    bulk_session(hub, low_cmd);
+    return true;
+}
+
+// Which sources made this slave answer the conditional search, optionally cleared
+bool EmulatorBase::serve_alarm(OneWireHub *hub){
+    stat(OWX_STAT_CMD_ALARM);
+    send_alarm(hub);
+    return true;
+}
+
+bool EmulatorBase::serve_stats(OneWireHub *hub){
+    stat(OWX_STAT_CMD_READ_STATS);
+    send_stats(hub);
+    return true;
+}
+
+// Maps a scalar OW_CMD_* data type to its DataType and payload size
+static bool scalar_type_of(uint8_t cmd_data_type, EmulatorBase::DataType &type, uint8_t &len) {
+    switch(cmd_data_type){
+        case OW_CMD_INT8:    type = EmulatorBase::DATA_INT8;    len = 1; return true;
+        case OW_CMD_UINT8:   type = EmulatorBase::DATA_UINT8;   len = 1; return true;
+        case OW_CMD_INT16:   type = EmulatorBase::DATA_INT16;   len = 2; return true;   // LSB first
+        case OW_CMD_UINT16:  type = EmulatorBase::DATA_UINT16;  len = 2; return true;
+        case OW_CMD_INT32:   type = EmulatorBase::DATA_INT32;   len = 4; return true;
+        case OW_CMD_UINT32:  type = EmulatorBase::DATA_UINT32;  len = 4; return true;
+        case OW_CMD_FLOAT32: type = EmulatorBase::DATA_FLOAT32; len = 4; return true;
+        default: return false;
+    }
+}
+
+// Decodes a scalar value and queues it for loop()
+bool EmulatorBase::decode_scalar(
     uint8_t cmd_data_type, const uint8_t *payload, uint8_t len, OneWireHub *hub)
 {
-    bool handled = false;
+    DataType type;
+    uint8_t expected_len;
 
-    switch(cmd_data_type){
-        // --- 8-bit signed ---
-        case OW_CMD_INT8:
-            int8_value = (int8_t)payload[0];
-            lastDataType = DATA_INT8;
-            dataAvailable = true;
-            handled = true;
-            break;
+    // --- Fallback for unknown data types ---
+    if(!scalar_type_of(cmd_data_type, type, expected_len)) return false;
 
-        // --- 8-bit unsigned ---
-        case OW_CMD_UINT8:
-            uint8_value = payload[0];
-            lastDataType = DATA_UINT8;
-            dataAvailable = true;
-            handled = true;
-            break;
+    if(len != expected_len) return reject(hub, cmd_data_type, OW_NACK_LENGTH);
 
-        // --- 16-bit signed ---
-        case OW_CMD_INT16:
-            memcpy(&int16_value, payload, 2);  // Little-endian safe on ESP
-            lastDataType = DATA_INT16;
-            dataAvailable = true;
-            handled = true;
-            break;
+    // Inline subscriber: straight to the application, nothing queued
+    const OWXReceiver *receiver = scalar_receiver(cmd_data_type);
+    if(inlined(receiver)) {
+        (*receiver)(payload);
+        return true;
+    }
 
-        // --- 16-bit unsigned ---
-        case OW_CMD_UINT16:
-            memcpy(&uint16_value, payload, 2);
-            lastDataType = DATA_UINT16;
-            dataAvailable = true;
-            handled = true;
-            break;
+    // Queue full: either make the master retry (NACK BUSY) or accept and discard
+    OWXMessage *msg = rxQueue.reserve();
+    if(msg == nullptr) return refuse_value(hub, cmd_data_type, len);
+
+    msg->type = type;
+    msg->command = cmd_data_type;
+    msg->len = len;
+    msg->value.u32 = 0;
+    memcpy(msg->value.raw, payload, len);
+    msg->timestamp = micros();
+    rxQueue.commit();
+    return true;
+}
 
-        // --- 32-bit signed ---
-        case OW_CMD_INT32:
-            if(len != 4) { 
-                hub->raiseDeviceError(cmd_data_type); 
-                return false; 
-            }
-            memcpy(&int32_value, payload, 4);
-            lastDataType = DATA_INT32;
-            dataAvailable = true;
-            handled = true;
-            break;
+// Adds or replaces the destination for struct ID id
+bool EmulatorBase::register_struct(uint8_t id, void *dest, uint8_t size) {
+    for(uint8_t i = 0; i < structCount; i++) {
+        if(structSlots[i].id == id) {
+            // A callback subscribed for another struct type must not see this one
+            if(structSlots[i].size != size && receivers) struct_receiver(&structSlots[i])->thunk = nullptr;
+            structSlots[i].size = size;
+            structSlots[i].dest = dest;
+            return true;
+        }
+    }
+    if(structCount >= structCapacity) return false;
+
+    structSlots[structCount].id = id;
+    structSlots[structCount].size = size;
+    structSlots[structCount].dest = dest;
+    if(receivers) struct_receiver(&structSlots[structCount])->thunk = nullptr;
+    structSlots[structCount].notified = 0;
+    structSlots[structCount].taken = 0;
+    structCount++;
+    return true;
+}
 
-        // --- 32-bit unsigned ---
-        case OW_CMD_UINT32:
-            if(len != 4) { 
-                hub->raiseDeviceError(cmd_data_type); 
-                return false; 
-            }
-            memcpy(&uint32_value, payload, 4);
-            lastDataType = DATA_UINT32;
-            dataAvailable = true;
-            handled = true;
-            break;
+const EmulatorBase::StructSlot *EmulatorBase::find_struct(uint8_t id) const {
+    for(uint8_t i = 0; i < structCount; i++) {
+        if(structSlots[i].id == id) return &structSlots[i];
+    }
+    return nullptr;
+}
+
+EmulatorBase::StructSlot *EmulatorBase::find_struct(uint8_t id) {
+    for(uint8_t i = 0; i < structCount; i++) {
+        if(structSlots[i].id == id) return &structSlots[i];
+    }
+    return nullptr;
+}
+
+// loop() side: the application is done with the value of struct id, duty() may write it again
+void EmulatorBase::release_struct(uint8_t id) {
+    StructSlot *slot = find_struct(id);
+    if(slot) slot->taken = slot->taken + 1;
+}
+
+// Copies a verified OW_CMD_STRUCT payload (ID + bytes) straight into its registered destination
+bool EmulatorBase::decode_struct(const uint8_t *payload, uint8_t len, OneWireHub *hub) {
+    StructSlot *slot = len ? find_struct(payload[0]) : nullptr;
+
+    if(slot == nullptr) return reject(hub, OW_CMD_STRUCT, OW_NACK_UNKNOWN_ID);
+    if(len != slot->size + 1) return reject(hub, OW_CMD_STRUCT, OW_NACK_LENGTH);
 
-        // --- 32-bit float ---
-        case OW_CMD_FLOAT32:
-            if(len != 4) { 
-                hub->raiseDeviceError(cmd_data_type); 
-                return false; 
+    const OWXReceiver *receiver = struct_receiver(slot);
+    if(inlined(receiver)) {
+        memcpy(slot->dest, payload + 1, slot->size);
+        (*receiver)((const uint8_t *)slot->dest);
+        return true;
+    }
+
+    // The last value is still the application's: overwriting it would tear or skip it
+    if(struct_pending(slot)) return refuse_value(hub, OW_CMD_STRUCT, len);
+
+    // Reserve the notification first so a full queue leaves the destination untouched
+    OWXMessage *msg = rxQueue.reserve();
+    if(msg == nullptr) return refuse_value(hub, OW_CMD_STRUCT, len);
+
+    memcpy(slot->dest, payload + 1, slot->size);
+    slot->notified++;
+
+    msg->type = DATA_STRUCT;
+    msg->command = OW_CMD_STRUCT;
+    msg->len = slot->size;
+    msg->value.u32 = 0;
+    msg->value.raw[0] = slot->id;
+    msg->timestamp = micros();
+    rxQueue.commit();
+    return true;
+}
+
+// Delivers every TLV entry of an OW_CMD_BATCH payload, all or nothing
+bool EmulatorBase::decode_batch(const uint8_t *payload, uint8_t len, OneWireHub *hub, uint16_t type_mask) {
+    // Pass 1: check framing, types and sizes before anything reaches the application
+    uint8_t entries = 0;   // values that need a queue slot (inline subscribers don't)
+    uint16_t structs_seen = 0;
+    bool struct_busy = false;
+    for(uint8_t pos = 0; pos < len;) {
+        if(len - pos < 2 || payload[pos + 1] > len - pos - 2) return reject(hub, OW_CMD_BATCH, OW_NACK_LENGTH);
+
+        uint8_t entry_type = payload[pos];
+        uint8_t entry_len = payload[pos + 1];
+        const uint8_t *value = &payload[pos + 2];
+        DataType type;
+        uint8_t expected_len;
+
+        uint8_t reason = 0;
+        if(!(type_mask & owx_type_bit(entry_type)) || entry_type == OW_CMD_BATCH) {
+            reason = OW_NACK_UNKNOWN_TYPE;
+        } else if(entry_type == OW_CMD_STRUCT) {
+            const StructSlot *slot = entry_len ? find_struct(value[0]) : nullptr;
+            if(slot == nullptr) reason = OW_NACK_UNKNOWN_ID;
+            else if(entry_len != slot->size + 1) reason = OW_NACK_LENGTH;
+            else if(!inlined(struct_receiver(slot))) {
+                // One destination per ID: a second queued value in the same batch would overwrite
+                // the first before loop() saw it, so this batch has to be split
+                const uint16_t bit = (uint16_t)(1u << (slot - structSlots));
+                if(structs_seen & bit) reason = OW_NACK_LENGTH;
+                structs_seen |= bit;
+                struct_busy |= struct_pending(slot);
             }
-            memcpy(&float_value, payload, 4);
-            lastDataType = DATA_FLOAT32;
-            dataAvailable = true;
-            handled = true;
-            break;
+        } else if(!scalar_type_of(entry_type, type, expected_len)) {
+            reason = OW_NACK_UNKNOWN_TYPE;
+        } else if(entry_len != expected_len) {
+            reason = OW_NACK_LENGTH;
+        }
+        if(reason) return reject(hub, OW_CMD_BATCH, reason);
+        if(!receives_inline(entry_type, value)) entries++;
+        pos += 2 + entry_len;
+    }
 
-        // --- Struct parsing not implemented yet ---
-        case OW_CMD_STRUCT:
-            // Reserved for user-defined structured payloads
-            break;
+    // More queued entries than the queue holds would be BUSY forever: the master has to split it
+    if(rxDropPolicy == OW_QUEUE_REJECT && entries > rxQueue.capacity()) return reject(hub, OW_CMD_BATCH, OW_NACK_LENGTH);
 
-        // --- Fallback for custom user handlers ---
-        default:
-            break;
+    // A partly delivered batch would be delivered twice when the master retries it
+    if(rxDropPolicy == OW_QUEUE_REJECT && (struct_busy || rxQueue.capacity() - rxQueue.size() < entries)) {
+        rxOverflows = rxOverflows + 1;
+        stat(OWX_STAT_QUEUE_OVERFLOWS);
+        OWX_TRACE(OWX_TRACE_QUEUE_OVERFLOW, OW_CMD_BATCH, len);
+        return reject(hub, OW_CMD_BATCH, OW_NACK_BUSY);
     }
-    return handled;
 
+    // Pass 2: deliver in order
+    for(uint8_t pos = 0; pos < len; pos += 2 + payload[pos + 1])
+        process_specific_payload_Command(payload[pos], &payload[pos + 2], payload[pos + 1], hub);
+    return true;
+}
+
+// --- Getters for decoded values (oldest queued value, 0 if it has another type) ---
+static const OWXValue *front_of_type(const OWXSpscQueue<OWXMessage, OW_RX_QUEUE_SIZE> &queue, uint8_t type) {
+    const OWXMessage *msg = queue.front();
+    return (msg && msg->type == type) ? &msg->value : nullptr;
 }
-// --- Getters for decoded values ---
-int8_t Emulator::getInt8() const { return int8_value; }
-int16_t Emulator::getInt16() const { return int16_value; }
-uint8_t Emulator::getUInt8() const { return uint8_value; }
-uint16_t Emulator::getUInt16() const { return uint16_value; }
-int32_t Emulator::getInt32() const { return int32_value; }
-uint32_t Emulator::getUInt32() const { return uint32_value; }
-float Emulator::getFloat() const { return float_value; }
+
+int8_t EmulatorBase::getInt8() const { const OWXValue *v = front_of_type(rxQueue, DATA_INT8); return v ? v->i8 : 0; }
+int16_t EmulatorBase::getInt16() const { const OWXValue *v = front_of_type(rxQueue, DATA_INT16); return v ? v->i16 : 0; }
+uint8_t EmulatorBase::getUInt8() const { const OWXValue *v = front_of_type(rxQueue, DATA_UINT8); return v ? v->u8 : 0; }
+uint16_t EmulatorBase::getUInt16() const { const OWXValue *v = front_of_type(rxQueue, DATA_UINT16); return v ? v->u16 : 0; }
+int32_t EmulatorBase::getInt32() const { const OWXValue *v = front_of_type(rxQueue, DATA_INT32); return v ? v->i32 : 0; }
+uint32_t EmulatorBase::getUInt32() const { const OWXValue *v = front_of_type(rxQueue, DATA_UINT32); return v ? v->u32 : 0; }
+float EmulatorBase::getFloat() const { const OWXValue *v = front_of_type(rxQueue, DATA_FLOAT32); return v ? v->f32 : 0.0f; }
+uint8_t EmulatorBase::getStructId() const { const OWXValue *v = front_of_type(rxQueue, DATA_STRUCT); return v ? v->raw[0] : 0; }
+uint8_t EmulatorBase::getArrayId() const { const OWXValue *v = front_of_type(rxQueue, DATA_ARRAY); return v ? v->raw[0] : 0; }
 
 // --- API for checking if data was received ---
-bool Emulator::available() const { return dataAvailable; }
-Emulator::DataType Emulator::availableType() const { return lastDataType; }
-void Emulator::clearAvailable() { dataAvailable = false; lastDataType = DATA_NONE; }
+bool EmulatorBase::available() const { return !rxQueue.empty(); }
+EmulatorBase::DataType EmulatorBase::availableType() const {
+    const OWXMessage *msg = rxQueue.front();
+    return msg ? (DataType)msg->type : DATA_NONE;
+}
+void EmulatorBase::clearAvailable() { pop_value(); }
+
+// Drops the oldest queued value; a struct's destination goes back to duty() after the pop
+void EmulatorBase::pop_value() {
+    const OWXMessage *msg = rxQueue.front();
+    if(msg == nullptr) return;
+    const bool is_struct = msg->type == DATA_STRUCT;
+    const uint8_t id = msg->value.raw[0];
+    rxQueue.pop();
+    if(is_struct) release_struct(id);
+}
 
-// --- Get last received command code ---
-uint8_t Emulator::getLastCommand() const { return lastCommand; }
+// --- Receive queue ---
+bool EmulatorBase::receive(OWXMessage &msg) {
+    if(!rxQueue.pop(msg)) return false;
+    if(msg.type == DATA_STRUCT) release_struct(msg.value.raw[0]);
+    return true;
+}
+uint8_t EmulatorBase::pending() const { return rxQueue.size(); }
+
+// --- Typed receive callbacks ---
+bool EmulatorBase::on_receive(uint8_t cmd, uint8_t id, const OWXReceiver &receiver, uint8_t size) {
+    if(receivers == nullptr) return false;
+    if(cmd != OW_CMD_STRUCT) {
+        receivers[cmd - OW_CMD_UINT8] = receiver;
+        return true;
+    }
+    StructSlot *slot = find_struct(id);
+    if(slot == nullptr || slot->size != size) return false;
+    *struct_receiver(slot) = receiver;
+    return true;
+}
 
-// --- Install user-defined command handler ---
-void Emulator::setCustomHandler(std::function<bool(uint8_t)> handler) { 
-    customHandler = handler; 
+// True if a verified entry goes to an OW_RECEIVE_INLINE callback instead of the receive queue
+bool EmulatorBase::receives_inline(uint8_t cmd, const uint8_t *payload) const {
+    if(cmd == OW_CMD_STRUCT) {
+        const StructSlot *slot = find_struct(payload[0]);
+        return slot && inlined(struct_receiver(slot));
+    }
+    return cmd >= OW_CMD_UINT8 && cmd <= OW_CMD_UINT32 && inlined(scalar_receiver(cmd));
 }
+
+uint8_t EmulatorBase::dispatchPending(uint8_t max_values) {
+    EmulatorBase *outer = engine.device;
+    engine.device = this;
+
+    uint8_t delivered = 0;
+    while(delivered < max_values) {
+        const OWXMessage *msg = rxQueue.front();
+        if(msg == nullptr) break;
+
+        // Scalars carry their value in the message, structs were decoded into their destination
+        const OWXReceiver *receiver = nullptr;
+        const uint8_t *value = nullptr;
+        if(msg->type == DATA_STRUCT) {
+            const StructSlot *slot = find_struct(msg->value.raw[0]);
+            if(slot) {
+                receiver = struct_receiver(slot);
+                value = (const uint8_t *)slot->dest;
+            }
+        } else if(msg->command >= OW_CMD_UINT8 && msg->command <= OW_CMD_UINT32) {
+            receiver = scalar_receiver(msg->command);
+        }
+        if(receiver == nullptr || !receiver->subscribed()) break;
+
+        // Free the slot before the callback so duty() can queue the next value meanwhile;
+        // a struct's destination stays the application's until the callback returned
+        OWXValue copy = msg->value;
+        const bool is_struct = msg->type == DATA_STRUCT;
+        rxQueue.pop();
+        (*receiver)(value ? value : copy.raw);
+        if(is_struct) release_struct(copy.raw[0]);
+        delivered++;
+    }
+
+    engine.device = outer;
+    return delivered;
+}
+void EmulatorBase::setDropPolicy(uint8_t policy) { rxDropPolicy = policy; }
+uint32_t EmulatorBase::overflowCount() const { return rxOverflows; }
+void EmulatorBase::resetOverflowCount() { rxOverflows = 0; }
+
+// --- Get last received command code ---
+uint8_t EmulatorBase::getLastCommand() const { return lastCommand; }
+
+// --- Install user-defined command handlers ---
+// (no-ops in a configuration without OW_FEATURE_HANDLERS)
+void EmulatorBase::setCustomHandler(OWXPlainHandlerFn handler) { if(handlers) handlers->setFallback(OWXHandler::plain(handler)); }
+void EmulatorBase::setCustomHandler(OWXHandlerFn handler, void *context) {
+    OWXHandler h = { handler, context };
+    if(handlers) handlers->setFallback(h);
+}
+bool EmulatorBase::addHandler(uint8_t cmd, OWXPlainHandlerFn handler) { return handlers && handlers->add(cmd, OWXHandler::plain(handler)); }
+bool EmulatorBase::addHandler(uint8_t cmd, OWXHandlerFn handler, void *context) {
+    OWXHandler h = { handler, context };
+    return handlers && handlers->add(cmd, h);
+}
+bool EmulatorBase::removeHandler(uint8_t cmd) { return handlers && handlers->remove(cmd); }
+
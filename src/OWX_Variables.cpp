@@ -0,0 +1,87 @@
+#include <OWX_Slave_Emulator.h>
+#include <Arduino.h>
+
+// Adds or replaces the variable bound to ID id
+bool EmulatorBase::bind_variable(uint8_t id, uint8_t cmd, const volatile void *src, uint8_t size) {
+    if (variables == nullptr) return false;
+    VariableTable::Slot *slots = variables->slots;
+    for (uint8_t i = 0; i < variables->count; i++) {
+        if (slots[i].id == id) {
+            slots[i].cmd = cmd;
+            slots[i].size = size;
+            slots[i].src = src;
+            return true;
+        }
+    }
+    if (variables->count >= OW_MAX_VARIABLES) return false;
+
+    slots[variables->count].id = id;
+    slots[variables->count].cmd = cmd;
+    slots[variables->count].size = size;
+    slots[variables->count].src = src;
+    variables->count++;
+    return true;
+}
+
+bool EmulatorBase::unbindVariable(uint8_t id) {
+    if (variables == nullptr) return false;
+    VariableTable::Slot *slots = variables->slots;
+    for (uint8_t i = 0; i < variables->count; i++) {
+        if (slots[i].id != id) continue;
+        slots[i] = slots[--variables->count];
+        return true;
+    }
+    return false;
+}
+
+// READ_VARIABLES: COUNT + IDs + CRC8 → one data packet per ID
+void EmulatorBase::send_variables(OneWireHub *hub) {
+    uint8_t request[1 + OW_MAX_READ_IDS];
+    uint8_t recv_crc;
+
+    if (hub->recv(request, 1)) {
+        stat(OWX_STAT_TIMEOUTS);
+        return;
+    }
+    const uint8_t count = request[0];
+    if (count == 0 || count > OW_MAX_READ_IDS) {
+        stat(OWX_STAT_OVERSIZE);
+        OWX_TRACE(OWX_TRACE_OVERSIZE, OW_LOW_CMD_READ_VARIABLES, count);
+        hub->raiseDeviceError(OW_LOW_CMD_READ_VARIABLES);
+        return;
+    }
+    if (hub->recv(&request[1], count) || hub->recv(&recv_crc, 1)) {
+        stat(OWX_STAT_TIMEOUTS);
+        return;
+    }
+    if (OWXCrc8::compute(request, 1 + count) != recv_crc) {
+        stat(OWX_STAT_CRC_ERRORS);
+        OWX_TRACE(OWX_TRACE_CRC_ERROR, OW_LOW_CMD_READ_VARIABLES, count);
+        hub->raiseDeviceError(OW_LOW_CMD_READ_VARIABLES);
+        return;
+    }
+
+    for (uint8_t r = 0; r < count; r++) {
+        const uint8_t id = request[1 + r];
+        const VariableTable::Slot *slot = nullptr;
+        for (uint8_t i = 0; i < variables->count; i++) {
+            if (variables->slots[i].id == id) slot = &variables->slots[i];
+        }
+
+        if (slot == nullptr) {
+            OWX_TRACE(OWX_TRACE_VARIABLE_READ, id, 0);
+            send_packet(OW_CMD_NACK, nullptr, 0, hub);
+            continue;
+        }
+
+        // Snapshot first: the frame and its CRC8 must describe the same bytes
+        uint8_t value[OW_MAX_PAYLOAD];
+        uint8_t len = 0;
+        if (slot->cmd == OW_CMD_STRUCT) value[len++] = id;
+        const volatile uint8_t *src = static_cast<const volatile uint8_t *>(slot->src);
+        for (uint8_t i = 0; i < slot->size; i++) value[len++] = src[i];
+
+        OWX_TRACE(OWX_TRACE_VARIABLE_READ, id, slot->size);
+        send_packet(slot->cmd, value, len, hub);
+    }
+}